@@ -28,6 +28,7 @@
 
 #include "cc-bluetooth-panel.h"
 #include "cc-bluetooth-resources.h"
+#include "cc-rfkill-state.h"
 
 
 CC_PANEL_REGISTER (CcBluetoothPanel, cc_bluetooth_panel)
@@ -46,19 +47,16 @@ struct CcBluetoothPanelPrivate {
 	GtkBuilder          *builder;
 	GtkWidget           *stack;
 	GtkWidget           *widget;
-	GCancellable        *cancellable;
 
 	/* Killswitch */
 	GtkWidget           *kill_switch_header;
-	GDBusProxy          *rfkill, *properties;
-	gboolean             airplane_mode;
-	gboolean             bt_airplane_mode;
-	gboolean             hardware_airplane_mode;
-	gboolean             has_airplane_mode;
+	CcRfkillState       *rfkill;
 };
 
 static void cc_bluetooth_panel_finalize (GObject *object);
 static void cc_bluetooth_panel_constructed (GObject *object);
+static void cc_bluetooth_panel_suspend (CcPanel *panel);
+static void cc_bluetooth_panel_resume (CcPanel *panel);
 
 static const char *
 cc_bluetooth_panel_get_help_uri (CcPanel *panel)
@@ -76,6 +74,8 @@ cc_bluetooth_panel_class_init (CcBluetoothPanelClass *klass)
 	object_class->finalize = cc_bluetooth_panel_finalize;
 
 	panel_class->get_help_uri = cc_bluetooth_panel_get_help_uri;
+	panel_class->suspend = cc_bluetooth_panel_suspend;
+	panel_class->resume = cc_bluetooth_panel_resume;
 
 	g_type_class_add_private (klass, sizeof (CcBluetoothPanelPrivate));
 }
@@ -87,10 +87,6 @@ cc_bluetooth_panel_finalize (GObject *object)
 
 	self = CC_BLUETOOTH_PANEL (object);
 
-	g_cancellable_cancel (self->priv->cancellable);
-	g_clear_object (&self->priv->cancellable);
-
-	g_clear_object (&self->priv->properties);
 	g_clear_object (&self->priv->rfkill);
 	g_clear_object (&self->priv->kill_switch_header);
 
@@ -120,14 +116,7 @@ power_callback (GObject          *object,
 
 	state = gtk_switch_get_active (GTK_SWITCH (WID ("switch_bluetooth")));
 	g_debug ("Power switched to %s", state ? "on" : "off");
-	g_dbus_proxy_call (self->priv->properties,
-			   "Set",
-			   g_variant_new_parsed ("('org.gnome.SettingsDaemon.Rfkill', 'BluetoothAirplaneMode', %v)",
-						 g_variant_new_boolean (!state)),
-			   G_DBUS_CALL_FLAGS_NONE,
-			   -1,
-			   self->priv->cancellable,
-			   NULL, NULL);
+	cc_rfkill_state_set_bluetooth_airplane_mode (self->priv->rfkill, !state);
 }
 
 static void
@@ -135,29 +124,44 @@ cc_bluetooth_panel_update_power (CcBluetoothPanel *self)
 {
 	GObject *toggle;
 	gboolean sensitive, powered, change_powered;
+	gboolean airplane_mode, bt_airplane_mode, hardware_airplane_mode, has_airplane_mode;
 	const char *page;
 
+	/* The settings widget is gone while the panel is suspended */
+	if (self->priv->widget == NULL)
+		return;
+
+	airplane_mode = cc_rfkill_state_get_airplane_mode (self->priv->rfkill);
+	bt_airplane_mode = cc_rfkill_state_get_bluetooth_airplane_mode (self->priv->rfkill);
+	hardware_airplane_mode = cc_rfkill_state_get_bluetooth_hardware_airplane_mode (self->priv->rfkill);
+	has_airplane_mode = cc_rfkill_state_get_bluetooth_has_airplane_mode (self->priv->rfkill);
+
 	g_debug ("Updating airplane mode: BluetoothHasAirplaneMode %d, BluetoothHardwareAirplaneMode %d, BluetoothAirplaneMode %d, AirplaneMode %d",
-		 self->priv->has_airplane_mode, self->priv->hardware_airplane_mode, self->priv->bt_airplane_mode, self->priv->airplane_mode);
+		 has_airplane_mode, hardware_airplane_mode, bt_airplane_mode, airplane_mode);
 
 	change_powered = TRUE;
 
-	if (self->priv->has_airplane_mode == FALSE) {
+	if (!cc_rfkill_state_is_ready (self->priv->rfkill)) {
+		g_debug ("Waiting for the airplane mode state");
+		sensitive = FALSE;
+		change_powered = FALSE;
+		page = BLUETOOTH_WORKING_PAGE;
+	} else if (has_airplane_mode == FALSE) {
 		g_debug ("No Bluetooth available");
 		sensitive = FALSE;
 		powered = FALSE;
 		page = BLUETOOTH_NO_DEVICES_PAGE;
-	} else if (self->priv->hardware_airplane_mode) {
+	} else if (hardware_airplane_mode) {
 		g_debug ("Bluetooth is Hard blocked");
 		sensitive = FALSE;
 		powered = FALSE;
 		page = BLUETOOTH_HW_AIRPLANE_PAGE;
-	} else if (self->priv->airplane_mode) {
+	} else if (airplane_mode) {
 		g_debug ("Airplane mode is on, Wi-Fi and Bluetooth are disabled");
 		sensitive = FALSE;
 		powered = FALSE;
 		page = BLUETOOTH_AIRPLANE_PAGE;
-	} else if (self->priv->bt_airplane_mode ||
+	} else if (bt_airplane_mode ||
 		   !bluetooth_settings_widget_get_default_adapter_powered (BLUETOOTH_SETTINGS_WIDGET (self->priv->widget))) {
 		g_debug ("Default adapter is unpowered, but should be available");
 		sensitive = TRUE;
@@ -182,47 +186,12 @@ cc_bluetooth_panel_update_power (CcBluetoothPanel *self)
 	gtk_stack_set_visible_child_name (GTK_STACK (self->priv->stack), page);
 }
 
-static void
-airplane_mode_changed (GDBusProxy       *proxy,
-		       GVariant         *changed_properties,
-		       GStrv             invalidated_properties,
-		       CcBluetoothPanel *self)
-{
-	GVariant *v;
-
-	v = g_dbus_proxy_get_cached_property (self->priv->rfkill, "AirplaneMode");
-	self->priv->airplane_mode = g_variant_get_boolean (v);
-	g_variant_unref (v);
-
-	v = g_dbus_proxy_get_cached_property (self->priv->rfkill, "BluetoothAirplaneMode");
-	self->priv->bt_airplane_mode = g_variant_get_boolean (v);
-	g_variant_unref (v);
-
-	v = g_dbus_proxy_get_cached_property (self->priv->rfkill, "BluetoothHardwareAirplaneMode");
-	self->priv->hardware_airplane_mode = g_variant_get_boolean (v);
-	g_variant_unref (v);
-
-	v = g_dbus_proxy_get_cached_property (self->priv->rfkill, "BluetoothHasAirplaneMode");
-	self->priv->has_airplane_mode = g_variant_get_boolean (v);
-	g_variant_unref (v);
-
-	cc_bluetooth_panel_update_power (self);
-}
-
 static void
 on_airplane_mode_off_clicked (GtkButton        *button,
 			      CcBluetoothPanel *self)
 {
 	g_debug ("Airplane Mode Off clicked, disabling airplane mode");
-	g_dbus_proxy_call (self->priv->rfkill,
-			   "org.freedesktop.DBus.Properties.Set",
-			   g_variant_new_parsed ("('org.gnome.SettingsDaemon.Rfkill',"
-						 "'AirplaneMode', %v)",
-						 g_variant_new_boolean (FALSE)),
-			   G_DBUS_CALL_FLAGS_NONE,
-			   -1,
-			   self->priv->cancellable,
-			   NULL, NULL);
+	cc_rfkill_state_set_airplane_mode (self->priv->rfkill, FALSE);
 }
 
 static void
@@ -288,6 +257,47 @@ panel_changed (GtkWidget        *settings_widget,
 	}
 }
 
+static void
+add_settings_widget (CcBluetoothPanel *self)
+{
+	self->priv->widget = bluetooth_settings_widget_new ();
+	g_signal_connect (G_OBJECT (self->priv->widget), "panel-changed",
+			  G_CALLBACK (panel_changed), self);
+	gtk_stack_add_named (GTK_STACK (self->priv->stack),
+			     self->priv->widget, BLUETOOTH_WORKING_PAGE);
+	gtk_widget_show (self->priv->widget);
+
+	g_signal_connect_swapped (G_OBJECT (self->priv->widget), "adapter-status-changed",
+				  G_CALLBACK (cc_bluetooth_panel_update_power), self);
+}
+
+/* The settings widget keeps the adapter discoverable for as long as it
+ * exists, so it is destroyed while the panel is cached, and created
+ * again when the panel is shown */
+static void
+cc_bluetooth_panel_suspend (CcPanel *panel)
+{
+	CcBluetoothPanel *self = CC_BLUETOOTH_PANEL (panel);
+
+	if (self->priv->widget == NULL)
+		return;
+
+	gtk_widget_destroy (self->priv->widget);
+	self->priv->widget = NULL;
+}
+
+static void
+cc_bluetooth_panel_resume (CcPanel *panel)
+{
+	CcBluetoothPanel *self = CC_BLUETOOTH_PANEL (panel);
+
+	if (self->priv->widget != NULL || self->priv->stack == NULL)
+		return;
+
+	add_settings_widget (self);
+	cc_bluetooth_panel_update_power (self);
+}
+
 static void
 cc_bluetooth_panel_init (CcBluetoothPanel *self)
 {
@@ -307,23 +317,8 @@ cc_bluetooth_panel_init (CcBluetoothPanel *self)
 		return;
 	}
 
-	self->priv->cancellable = g_cancellable_new ();
-
-	/* RFKill */
-	self->priv->rfkill = g_dbus_proxy_new_for_bus_sync (G_BUS_TYPE_SESSION,
-							    G_DBUS_PROXY_FLAGS_NONE,
-							    NULL,
-							    "org.gnome.SettingsDaemon.Rfkill",
-							    "/org/gnome/SettingsDaemon/Rfkill",
-							    "org.gnome.SettingsDaemon.Rfkill",
-							    NULL, NULL);
-	self->priv->properties = g_dbus_proxy_new_for_bus_sync (G_BUS_TYPE_SESSION,
-								G_DBUS_PROXY_FLAGS_NONE,
-								NULL,
-								"org.gnome.SettingsDaemon.Rfkill",
-								"/org/gnome/SettingsDaemon/Rfkill",
-								"org.freedesktop.DBus.Properties",
-								NULL, NULL);
+	/* RFKill, shared with the other panels and set up in the background */
+	self->priv->rfkill = g_object_ref (cc_rfkill_state_get_default ());
 
 	self->priv->stack = gtk_stack_new ();
 	gtk_stack_set_homogeneous (GTK_STACK (self->priv->stack), TRUE);
@@ -332,21 +327,15 @@ cc_bluetooth_panel_init (CcBluetoothPanel *self)
 	add_stack_page (self, _("Airplane Mode is on"), _("Bluetooth is disabled when airplane mode is on."), BLUETOOTH_AIRPLANE_PAGE);
 	add_stack_page (self, _("Hardware Airplane Mode is on"), _("Turn off the Airplane mode switch to enable Bluetooth."), BLUETOOTH_HW_AIRPLANE_PAGE);
 
-	self->priv->widget = bluetooth_settings_widget_new ();
-	g_signal_connect (G_OBJECT (self->priv->widget), "panel-changed",
-			  G_CALLBACK (panel_changed), self);
-	gtk_stack_add_named (GTK_STACK (self->priv->stack),
-			     self->priv->widget, BLUETOOTH_WORKING_PAGE);
-	gtk_widget_show (self->priv->widget);
+	add_settings_widget (self);
 	gtk_widget_show (self->priv->stack);
 
 	gtk_container_add (GTK_CONTAINER (self), self->priv->stack);
 
-	airplane_mode_changed (NULL, NULL, NULL, self);
-	g_signal_connect (self->priv->rfkill, "g-properties-changed",
-			  G_CALLBACK (airplane_mode_changed), self);
-	g_signal_connect_swapped (G_OBJECT (self->priv->widget), "adapter-status-changed",
-				  G_CALLBACK (cc_bluetooth_panel_update_power), self);
+	cc_bluetooth_panel_update_power (self);
+	g_signal_connect_object (self->priv->rfkill, "changed",
+				 G_CALLBACK (cc_bluetooth_panel_update_power), self,
+				 G_CONNECT_SWAPPED);
 
 	g_signal_connect (G_OBJECT (WID ("switch_bluetooth")), "notify::active",
 			  G_CALLBACK (power_callback), self);
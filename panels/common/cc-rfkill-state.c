@@ -0,0 +1,241 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*-
+ *
+ * Copyright (C) 2017 Red Hat, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include "cc-rfkill-state.h"
+
+#define RFKILL_DBUS_NAME      "org.gnome.SettingsDaemon.Rfkill"
+#define RFKILL_DBUS_PATH      "/org/gnome/SettingsDaemon/Rfkill"
+#define RFKILL_DBUS_INTERFACE "org.gnome.SettingsDaemon.Rfkill"
+
+/* The airplane mode state exported by gnome-settings-daemon's rfkill
+ * plugin. The proxy is set up asynchronously, once for the whole
+ * process, and shared by all the panels that show or change it. */
+struct _CcRfkillState
+{
+  GObject parent_instance;
+
+  GDBusProxy *proxy;
+};
+
+enum {
+  CHANGED,
+  LAST_SIGNAL
+};
+
+static guint signals[LAST_SIGNAL] = { 0 };
+
+G_DEFINE_TYPE (CcRfkillState, cc_rfkill_state, G_TYPE_OBJECT)
+
+static void
+emit_changed (CcRfkillState *self)
+{
+  g_signal_emit (self, signals[CHANGED], 0);
+}
+
+static void
+proxy_ready (GObject      *source,
+             GAsyncResult *res,
+             gpointer      user_data)
+{
+  CcRfkillState *self = user_data;
+  GError *error = NULL;
+
+  self->proxy = g_dbus_proxy_new_for_bus_finish (res, &error);
+  if (!self->proxy)
+    {
+      g_warning ("Failed to get the rfkill proxy: %s", error->message);
+      g_error_free (error);
+      return;
+    }
+
+  g_signal_connect_swapped (self->proxy, "g-properties-changed",
+                            G_CALLBACK (emit_changed), self);
+  g_signal_connect_swapped (self->proxy, "notify::g-name-owner",
+                            G_CALLBACK (emit_changed), self);
+
+  emit_changed (self);
+}
+
+static gboolean
+get_boolean (CcRfkillState *self,
+             const gchar   *name)
+{
+  GVariant *v;
+  gboolean value;
+
+  if (!self->proxy)
+    return FALSE;
+
+  v = g_dbus_proxy_get_cached_property (self->proxy, name);
+  if (!v)
+    return FALSE;
+
+  value = g_variant_get_boolean (v);
+  g_variant_unref (v);
+
+  return value;
+}
+
+static void
+set_boolean (CcRfkillState *self,
+             const gchar   *name,
+             gboolean       value)
+{
+  if (!self->proxy)
+    return;
+
+  g_dbus_proxy_call (self->proxy,
+                     "org.freedesktop.DBus.Properties.Set",
+                     g_variant_new_parsed ("(%s, %s, %v)",
+                                           RFKILL_DBUS_INTERFACE, name,
+                                           g_variant_new_boolean (value)),
+                     G_DBUS_CALL_FLAGS_NONE,
+                     -1,
+                     NULL,
+                     NULL, NULL);
+}
+
+static void
+cc_rfkill_state_finalize (GObject *object)
+{
+  CcRfkillState *self = CC_RFKILL_STATE (object);
+
+  g_clear_object (&self->proxy);
+
+  G_OBJECT_CLASS (cc_rfkill_state_parent_class)->finalize (object);
+}
+
+static void
+cc_rfkill_state_class_init (CcRfkillStateClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = cc_rfkill_state_finalize;
+
+  /* Emitted once the state is known, and whenever it changes */
+  signals[CHANGED] =
+    g_signal_new ("changed",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL, NULL,
+                  G_TYPE_NONE, 0);
+}
+
+static void
+cc_rfkill_state_init (CcRfkillState *self)
+{
+  g_dbus_proxy_new_for_bus (G_BUS_TYPE_SESSION,
+                            G_DBUS_PROXY_FLAGS_NONE,
+                            NULL,
+                            RFKILL_DBUS_NAME,
+                            RFKILL_DBUS_PATH,
+                            RFKILL_DBUS_INTERFACE,
+                            NULL,
+                            proxy_ready,
+                            self);
+}
+
+/**
+ * cc_rfkill_state_get_default:
+ *
+ * Returns: (transfer none): the rfkill state shared by the panels. It is
+ * created on first use and never goes away.
+ */
+CcRfkillState *
+cc_rfkill_state_get_default (void)
+{
+  static CcRfkillState *state = NULL;
+
+  if (state == NULL)
+    state = g_object_new (CC_TYPE_RFKILL_STATE, NULL);
+
+  return state;
+}
+
+/* Whether gnome-settings-daemon answered, the getters return FALSE until then */
+gboolean
+cc_rfkill_state_is_ready (CcRfkillState *self)
+{
+  gchar *owner;
+  gboolean ready;
+
+  g_return_val_if_fail (CC_IS_RFKILL_STATE (self), FALSE);
+
+  if (!self->proxy)
+    return FALSE;
+
+  owner = g_dbus_proxy_get_name_owner (self->proxy);
+  ready = (owner != NULL);
+  g_free (owner);
+
+  return ready;
+}
+
+gboolean
+cc_rfkill_state_get_airplane_mode (CcRfkillState *self)
+{
+  g_return_val_if_fail (CC_IS_RFKILL_STATE (self), FALSE);
+
+  return get_boolean (self, "AirplaneMode");
+}
+
+gboolean
+cc_rfkill_state_get_bluetooth_airplane_mode (CcRfkillState *self)
+{
+  g_return_val_if_fail (CC_IS_RFKILL_STATE (self), FALSE);
+
+  return get_boolean (self, "BluetoothAirplaneMode");
+}
+
+gboolean
+cc_rfkill_state_get_bluetooth_hardware_airplane_mode (CcRfkillState *self)
+{
+  g_return_val_if_fail (CC_IS_RFKILL_STATE (self), FALSE);
+
+  return get_boolean (self, "BluetoothHardwareAirplaneMode");
+}
+
+gboolean
+cc_rfkill_state_get_bluetooth_has_airplane_mode (CcRfkillState *self)
+{
+  g_return_val_if_fail (CC_IS_RFKILL_STATE (self), FALSE);
+
+  return get_boolean (self, "BluetoothHasAirplaneMode");
+}
+
+void
+cc_rfkill_state_set_airplane_mode (CcRfkillState *self,
+                                   gboolean       airplane_mode)
+{
+  g_return_if_fail (CC_IS_RFKILL_STATE (self));
+
+  set_boolean (self, "AirplaneMode", airplane_mode);
+}
+
+void
+cc_rfkill_state_set_bluetooth_airplane_mode (CcRfkillState *self,
+                                             gboolean       airplane_mode)
+{
+  g_return_if_fail (CC_IS_RFKILL_STATE (self));
+
+  set_boolean (self, "BluetoothAirplaneMode", airplane_mode);
+}
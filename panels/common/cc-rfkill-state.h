@@ -0,0 +1,45 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*-
+ *
+ * Copyright (C) 2017 Red Hat, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef _CC_RFKILL_STATE_H
+#define _CC_RFKILL_STATE_H
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define CC_TYPE_RFKILL_STATE (cc_rfkill_state_get_type ())
+G_DECLARE_FINAL_TYPE (CcRfkillState, cc_rfkill_state, CC, RFKILL_STATE, GObject)
+
+CcRfkillState *cc_rfkill_state_get_default                          (void);
+
+gboolean       cc_rfkill_state_is_ready                             (CcRfkillState *self);
+gboolean       cc_rfkill_state_get_airplane_mode                    (CcRfkillState *self);
+gboolean       cc_rfkill_state_get_bluetooth_airplane_mode          (CcRfkillState *self);
+gboolean       cc_rfkill_state_get_bluetooth_hardware_airplane_mode (CcRfkillState *self);
+gboolean       cc_rfkill_state_get_bluetooth_has_airplane_mode      (CcRfkillState *self);
+
+void           cc_rfkill_state_set_airplane_mode                    (CcRfkillState *self,
+                                                                     gboolean       airplane_mode);
+void           cc_rfkill_state_set_bluetooth_airplane_mode          (CcRfkillState *self,
+                                                                     gboolean       airplane_mode);
+
+G_END_DECLS
+
+#endif /* _CC_RFKILL_STATE_H */
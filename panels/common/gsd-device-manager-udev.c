@@ -30,7 +30,8 @@
 struct _GsdUdevDeviceManager
 {
 	GsdDeviceManager parent_instance;
-	GHashTable *devices;
+	GHashTable *devices; /* device node path -> GsdDevice */
+	GHashTable *type_lists; /* GsdDeviceType -> GList of GsdDevice */
 	GUdevClient *udev_client;
 };
 
@@ -110,6 +111,9 @@ create_device (GUdevDevice *udev_device)
 	return device;
 }
 
+static void remove_device (GsdUdevDeviceManager *manager,
+			   GUdevDevice		*udev_device);
+
 static void
 add_device (GsdUdevDeviceManager *manager,
 	    GUdevDevice		 *udev_device)
@@ -122,8 +126,17 @@ add_device (GsdUdevDeviceManager *manager,
 	if (!parent)
 		return;
 
+	g_object_unref (parent);
+
+	/* Coldplug can race with the uevent for the same node, and uevents
+	 * may be replayed, so let go of a device already known for it */
+	remove_device (manager, udev_device);
+
 	device = create_device (udev_device);
-	g_hash_table_insert (manager->devices, g_object_ref (udev_device), device);
+	g_hash_table_insert (manager->devices,
+			     g_strdup (g_udev_device_get_device_file (udev_device)),
+			     device);
+	g_hash_table_remove_all (manager->type_lists);
 	g_signal_emit_by_name (manager, "device-added", device);
 }
 
@@ -131,18 +144,24 @@ static void
 remove_device (GsdUdevDeviceManager *manager,
 	       GUdevDevice	    *udev_device)
 {
+	const gchar *device_file;
+	gchar *node_path;
 	GsdDevice *device;
 
-	device = g_hash_table_lookup (manager->devices, udev_device);
+	/* Each uevent carries a new GUdevDevice, so match on the node */
+	device_file = g_udev_device_get_device_file (udev_device);
 
-	if (!device)
+	if (!g_hash_table_lookup_extended (manager->devices, device_file,
+					   (gpointer *) &node_path,
+					   (gpointer *) &device))
 		return;
 
-	g_hash_table_steal (manager->devices, udev_device);
+	g_hash_table_steal (manager->devices, device_file);
+	g_hash_table_remove_all (manager->type_lists);
 	g_signal_emit_by_name (manager, "device-removed", device);
 
 	g_object_unref (device);
-	g_object_unref (udev_device);
+	g_free (node_path);
 }
 
 static void
@@ -167,9 +186,11 @@ gsd_udev_device_manager_init (GsdUdevDeviceManager *manager)
 	const gchar *subsystems[] = { "input", NULL };
 	GList *devices, *l;
 
-	manager->devices = g_hash_table_new_full (NULL, NULL,
-						  (GDestroyNotify) g_object_unref,
+	manager->devices = g_hash_table_new_full (g_str_hash, g_str_equal,
+						  g_free,
 						  (GDestroyNotify) g_object_unref);
+	manager->type_lists = g_hash_table_new_full (NULL, NULL, NULL,
+						     (GDestroyNotify) g_list_free);
 
 	manager->udev_client = g_udev_client_new (subsystems);
 	g_signal_connect (manager->udev_client, "uevent",
@@ -195,6 +216,7 @@ gsd_udev_device_manager_finalize (GObject *object)
 {
 	GsdUdevDeviceManager *manager = GSD_UDEV_DEVICE_MANAGER (object);
 
+	g_hash_table_destroy (manager->type_lists);
 	g_hash_table_destroy (manager->devices);
 	g_object_unref (manager->udev_client);
 
@@ -211,6 +233,12 @@ gsd_udev_device_manager_list_devices (GsdDeviceManager *manager,
 	GHashTableIter iter;
 	GsdDevice *device;
 
+	/* The lists are dropped whenever a device comes or goes */
+	if (g_hash_table_lookup_extended (manager_udev->type_lists,
+					  GUINT_TO_POINTER (type),
+					  NULL, (gpointer *) &devices))
+		return g_list_copy (devices);
+
 	g_hash_table_iter_init (&iter, manager_udev->devices);
 
 	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &device)) {
@@ -220,7 +248,10 @@ gsd_udev_device_manager_list_devices (GsdDeviceManager *manager,
 			devices = g_list_prepend (devices, device);
 	}
 
-	return devices;
+	g_hash_table_insert (manager_udev->type_lists,
+			     GUINT_TO_POINTER (type), devices);
+
+	return g_list_copy (devices);
 }
 
 static GsdDevice *
@@ -228,23 +259,13 @@ gsd_udev_device_manager_lookup_device (GsdDeviceManager *manager,
 				       GdkDevice	*gdk_device)
 {
 	const gchar *node_path;
-	GHashTableIter iter;
-	GsdDevice *device;
 
 	node_path = gdk_wayland_device_get_node_path (gdk_device);
 	if (!node_path)
 		return NULL;
 
-	g_hash_table_iter_init (&iter, GSD_UDEV_DEVICE_MANAGER (manager)->devices);
-
-	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &device)) {
-		if (g_strcmp0 (node_path,
-			       gsd_device_get_device_file (device)) == 0) {
-			return device;
-		}
-	}
-
-	return NULL;
+	return g_hash_table_lookup (GSD_UDEV_DEVICE_MANAGER (manager)->devices,
+				    node_path);
 }
 
 static void
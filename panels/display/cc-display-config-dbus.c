@@ -33,6 +33,10 @@
 
 #define CURRENT_STATE_FORMAT "(u" MONITORS_FORMAT LOGICAL_MONITORS_FORMAT "ad" "a{sv})"
 
+/* Mode dimensions are bounded well below 2^16 by every display server, so
+ * a resolution fits in a single pointer-sized hash key. */
+#define RESOLUTION_KEY(w, h) GUINT_TO_POINTER (((guint) (w) << 16) | ((guint) (h) & 0xffff))
+
 typedef enum _CcDisplayModeFlags
 {
   MODE_PREFERRED = 1 << 0,
@@ -234,6 +238,8 @@ struct _CcDisplayMonitorDBus
   int max_height;
 
   GList *modes;
+  /* resolution key -> GPtrArray of modes sorted by decreasing refresh rate */
+  GHashTable *modes_by_resolution;
   CcDisplayMode *current_mode;
   CcDisplayMode *preferred_mode;
 
@@ -532,36 +538,40 @@ cc_display_monitor_dbus_set_underscanning (CcDisplayMonitor *pself,
     self->underscanning = UNDERSCANNING_DISABLED;
 }
 
+static GPtrArray *
+cc_display_monitor_dbus_lookup_resolution (CcDisplayMonitorDBus *self,
+                                           int width,
+                                           int height)
+{
+  return g_hash_table_lookup (self->modes_by_resolution,
+                              RESOLUTION_KEY (width, height));
+}
+
 static CcDisplayMode *
 cc_display_monitor_dbus_get_closest_mode (CcDisplayMonitorDBus *self,
                                           CcDisplayModeDBus *mode)
 {
-  CcDisplayModeDBus *best = NULL;
-  GList *l;
+  GPtrArray *similar;
+  guint i;
 
-  for (l = self->modes; l != NULL; l = l->next)
-    {
-      CcDisplayModeDBus *similar = l->data;
+  similar = cc_display_monitor_dbus_lookup_resolution (self, mode->width, mode->height);
+  if (!similar)
+    return NULL;
 
-      if (similar->width != mode->width ||
-          similar->height != mode->height)
-        continue;
+  for (i = 0; i < similar->len; i++)
+    {
+      CcDisplayModeDBus *candidate = g_ptr_array_index (similar, i);
 
-      if (similar->refresh_rate == mode->refresh_rate)
-        {
-          best = similar;
-          break;
-        }
+      if (candidate->refresh_rate == mode->refresh_rate)
+        return CC_DISPLAY_MODE (candidate);
 
-      /* There might be a better heuristic. */
-      if (!best || best->refresh_rate < similar->refresh_rate)
-        {
-          best = similar;
-          continue;
-        }
+      /* Sorted by decreasing refresh rate, so nothing further can match. */
+      if (candidate->refresh_rate < mode->refresh_rate)
+        break;
     }
 
-  return CC_DISPLAY_MODE (best);
+  /* There might be a better heuristic. */
+  return CC_DISPLAY_MODE (g_ptr_array_index (similar, 0));
 }
 
 static void
@@ -644,6 +654,8 @@ cc_display_monitor_dbus_init (CcDisplayMonitorDBus *self)
   self->underscanning = UNDERSCANNING_UNSUPPORTED;
   self->max_width = G_MAXINT;
   self->max_height = G_MAXINT;
+  self->modes_by_resolution = g_hash_table_new_full (NULL, NULL, NULL,
+                                                     (GDestroyNotify) g_ptr_array_unref);
 }
 
 static void
@@ -657,6 +669,7 @@ cc_display_monitor_dbus_finalize (GObject *object)
   g_free (self->product_serial);
   g_free (self->display_name);
 
+  g_clear_pointer (&self->modes_by_resolution, g_hash_table_destroy);
   g_list_foreach (self->modes, (GFunc) g_object_unref, NULL);
   g_clear_pointer (&self->modes, g_list_free);
 
@@ -702,6 +715,48 @@ cc_display_monitor_dbus_class_init (CcDisplayMonitorDBusClass *klass)
   parent_class->set_scale = cc_display_monitor_dbus_set_scale;
 }
 
+static gint
+sort_modes_by_refresh_rate_desc (gconstpointer a,
+                                 gconstpointer b)
+{
+  const CcDisplayModeDBus *mode_a = *(CcDisplayModeDBus * const *) a;
+  const CcDisplayModeDBus *mode_b = *(CcDisplayModeDBus * const *) b;
+
+  if (mode_a->refresh_rate > mode_b->refresh_rate)
+    return -1;
+  if (mode_a->refresh_rate < mode_b->refresh_rate)
+    return 1;
+  return 0;
+}
+
+static void
+index_modes (CcDisplayMonitorDBus *self)
+{
+  GHashTableIter iter;
+  GPtrArray *similar;
+  GList *l;
+
+  for (l = self->modes; l != NULL; l = l->next)
+    {
+      CcDisplayModeDBus *mode = l->data;
+      gpointer key = RESOLUTION_KEY (mode->width, mode->height);
+
+      similar = g_hash_table_lookup (self->modes_by_resolution, key);
+      if (!similar)
+        {
+          similar = g_ptr_array_new ();
+          g_hash_table_insert (self->modes_by_resolution, key, similar);
+        }
+      g_ptr_array_add (similar, mode);
+    }
+
+  /* The sort is stable, so among modes with the same refresh rate the
+   * first one in the modes list still wins. */
+  g_hash_table_iter_init (&iter, self->modes_by_resolution);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &similar))
+    g_ptr_array_sort (similar, sort_modes_by_refresh_rate_desc);
+}
+
 static void
 construct_modes (CcDisplayMonitorDBus *self,
                  GVariantIter *modes)
@@ -721,6 +776,8 @@ construct_modes (CcDisplayMonitorDBus *self,
 
       g_variant_unref (variant);
     }
+
+  index_modes (self);
 }
 
 static CcDisplayMonitorDBus *
@@ -815,11 +872,20 @@ struct _CcDisplayConfigDBus
   GArray *supported_scales;
 
   GList *monitors;
+  GHashTable *monitors_by_connector;
   CcDisplayMonitorDBus *primary;
 
   GHashTable *logical_monitors;
 
   GList *clone_modes;
+
+  /* Only one verification is in flight at a time; requests made meanwhile
+   * are coalesced so that only the latest one gets verified next. */
+  GTask *verify_task;
+  GTask *verify_pending;
+  /* checksum of the ApplyMonitorsConfig parameters -> NULL if the
+   * configuration verified fine, or the error message otherwise */
+  GHashTable *verify_results;
 };
 
 G_DEFINE_TYPE (CcDisplayConfigDBus,
@@ -915,21 +981,48 @@ build_apply_parameters (CcDisplayConfigDBus *self,
                         g_variant_builder_end (&props_builder));
 }
 
+static GVariant *
+prepare_apply_parameters (CcDisplayConfigDBus    *self,
+                          CcDisplayConfigMethod   method)
+{
+  cc_display_config_dbus_ensure_non_offset_coords (self);
+
+  return g_variant_ref_sink (build_apply_parameters (self, method));
+}
+
+static void
+call_apply_monitors_config (CcDisplayConfigDBus *self,
+                            GVariant            *parameters,
+                            GAsyncReadyCallback  callback,
+                            gpointer             user_data)
+{
+  g_dbus_connection_call (self->connection,
+                          "org.gnome.Mutter.DisplayConfig",
+                          "/org/gnome/Mutter/DisplayConfig",
+                          "org.gnome.Mutter.DisplayConfig",
+                          "ApplyMonitorsConfig",
+                          parameters,
+                          NULL,
+                          G_DBUS_CALL_FLAGS_NO_AUTO_START,
+                          -1,
+                          NULL,
+                          callback,
+                          user_data);
+}
+
 static gboolean
-config_apply (CcDisplayConfigDBus *self,
-              CcDisplayConfigMethod method,
-              GError **error)
+call_apply_monitors_config_sync (CcDisplayConfigDBus  *self,
+                                 GVariant             *parameters,
+                                 GError              **error)
 {
   GVariant *retval;
 
-  cc_display_config_dbus_ensure_non_offset_coords (self);
-
   retval = g_dbus_connection_call_sync (self->connection,
                                         "org.gnome.Mutter.DisplayConfig",
                                         "/org/gnome/Mutter/DisplayConfig",
                                         "org.gnome.Mutter.DisplayConfig",
                                         "ApplyMonitorsConfig",
-                                        build_apply_parameters (self, method),
+                                        parameters,
                                         NULL,
                                         G_DBUS_CALL_FLAGS_NO_AUTO_START,
                                         -1,
@@ -942,22 +1035,235 @@ config_apply (CcDisplayConfigDBus *self,
   return TRUE;
 }
 
+static gboolean
+config_apply (CcDisplayConfigDBus *self,
+              CcDisplayConfigMethod method,
+              GError **error)
+{
+  GVariant *parameters;
+  gboolean ret;
+
+  parameters = prepare_apply_parameters (self, method);
+  ret = call_apply_monitors_config_sync (self, parameters, error);
+  g_variant_unref (parameters);
+
+  return ret;
+}
+
+static gchar *
+get_verify_key (GVariant *parameters)
+{
+  GBytes *bytes;
+  gchar *key;
+
+  bytes = g_variant_get_data_as_bytes (parameters);
+  key = g_compute_checksum_for_bytes (G_CHECKSUM_SHA1, bytes);
+  g_bytes_unref (bytes);
+
+  return key;
+}
+
+static gboolean
+lookup_verify_result (CcDisplayConfigDBus  *self,
+                      const gchar          *key,
+                      GError              **error)
+{
+  const gchar *message;
+
+  if (!g_hash_table_lookup_extended (self->verify_results, key,
+                                     NULL, (gpointer *) &message))
+    return FALSE;
+
+  if (message)
+    g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED, message);
+
+  return TRUE;
+}
+
+static void
+store_verify_result (CcDisplayConfigDBus *self,
+                     const gchar         *key,
+                     const GError        *error)
+{
+  /* Only remember mutter's verdict, not transport failures */
+  if (error &&
+      !g_error_matches (error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS) &&
+      !g_error_matches (error, G_DBUS_ERROR, G_DBUS_ERROR_ACCESS_DENIED) &&
+      !g_dbus_error_is_remote_error (error))
+    return;
+
+  g_hash_table_insert (self->verify_results,
+                       g_strdup (key),
+                       error ? g_strdup (error->message) : NULL);
+}
+
 static gboolean
 cc_display_config_dbus_is_applicable (CcDisplayConfig *pself)
 {
   CcDisplayConfigDBus *self = CC_DISPLAY_CONFIG_DBUS (pself);
+  GVariant *parameters;
   GError *error = NULL;
+  gchar *key;
+
+  parameters = prepare_apply_parameters (self, CC_DISPLAY_CONFIG_METHOD_VERIFY);
+  key = get_verify_key (parameters);
+
+  if (!lookup_verify_result (self, key, &error))
+    {
+      call_apply_monitors_config_sync (self, parameters, &error);
+      store_verify_result (self, key, error);
+    }
+
+  g_free (key);
+  g_variant_unref (parameters);
 
-  if (!config_apply (self, CC_DISPLAY_CONFIG_METHOD_VERIFY, &error))
+  if (error)
     {
       g_warning ("Config not applicable: %s", error->message);
       g_error_free (error);
       return FALSE;
     }
+
+  return TRUE;
+}
+
+static void verify_start (CcDisplayConfigDBus *self,
+                          GTask               *task);
+
+static void
+verify_next (CcDisplayConfigDBus *self)
+{
+  GTask *task;
+
+  while (!self->verify_task && self->verify_pending)
+    {
+      task = self->verify_pending;
+      self->verify_pending = NULL;
+      verify_start (self, task);
+    }
+}
+
+static void
+verify_return (GTask  *task,
+               GError *error)
+{
+  if (error)
+    g_task_return_error (task, error);
+  else
+    g_task_return_boolean (task, TRUE);
+  g_object_unref (task);
+}
+
+static void
+verify_done (GObject      *source,
+             GAsyncResult *res,
+             gpointer      user_data)
+{
+  GTask *task = user_data;
+  CcDisplayConfigDBus *self = g_task_get_source_object (task);
+  GError *error = NULL;
+  GVariant *retval;
+
+  retval = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source), res, &error);
+  if (retval)
+    g_variant_unref (retval);
+
+  store_verify_result (self, g_task_get_task_data (task), error);
+
+  /* The pending task holds its own reference on self */
+  self->verify_task = NULL;
+  verify_next (self);
+
+  verify_return (task, error);
+}
+
+static void
+verify_start (CcDisplayConfigDBus *self,
+              GTask               *task)
+{
+  GVariant *parameters;
+  GError *error = NULL;
+  gchar *key;
+
+  if (g_task_return_error_if_cancelled (task))
+    {
+      g_object_unref (task);
+      return;
+    }
+
+  /* Serialize the configuration as it is now, not as it was when the
+   * request was made, so that coalesced requests verify the latest one. */
+  parameters = prepare_apply_parameters (self, CC_DISPLAY_CONFIG_METHOD_VERIFY);
+  key = get_verify_key (parameters);
+
+  if (lookup_verify_result (self, key, &error))
+    {
+      g_free (key);
+      verify_return (task, error);
+    }
   else
     {
-      return TRUE;
+      g_task_set_task_data (task, key, g_free);
+      self->verify_task = task;
+      call_apply_monitors_config (self, parameters, verify_done, task);
     }
+
+  g_variant_unref (parameters);
+}
+
+static void
+cc_display_config_dbus_is_applicable_async (CcDisplayConfig     *pself,
+                                            GCancellable        *cancellable,
+                                            GAsyncReadyCallback  callback,
+                                            gpointer             user_data)
+{
+  CcDisplayConfigDBus *self = CC_DISPLAY_CONFIG_DBUS (pself);
+  GTask *task;
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, cc_display_config_dbus_is_applicable_async);
+
+  if (self->verify_pending)
+    verify_return (self->verify_pending,
+                   g_error_new_literal (G_IO_ERROR, G_IO_ERROR_CANCELLED,
+                                        "Superseded by a newer request"));
+  self->verify_pending = task;
+
+  verify_next (self);
+}
+
+static void
+apply_done (GObject      *source,
+            GAsyncResult *res,
+            gpointer      user_data)
+{
+  GTask *task = user_data;
+  GError *error = NULL;
+  GVariant *retval;
+
+  retval = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source), res, &error);
+  if (retval)
+    g_variant_unref (retval);
+
+  verify_return (task, error);
+}
+
+static void
+cc_display_config_dbus_apply_async (CcDisplayConfig     *pself,
+                                    GCancellable        *cancellable,
+                                    GAsyncReadyCallback  callback,
+                                    gpointer             user_data)
+{
+  CcDisplayConfigDBus *self = CC_DISPLAY_CONFIG_DBUS (pself);
+  GVariant *parameters;
+  GTask *task;
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, cc_display_config_dbus_apply_async);
+
+  parameters = prepare_apply_parameters (self, CC_DISPLAY_CONFIG_METHOD_PERSISTENT);
+  call_apply_monitors_config (self, parameters, apply_done, task);
+  g_variant_unref (parameters);
 }
 
 static CcDisplayMonitorDBus *
@@ -967,16 +1273,15 @@ monitor_from_spec (CcDisplayConfigDBus *self,
                    const gchar *product,
                    const gchar *serial)
 {
-  GList *l;
-  for (l = self->monitors; l != NULL; l = l->next)
-    {
-      CcDisplayMonitorDBus *m = l->data;
-      if (g_str_equal (m->connector_name, connector) &&
-          g_str_equal (m->vendor_name, vendor) &&
-          g_str_equal (m->product_name, product) &&
-          g_str_equal (m->product_serial, serial))
-        return m;
-    }
+  CcDisplayMonitorDBus *m;
+
+  /* Connector names are unique within a configuration */
+  m = g_hash_table_lookup (self->monitors_by_connector, connector);
+  if (m &&
+      g_str_equal (m->vendor_name, vendor) &&
+      g_str_equal (m->product_name, product) &&
+      g_str_equal (m->product_serial, serial))
+    return m;
   return NULL;
 }
 
@@ -1140,6 +1445,9 @@ cc_display_config_dbus_init (CcDisplayConfigDBus *self)
   self->layout_mode = CC_DISPLAY_LAYOUT_MODE_LOGICAL;
   self->supported_scales = g_array_new (TRUE, TRUE, sizeof (double));
   self->logical_monitors = g_hash_table_new (NULL, NULL);
+  self->monitors_by_connector = g_hash_table_new (g_str_hash, g_str_equal);
+  self->verify_results = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                g_free, g_free);
 }
 
 static void
@@ -1161,7 +1469,9 @@ gather_clone_modes (CcDisplayConfigDBus *self)
       for (ll = self->monitors->next; ll != NULL; ll = ll->next)
         {
           CcDisplayMonitorDBus *other_monitor = ll->data;
-          if (!cc_display_monitor_dbus_get_closest_mode (other_monitor, mode))
+          if (!cc_display_monitor_dbus_lookup_resolution (other_monitor,
+                                                          mode->width,
+                                                          mode->height))
             {
               valid = FALSE;
               break;
@@ -1203,6 +1513,8 @@ construct_monitors (CcDisplayConfigDBus *self,
 
       monitor = cc_display_monitor_dbus_new (variant, self);
       self->monitors = g_list_prepend (self->monitors, monitor);
+      g_hash_table_insert (self->monitors_by_connector,
+                           monitor->connector_name, monitor);
 
       g_variant_unref (variant);
     }
@@ -1365,10 +1677,12 @@ cc_display_config_dbus_finalize (GObject *object)
   g_clear_object (&self->connection);
 
   g_array_free (self->supported_scales, TRUE);
+  g_clear_pointer (&self->monitors_by_connector, g_hash_table_destroy);
   g_list_foreach (self->monitors, (GFunc) g_object_unref, NULL);
   g_clear_pointer (&self->monitors, g_list_free);
   g_clear_pointer (&self->logical_monitors, g_hash_table_destroy);
   g_clear_pointer (&self->clone_modes, g_list_free);
+  g_clear_pointer (&self->verify_results, g_hash_table_destroy);
 
   G_OBJECT_CLASS (cc_display_config_dbus_parent_class)->finalize (object);
 }
@@ -1387,8 +1701,10 @@ cc_display_config_dbus_class_init (CcDisplayConfigDBusClass *klass)
 
   parent_class->get_monitors = cc_display_config_dbus_get_monitors;
   parent_class->is_applicable = cc_display_config_dbus_is_applicable;
+  parent_class->is_applicable_async = cc_display_config_dbus_is_applicable_async;
   parent_class->equal = cc_display_config_dbus_equal;
   parent_class->apply = cc_display_config_dbus_apply;
+  parent_class->apply_async = cc_display_config_dbus_apply_async;
   parent_class->is_cloning = cc_display_config_dbus_is_cloning;
   parent_class->set_cloning = cc_display_config_dbus_set_cloning;
   parent_class->get_cloning_modes = cc_display_config_dbus_get_cloning_modes;
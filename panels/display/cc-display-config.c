@@ -222,9 +222,46 @@ cc_display_config_init (CcDisplayConfig *self)
 {
 }
 
+/* Fallbacks for backends that can only verify and apply synchronously */
+static void
+cc_display_config_real_is_applicable_async (CcDisplayConfig     *self,
+                                            GCancellable        *cancellable,
+                                            GAsyncReadyCallback  callback,
+                                            gpointer             user_data)
+{
+  GTask *task;
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  if (CC_DISPLAY_CONFIG_GET_CLASS (self)->is_applicable (self))
+    g_task_return_boolean (task, TRUE);
+  else
+    g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED,
+                             "Configuration is not applicable");
+  g_object_unref (task);
+}
+
+static void
+cc_display_config_real_apply_async (CcDisplayConfig     *self,
+                                    GCancellable        *cancellable,
+                                    GAsyncReadyCallback  callback,
+                                    gpointer             user_data)
+{
+  GTask *task;
+  GError *error = NULL;
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  if (CC_DISPLAY_CONFIG_GET_CLASS (self)->apply (self, &error))
+    g_task_return_boolean (task, TRUE);
+  else
+    g_task_return_error (task, error);
+  g_object_unref (task);
+}
+
 static void
 cc_display_config_class_init (CcDisplayConfigClass *klass)
 {
+  klass->is_applicable_async = cc_display_config_real_is_applicable_async;
+  klass->apply_async = cc_display_config_real_apply_async;
 }
 
 GList *
@@ -239,6 +276,31 @@ cc_display_config_is_applicable (CcDisplayConfig *self)
   return CC_DISPLAY_CONFIG_GET_CLASS (self)->is_applicable (self);
 }
 
+/*
+ * Checks asynchronously whether the configuration could be applied. Backends
+ * may coalesce overlapping requests, in which case superseded ones finish with
+ * G_IO_ERROR_CANCELLED.
+ */
+void
+cc_display_config_is_applicable_async (CcDisplayConfig     *self,
+                                       GCancellable        *cancellable,
+                                       GAsyncReadyCallback  callback,
+                                       gpointer             user_data)
+{
+  CC_DISPLAY_CONFIG_GET_CLASS (self)->is_applicable_async (self, cancellable,
+                                                           callback, user_data);
+}
+
+gboolean
+cc_display_config_is_applicable_finish (CcDisplayConfig  *self,
+                                        GAsyncResult     *result,
+                                        GError          **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, self), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
 gboolean
 cc_display_config_equal (CcDisplayConfig *self,
                          CcDisplayConfig *other)
@@ -253,6 +315,26 @@ cc_display_config_apply (CcDisplayConfig *self,
   return CC_DISPLAY_CONFIG_GET_CLASS (self)->apply (self, error);
 }
 
+void
+cc_display_config_apply_async (CcDisplayConfig     *self,
+                               GCancellable        *cancellable,
+                               GAsyncReadyCallback  callback,
+                               gpointer             user_data)
+{
+  CC_DISPLAY_CONFIG_GET_CLASS (self)->apply_async (self, cancellable,
+                                                   callback, user_data);
+}
+
+gboolean
+cc_display_config_apply_finish (CcDisplayConfig  *self,
+                                GAsyncResult     *result,
+                                GError          **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, self), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
 gboolean
 cc_display_config_is_cloning (CcDisplayConfig *self)
 {
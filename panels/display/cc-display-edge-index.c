@@ -0,0 +1,354 @@
+/*
+ * Copyright (C) 2017  Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "cc-display-edge-index.h"
+
+typedef struct Edge
+{
+  int x1, y1;
+  int x2, y2;
+} Edge;
+
+typedef struct Snap
+{
+  int dy, dx;
+} Snap;
+
+struct _CcDisplayEdgeIndex
+{
+  GdkRectangle *rects;
+  guint         n_rects;
+  guint         moving;
+
+  /* Edges of the monitors that are not being moved */
+  GArray       *edges;
+
+  /* Whether each monitor is aligned with another one that is not being
+   * moved, and whether any two of those overlap */
+  gboolean     *static_aligned;
+  gboolean      static_overlap;
+
+  /* Reused for every motion, to avoid reallocating */
+  GArray       *snaps;
+};
+
+static void
+add_edge (int x1, int y1, int x2, int y2, GArray *edges)
+{
+  Edge e;
+
+  e.x1 = x1;
+  e.x2 = x2;
+  e.y1 = y1;
+  e.y2 = y2;
+
+  g_array_append_val (edges, e);
+}
+
+static void
+list_edges_for_rect (const GdkRectangle *r, GArray *edges)
+{
+  /* Top, Bottom, Left, Right */
+  add_edge (r->x, r->y, r->x + r->width, r->y, edges);
+  add_edge (r->x, r->y + r->height, r->x + r->width, r->y + r->height, edges);
+  add_edge (r->x, r->y, r->x, r->y + r->height, edges);
+  add_edge (r->x + r->width, r->y, r->x + r->width, r->y + r->height, edges);
+}
+
+static gboolean
+overlap (int s1, int e1, int s2, int e2)
+{
+  return (!(e1 < s2 || s1 >= e2));
+}
+
+static gboolean
+horizontal_overlap (const Edge *snapper, const Edge *snappee)
+{
+  if (snapper->y1 != snapper->y2 || snappee->y1 != snappee->y2)
+    return FALSE;
+
+  return overlap (snapper->x1, snapper->x2, snappee->x1, snappee->x2);
+}
+
+static gboolean
+vertical_overlap (const Edge *snapper, const Edge *snappee)
+{
+  if (snapper->x1 != snapper->x2 || snappee->x1 != snappee->x2)
+    return FALSE;
+
+  return overlap (snapper->y1, snapper->y2, snappee->y1, snappee->y2);
+}
+
+static void
+add_snap (GArray *snaps, int dx, int dy)
+{
+  Snap snap;
+
+  if (ABS (dx) <= 200 || ABS (dy) <= 200)
+    {
+      snap.dx = dx;
+      snap.dy = dy;
+      g_array_append_val (snaps, snap);
+    }
+}
+
+static void
+add_edge_snaps (const Edge *snapper, const Edge *snappee, GArray *snaps)
+{
+  if (horizontal_overlap (snapper, snappee))
+    add_snap (snaps, 0, snappee->y1 - snapper->y1);
+  else if (vertical_overlap (snapper, snappee))
+    add_snap (snaps, snappee->x1 - snapper->x1, 0);
+
+  /* Corner snaps */
+  /* 1->1 */
+  add_snap (snaps, snappee->x1 - snapper->x1, snappee->y1 - snapper->y1);
+
+  /* 1->2 */
+  add_snap (snaps, snappee->x2 - snapper->x1, snappee->y2 - snapper->y1);
+
+  /* 2->2 */
+  add_snap (snaps, snappee->x2 - snapper->x2, snappee->y2 - snapper->y2);
+
+  /* 2->1 */
+  add_snap (snaps, snappee->x1 - snapper->x2, snappee->y1 - snapper->y2);
+}
+
+static gboolean
+is_corner_snap (const Snap *s)
+{
+  return s->dx != 0 && s->dy != 0;
+}
+
+static int
+compare_snaps (gconstpointer v1, gconstpointer v2)
+{
+  const Snap *s1 = v1;
+  const Snap *s2 = v2;
+  int sv1 = MAX (ABS (s1->dx), ABS (s1->dy));
+  int sv2 = MAX (ABS (s2->dx), ABS (s2->dy));
+  int d;
+
+  d = sv1 - sv2;
+
+  /* This snapping algorithm is good enough for rock'n'roll, but
+   * this is probably a better:
+   *
+   *    First do a horizontal/vertical snap, then
+   *    with the new coordinates from that snap,
+   *    do a corner snap.
+   *
+   * Right now, it's confusing that corner snapping
+   * depends on the distance in an axis that you can't actually see.
+   *
+   */
+  if (d == 0)
+    {
+      if (is_corner_snap (s1) && !is_corner_snap (s2))
+        return -1;
+      else if (is_corner_snap (s2) && !is_corner_snap (s1))
+        return 1;
+      else
+        return 0;
+    }
+  else
+    {
+      return d;
+    }
+}
+
+static gboolean
+corner_on_rect (int x, int y, const GdkRectangle *r)
+{
+  gboolean in_x = (x >= r->x && x <= r->x + r->width);
+  gboolean in_y = (y >= r->y && y <= r->y + r->height);
+
+  /* Top or bottom edge */
+  if ((y == r->y || y == r->y + r->height) && in_x)
+    return TRUE;
+
+  /* Left or right edge */
+  if ((x == r->x || x == r->x + r->width) && in_y)
+    return TRUE;
+
+  return FALSE;
+}
+
+/* Two monitors are aligned if the start corner of an edge of one is on an
+ * edge of the other, the start corners being the top-left, bottom-left and
+ * top-right ones. */
+static gboolean
+rects_aligned (const GdkRectangle *a, const GdkRectangle *b)
+{
+  return corner_on_rect (a->x, a->y, b) ||
+         corner_on_rect (a->x, a->y + a->height, b) ||
+         corner_on_rect (a->x + a->width, a->y, b) ||
+         corner_on_rect (b->x, b->y, a) ||
+         corner_on_rect (b->x, b->y + b->height, a) ||
+         corner_on_rect (b->x + b->width, b->y, a);
+}
+
+static gboolean
+rects_overlap (const GdkRectangle *a, const GdkRectangle *b)
+{
+  return MAX (a->x, b->x) < MIN (a->x + a->width, b->x + b->width) &&
+         MAX (a->y, b->y) < MIN (a->y + a->height, b->y + b->height);
+}
+
+CcDisplayEdgeIndex *
+cc_display_edge_index_new (const GdkRectangle *rects,
+                           guint               n_rects,
+                           guint               moving)
+{
+  CcDisplayEdgeIndex *index;
+  guint i, j;
+
+  g_return_val_if_fail (moving < n_rects, NULL);
+
+  index = g_new0 (CcDisplayEdgeIndex, 1);
+  index->rects = g_memdup (rects, n_rects * sizeof (GdkRectangle));
+  index->n_rects = n_rects;
+  index->moving = moving;
+  index->edges = g_array_sized_new (FALSE, FALSE, sizeof (Edge), 4 * n_rects);
+  index->static_aligned = g_new0 (gboolean, n_rects);
+  index->snaps = g_array_new (FALSE, FALSE, sizeof (Snap));
+
+  for (i = 0; i < n_rects; i++)
+    {
+      if (i == moving)
+        continue;
+
+      list_edges_for_rect (&rects[i], index->edges);
+
+      for (j = 0; j < n_rects; j++)
+        {
+          if (j == moving || j == i)
+            continue;
+
+          if (rects_aligned (&rects[i], &rects[j]))
+            index->static_aligned[i] = TRUE;
+          if (j > i && rects_overlap (&rects[i], &rects[j]))
+            index->static_overlap = TRUE;
+        }
+    }
+
+  return index;
+}
+
+void
+cc_display_edge_index_free (CcDisplayEdgeIndex *index)
+{
+  g_array_free (index->snaps, TRUE);
+  g_array_free (index->edges, TRUE);
+  g_free (index->static_aligned);
+  g_free (index->rects);
+  g_free (index);
+}
+
+/* Whether the whole arrangement is valid with the moving monitor at @r:
+ * no two monitors overlap, and every monitor is aligned with another one.
+ * Only the pairs involving the moving monitor need to be checked. */
+static gboolean
+placement_is_valid (CcDisplayEdgeIndex *index, const GdkRectangle *r)
+{
+  gboolean aligned = FALSE;
+  guint i;
+
+  for (i = 0; i < index->n_rects; i++)
+    {
+      gboolean pair_aligned;
+
+      if (i == index->moving)
+        continue;
+
+      if (rects_overlap (r, &index->rects[i]))
+        return FALSE;
+
+      pair_aligned = rects_aligned (r, &index->rects[i]);
+      if (!pair_aligned && !index->static_aligned[i])
+        return FALSE;
+
+      aligned = aligned || pair_aligned;
+    }
+
+  return aligned;
+}
+
+/**
+ * cc_display_edge_index_snap:
+ * @index: a #CcDisplayEdgeIndex
+ * @x: the position the moving monitor is dragged to
+ * @y: the position the moving monitor is dragged to
+ * @snapped_x: (out): the snapped position
+ * @snapped_y: (out): the snapped position
+ *
+ * Finds the closest position to (@x, @y) at which the moving monitor is
+ * aligned with the others without overlapping them.
+ *
+ * Returns: %TRUE if such a position was found
+ */
+gboolean
+cc_display_edge_index_snap (CcDisplayEdgeIndex *index,
+                            int                 x,
+                            int                 y,
+                            int                *snapped_x,
+                            int                *snapped_y)
+{
+  GdkRectangle r;
+  Edge moving_edges[4];
+  guint i, j;
+
+  if (index->static_overlap)
+    return FALSE;
+
+  r = index->rects[index->moving];
+  r.x = x;
+  r.y = y;
+
+  /* Top, Bottom, Left, Right */
+  moving_edges[0] = (Edge) { r.x, r.y, r.x + r.width, r.y };
+  moving_edges[1] = (Edge) { r.x, r.y + r.height, r.x + r.width, r.y + r.height };
+  moving_edges[2] = (Edge) { r.x, r.y, r.x, r.y + r.height };
+  moving_edges[3] = (Edge) { r.x + r.width, r.y, r.x + r.width, r.y + r.height };
+
+  g_array_set_size (index->snaps, 0);
+  for (i = 0; i < G_N_ELEMENTS (moving_edges); i++)
+    for (j = 0; j < index->edges->len; j++)
+      add_edge_snaps (&moving_edges[i], &g_array_index (index->edges, Edge, j), index->snaps);
+
+  g_array_sort (index->snaps, compare_snaps);
+
+  for (i = 0; i < index->snaps->len; i++)
+    {
+      const Snap *snap = &g_array_index (index->snaps, Snap, i);
+      GdkRectangle candidate = r;
+
+      candidate.x += snap->dx;
+      candidate.y += snap->dy;
+
+      if (placement_is_valid (index, &candidate))
+        {
+          *snapped_x = candidate.x;
+          *snapped_y = candidate.y;
+          return TRUE;
+        }
+    }
+
+  return FALSE;
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2017  Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef _CC_DISPLAY_EDGE_INDEX_H
+#define _CC_DISPLAY_EDGE_INDEX_H
+
+#include <gdk/gdk.h>
+
+G_BEGIN_DECLS
+
+/*
+ * CcDisplayEdgeIndex:
+ *
+ *   Snapping state for one monitor being dragged in the arrangement
+ *   canvas. The edges of the other monitors, and how they are aligned
+ *   with each other, are computed once when the drag starts, so that each
+ *   pointer motion only has to consider the moving monitor.
+ */
+typedef struct _CcDisplayEdgeIndex CcDisplayEdgeIndex;
+
+CcDisplayEdgeIndex *cc_display_edge_index_new  (const GdkRectangle *rects,
+                                                guint               n_rects,
+                                                guint               moving);
+void                cc_display_edge_index_free (CcDisplayEdgeIndex *index);
+
+gboolean            cc_display_edge_index_snap (CcDisplayEdgeIndex *index,
+                                                int                 x,
+                                                int                 y,
+                                                int                *snapped_x,
+                                                int                *snapped_y);
+
+G_END_DECLS
+
+#endif /* _CC_DISPLAY_EDGE_INDEX_H */
@@ -34,6 +34,7 @@
 
 #include "cc-display-config-manager-rr.h"
 #include "cc-display-config-manager-dbus.h"
+#include "cc-display-edge-index.h"
 #include "cc-display-config.h"
 #include "cc-night-light-dialog.h"
 #include "cc-display-resources.h"
@@ -71,6 +72,8 @@ struct _CcDisplayPanelPrivate
   CcDisplayConfigManager *manager;
   CcDisplayConfig *current_config;
   CcDisplayMonitor *current_output;
+  GCancellable *verify_cancellable;
+  GCancellable *apply_cancellable;
 
   GnomeBG *background;
   GnomeDesktopThumbnailFactory *thumbnail_factory;
@@ -111,6 +114,7 @@ typedef struct
   int grab_y;
   int output_x;
   int output_y;
+  CcDisplayEdgeIndex *edge_index;
 } GrabInfo;
 
 static GHashTable *output_ids;
@@ -244,6 +248,17 @@ cc_display_panel_dispose (GObject *object)
       monitor_labeler_hide (CC_DISPLAY_PANEL (object));
     }
 
+  if (priv->verify_cancellable)
+    {
+      g_cancellable_cancel (priv->verify_cancellable);
+      g_clear_object (&priv->verify_cancellable);
+    }
+  if (priv->apply_cancellable)
+    {
+      g_cancellable_cancel (priv->apply_cancellable);
+      g_clear_object (&priv->apply_cancellable);
+    }
+
   g_clear_object (&priv->manager);
   g_clear_object (&priv->current_config);
   g_clear_object (&priv->up_client);
@@ -785,245 +800,6 @@ compute_scale (CcDisplayPanel *self, FooScrollArea *area)
   return MIN ((double)available_w / total_w, (double)available_h / total_h);
 }
 
-typedef struct Edge
-{
-  CcDisplayMonitor *output;
-  int x1, y1;
-  int x2, y2;
-} Edge;
-
-typedef struct Snap
-{
-  Edge *snapper;              /* Edge that should be snapped */
-  Edge *snappee;
-  int dy, dx;
-} Snap;
-
-static void
-add_edge (CcDisplayMonitor *output, int x1, int y1, int x2, int y2, GArray *edges)
-{
-  Edge e;
-
-  e.x1 = x1;
-  e.x2 = x2;
-  e.y1 = y1;
-  e.y2 = y2;
-  e.output = output;
-
-  g_array_append_val (edges, e);
-}
-
-static void
-list_edges_for_output (CcDisplayMonitor *output, GArray *edges, gboolean should_scale)
-{
-  int x, y, w, h;
-
-  get_geometry (output, &x, &y, &w, &h);
-
-  if (should_scale)
-    {
-      double scale = cc_display_monitor_get_scale (output);
-      w /= scale;
-      h /= scale;
-    }
-
-  /* Top, Bottom, Left, Right */
-  add_edge (output, x, y, x + w, y, edges);
-  add_edge (output, x, y + h, x + w, y + h, edges);
-  add_edge (output, x, y, x, y + h, edges);
-  add_edge (output, x + w, y, x + w, y + h, edges);
-}
-
-static void
-list_edges (CcDisplayPanel *panel, GArray *edges)
-{
-  GList *outputs, *l;
-  gboolean should_scale;
-
-  should_scale = cc_display_config_is_layout_logical (panel->priv->current_config);
-  outputs = cc_display_config_get_monitors (panel->priv->current_config);
-
-  for (l = outputs; l != NULL; l = l->next)
-    {
-      CcDisplayMonitor *output = l->data;
-
-      list_edges_for_output (output, edges, should_scale);
-    }
-}
-
-static gboolean
-overlap (int s1, int e1, int s2, int e2)
-{
-  return (!(e1 < s2 || s1 >= e2));
-}
-
-static gboolean
-horizontal_overlap (Edge *snapper, Edge *snappee)
-{
-  if (snapper->y1 != snapper->y2 || snappee->y1 != snappee->y2)
-    return FALSE;
-
-  return overlap (snapper->x1, snapper->x2, snappee->x1, snappee->x2);
-}
-
-static gboolean
-vertical_overlap (Edge *snapper, Edge *snappee)
-{
-  if (snapper->x1 != snapper->x2 || snappee->x1 != snappee->x2)
-    return FALSE;
-
-  return overlap (snapper->y1, snapper->y2, snappee->y1, snappee->y2);
-}
-
-static void
-add_snap (GArray *snaps, Snap snap)
-{
-  if (ABS (snap.dx) <= 200 || ABS (snap.dy) <= 200)
-    g_array_append_val (snaps, snap);
-}
-
-static void
-add_edge_snaps (Edge *snapper, Edge *snappee, GArray *snaps)
-{
-  Snap snap;
-
-  snap.snapper = snapper;
-  snap.snappee = snappee;
-
-  if (horizontal_overlap (snapper, snappee))
-    {
-      snap.dx = 0;
-      snap.dy = snappee->y1 - snapper->y1;
-
-      add_snap (snaps, snap);
-    }
-  else if (vertical_overlap (snapper, snappee))
-    {
-      snap.dy = 0;
-      snap.dx = snappee->x1 - snapper->x1;
-
-      add_snap (snaps, snap);
-    }
-
-  /* Corner snaps */
-  /* 1->1 */
-  snap.dx = snappee->x1 - snapper->x1;
-  snap.dy = snappee->y1 - snapper->y1;
-
-  add_snap (snaps, snap);
-
-  /* 1->2 */
-  snap.dx = snappee->x2 - snapper->x1;
-  snap.dy = snappee->y2 - snapper->y1;
-
-  add_snap (snaps, snap);
-
-  /* 2->2 */
-  snap.dx = snappee->x2 - snapper->x2;
-  snap.dy = snappee->y2 - snapper->y2;
-
-  add_snap (snaps, snap);
-
-  /* 2->1 */
-  snap.dx = snappee->x1 - snapper->x2;
-  snap.dy = snappee->y1 - snapper->y2;
-
-  add_snap (snaps, snap);
-}
-
-static void
-list_snaps (CcDisplayMonitor *output, GArray *edges, GArray *snaps)
-{
-  int i;
-
-  for (i = 0; i < edges->len; ++i)
-    {
-      Edge *output_edge = &(g_array_index (edges, Edge, i));
-
-      if (output_edge->output == output)
-        {
-          int j;
-
-          for (j = 0; j < edges->len; ++j)
-            {
-              Edge *edge = &(g_array_index (edges, Edge, j));
-
-              if (edge->output != output)
-                add_edge_snaps (output_edge, edge, snaps);
-            }
-        }
-    }
-}
-
-#if 0
-static void
-print_edge (Edge *edge)
-{
-  g_debug ("(%d %d %d %d)", edge->x1, edge->y1, edge->x2, edge->y2);
-}
-#endif
-
-static gboolean
-corner_on_edge (int x, int y, Edge *e)
-{
-  if (x == e->x1 && x == e->x2 && y >= e->y1 && y <= e->y2)
-    return TRUE;
-
-  if (y == e->y1 && y == e->y2 && x >= e->x1 && x <= e->x2)
-    return TRUE;
-
-  return FALSE;
-}
-
-static gboolean
-edges_align (Edge *e1, Edge *e2)
-{
-  if (corner_on_edge (e1->x1, e1->y1, e2))
-    return TRUE;
-
-  if (corner_on_edge (e2->x1, e2->y1, e1))
-    return TRUE;
-
-  return FALSE;
-}
-
-static gboolean
-output_is_aligned (CcDisplayMonitor *output, GArray *edges)
-{
-  gboolean result = FALSE;
-  int i;
-
-  for (i = 0; i < edges->len; ++i)
-    {
-      Edge *output_edge = &(g_array_index (edges, Edge, i));
-
-      if (output_edge->output == output)
-        {
-          int j;
-
-          for (j = 0; j < edges->len; ++j)
-            {
-              Edge *edge = &(g_array_index (edges, Edge, j));
-
-              /* We are aligned if an output edge matches
-               * an edge of another output
-               */
-              if (edge->output != output_edge->output)
-                {
-                  if (edges_align (output_edge, edge))
-                    {
-                      result = TRUE;
-                      goto done;
-                    }
-                }
-            }
-        }
-    }
- done:
-
-  return result;
-}
-
 static void
 get_output_rect (CcDisplayMonitor *output, GdkRectangle *rect, gboolean should_scale)
 {
@@ -1036,95 +812,34 @@ get_output_rect (CcDisplayMonitor *output, GdkRectangle *rect, gboolean should_s
     }
 }
 
-static gboolean
-output_overlaps (CcDisplayMonitor *output, CcDisplayPanel *panel)
+static CcDisplayEdgeIndex *
+create_edge_index (CcDisplayPanel *panel, CcDisplayMonitor *moving)
 {
-  GdkRectangle output_rect;
+  CcDisplayEdgeIndex *index;
   GList *outputs, *l;
+  GdkRectangle *rects;
   gboolean should_scale;
-
-  g_assert (output != NULL);
+  guint n_rects, i, moving_index = 0;
 
   should_scale = cc_display_config_is_layout_logical (panel->priv->current_config);
-  get_output_rect (output, &output_rect, should_scale);
-
   outputs = cc_display_config_get_monitors (panel->priv->current_config);
-  for (l = outputs; l != NULL; l = l->next)
-    {
-      CcDisplayMonitor *o = l->data;
-      if (o != output)
-	{
-	  GdkRectangle other_rect;
-	  get_output_rect (o, &other_rect, should_scale);
-	  if (gdk_rectangle_intersect (&output_rect, &other_rect, NULL))
-	    return TRUE;
-	}
-    }
 
-  return FALSE;
-}
-
-static gboolean
-config_is_aligned (CcDisplayPanel *panel, GArray *edges)
-{
-  gboolean result = TRUE;
-  GList *outputs, *l;
+  n_rects = g_list_length (outputs);
+  rects = g_new (GdkRectangle, n_rects);
 
-  outputs = cc_display_config_get_monitors (panel->priv->current_config);
-  for (l = outputs; l != NULL; l = l->next)
+  for (l = outputs, i = 0; l != NULL; l = l->next, i++)
     {
       CcDisplayMonitor *output = l->data;
-      if (!output_is_aligned (output, edges))
-        return FALSE;
 
-      if (output_overlaps (output, panel))
-        return FALSE;
+      get_output_rect (output, &rects[i], should_scale);
+      if (output == moving)
+        moving_index = i;
     }
 
-  return result;
-}
+  index = cc_display_edge_index_new (rects, n_rects, moving_index);
+  g_free (rects);
 
-static gboolean
-is_corner_snap (const Snap *s)
-{
-  return s->dx != 0 && s->dy != 0;
-}
-
-static int
-compare_snaps (gconstpointer v1, gconstpointer v2)
-{
-  const Snap *s1 = v1;
-  const Snap *s2 = v2;
-  int sv1 = MAX (ABS (s1->dx), ABS (s1->dy));
-  int sv2 = MAX (ABS (s2->dx), ABS (s2->dy));
-  int d;
-
-  d = sv1 - sv2;
-
-  /* This snapping algorithm is good enough for rock'n'roll, but
-   * this is probably a better:
-   *
-   *    First do a horizontal/vertical snap, then
-   *    with the new coordinates from that snap,
-   *    do a corner snap.
-   *
-   * Right now, it's confusing that corner snapping
-   * depends on the distance in an axis that you can't actually see.
-   *
-   */
-  if (d == 0)
-    {
-      if (is_corner_snap (s1) && !is_corner_snap (s2))
-        return -1;
-      else if (is_corner_snap (s2) && !is_corner_snap (s1))
-        return 1;
-      else
-        return 0;
-    }
-  else
-    {
-      return d;
-    }
+  return index;
 }
 
 /* Sets a mouse cursor for a widget's window.  As a hack, you can pass
@@ -1159,18 +874,41 @@ grab_weak_ref_notify (gpointer  area,
 }
 
 static void
-update_apply_button (CcDisplayPanel *panel)
+cancel_apply_button_update (CcDisplayPanel *panel)
 {
   CcDisplayPanelPrivate *priv = panel->priv;
+
+  if (priv->verify_cancellable)
+    {
+      g_cancellable_cancel (priv->verify_cancellable);
+      g_clear_object (&priv->verify_cancellable);
+    }
+}
+
+static void
+config_verified (GObject      *source,
+                 GAsyncResult *res,
+                 gpointer      user_data)
+{
+  CcDisplayPanel *panel = user_data;
+  CcDisplayPanelPrivate *priv;
   gboolean config_equal;
   CcDisplayConfig *applied_config;
+  GError *error = NULL;
 
-  if (!cc_display_config_is_applicable (priv->current_config))
+  if (!cc_display_config_is_applicable_finish (CC_DISPLAY_CONFIG (source), res, &error))
     {
-      gtk_dialog_set_response_sensitive (GTK_DIALOG (priv->dialog), GTK_RESPONSE_ACCEPT, FALSE);
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+          priv = panel->priv;
+          g_warning ("Config not applicable: %s", error->message);
+          gtk_dialog_set_response_sensitive (GTK_DIALOG (priv->dialog), GTK_RESPONSE_ACCEPT, FALSE);
+        }
+      g_error_free (error);
       return;
     }
 
+  priv = panel->priv;
   applied_config = cc_display_config_manager_get_current (priv->manager);
 
   config_equal = cc_display_config_equal (priv->current_config,
@@ -1180,6 +918,21 @@ update_apply_button (CcDisplayPanel *panel)
   gtk_dialog_set_response_sensitive (GTK_DIALOG (priv->dialog), GTK_RESPONSE_ACCEPT, !config_equal);
 }
 
+static void
+update_apply_button (CcDisplayPanel *panel)
+{
+  CcDisplayPanelPrivate *priv = panel->priv;
+
+  /* Only the answer for the latest configuration matters */
+  cancel_apply_button_update (panel);
+  priv->verify_cancellable = g_cancellable_new ();
+
+  cc_display_config_is_applicable_async (priv->current_config,
+                                         priv->verify_cancellable,
+                                         config_verified,
+                                         panel);
+}
+
 static void
 on_output_event (FooScrollArea *area,
                  FooScrollAreaEvent *event,
@@ -1230,6 +983,7 @@ on_output_event (FooScrollArea *area,
 	  info->grab_y = event->y;
 	  info->output_x = output_x;
 	  info->output_y = output_y;
+	  info->edge_index = create_edge_index (self, output);
 
 	  g_object_set_data (G_OBJECT (output), "grab-info", info);
 	}
@@ -1241,58 +995,23 @@ on_output_event (FooScrollArea *area,
 	{
 	  GrabInfo *info = g_object_get_data (G_OBJECT (output), "grab-info");
 	  double scale = compute_scale (self, area);
-	  int old_x, old_y;
 	  int new_x, new_y;
-	  int i;
-	  GArray *edges, *snaps, *new_edges;
+	  int snapped_x, snapped_y;
 
-	  cc_display_monitor_get_geometry (output, &old_x, &old_y, NULL, NULL);
 	  new_x = info->output_x + (event->x - info->grab_x) / scale;
 	  new_y = info->output_y + (event->y - info->grab_y) / scale;
 
-	  cc_display_monitor_set_position (output, new_x, new_y);
-
-	  edges = g_array_new (TRUE, TRUE, sizeof (Edge));
-	  snaps = g_array_new (TRUE, TRUE, sizeof (Snap));
-	  new_edges = g_array_new (TRUE, TRUE, sizeof (Edge));
-
-	  list_edges (self, edges);
-	  list_snaps (output, edges, snaps);
-
-	  g_array_sort (snaps, compare_snaps);
-
-	  cc_display_monitor_set_position (output, old_x, old_y);
-
-	  for (i = 0; i < snaps->len; ++i)
-	    {
-	      Snap *snap = &(g_array_index (snaps, Snap, i));
-	      GArray *new_edges = g_array_new (TRUE, TRUE, sizeof (Edge));
-
-	      cc_display_monitor_set_position (output, new_x + snap->dx, new_y + snap->dy);
-
-	      g_array_set_size (new_edges, 0);
-	      list_edges (self, new_edges);
-
-	      if (config_is_aligned (self, new_edges))
-		{
-		  g_array_free (new_edges, TRUE);
-		  break;
-		}
-	      else
-		{
-		  cc_display_monitor_set_position (output, info->output_x, info->output_y);
-		}
-	    }
-
-	  g_array_free (new_edges, TRUE);
-	  g_array_free (snaps, TRUE);
-	  g_array_free (edges, TRUE);
+	  /* Stay at the last valid position if nothing can be snapped to */
+	  if (cc_display_edge_index_snap (info->edge_index, new_x, new_y,
+	                                  &snapped_x, &snapped_y))
+	    cc_display_monitor_set_position (output, snapped_x, snapped_y);
 
 	  if (event->type == FOO_BUTTON_RELEASE)
 	    {
 	      foo_scroll_area_end_grab (area, event);
 
-	      g_free (g_object_get_data (G_OBJECT (output), "grab-info"));
+	      cc_display_edge_index_free (info->edge_index);
+	      g_free (info);
 	      g_object_set_data (G_OBJECT (output), "grab-info", NULL);
 	      g_object_weak_unref (data, grab_weak_ref_notify, area);
               update_apply_button (self);
@@ -1398,11 +1117,19 @@ on_area_paint (FooScrollArea  *area,
 }
 
 static void
-apply_current_configuration (CcDisplayPanel *self)
+config_applied (GObject      *source,
+                GAsyncResult *res,
+                gpointer      user_data)
 {
+  CcDisplayPanel *self = user_data;
   GError *error = NULL;
 
-  cc_display_config_apply (self->priv->current_config, &error);
+  if (!cc_display_config_apply_finish (CC_DISPLAY_CONFIG (source), res, &error) &&
+      g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+      g_error_free (error);
+      return;
+    }
 
   /* re-read the configuration */
   on_screen_changed (self);
@@ -1414,6 +1141,24 @@ apply_current_configuration (CcDisplayPanel *self)
     }
 }
 
+static void
+apply_current_configuration (CcDisplayPanel *self)
+{
+  CcDisplayPanelPrivate *priv = self->priv;
+
+  if (priv->apply_cancellable)
+    {
+      g_cancellable_cancel (priv->apply_cancellable);
+      g_object_unref (priv->apply_cancellable);
+    }
+  priv->apply_cancellable = g_cancellable_new ();
+
+  cc_display_config_apply_async (priv->current_config,
+                                 priv->apply_cancellable,
+                                 config_applied,
+                                 self);
+}
+
 static void
 dialog_toplevel_focus_changed (GtkWindow      *window,
                                GParamSpec     *pspec,
@@ -1477,6 +1222,7 @@ show_arrange_displays_dialog (GtkButton      *button,
       on_screen_changed (panel);
     }
 
+  cancel_apply_button_update (panel);
   gtk_widget_destroy (priv->dialog);
   priv->dialog = NULL;
 }
@@ -2512,6 +2258,7 @@ show_setup_dialog (CcDisplayPanel *panel)
   priv->res_combo = NULL;
   priv->freq_combo = NULL;
   clear_res_freqs (panel);
+  cancel_apply_button_update (panel);
   gtk_widget_destroy (priv->dialog);
   priv->dialog = NULL;
 }
@@ -2556,11 +2303,32 @@ mapped_cb (CcDisplayPanel *panel)
 
   shell = cc_panel_get_shell (CC_PANEL (panel));
   toplevel = cc_shell_get_toplevel (shell);
-  if (toplevel)
+  if (toplevel && priv->focus_id == 0)
     priv->focus_id = g_signal_connect (toplevel, "notify::has-toplevel-focus",
                                        G_CALLBACK (dialog_toplevel_focus_changed), panel);
 }
 
+/* The panel is unmapped when the shell switches away from it, and may
+ * then be kept around to be shown again, so stop following the focus */
+static void
+unmapped_cb (CcDisplayPanel *panel)
+{
+  CcDisplayPanelPrivate *priv = panel->priv;
+  CcShell *shell;
+  GtkWidget *toplevel;
+
+  if (priv->focus_id == 0)
+    return;
+
+  shell = cc_panel_get_shell (CC_PANEL (panel));
+  toplevel = cc_shell_get_toplevel (shell);
+  if (toplevel != NULL)
+    g_signal_handler_disconnect (toplevel, priv->focus_id);
+  priv->focus_id = 0;
+
+  monitor_labeler_hide (panel);
+}
+
 static void
 cc_display_panel_up_client_changed (UpClient       *client,
                                     GParamSpec     *pspec,
@@ -2890,6 +2658,7 @@ cc_display_panel_init (CcDisplayPanel *self)
   night_light_enabled_recheck (self);
 
   g_signal_connect (self, "map", G_CALLBACK (mapped_cb), NULL);
+  g_signal_connect (self, "unmap", G_CALLBACK (unmapped_cb), NULL);
 
   self->priv->shell_cancellable = g_cancellable_new ();
   g_dbus_proxy_new_for_bus (G_BUS_TYPE_SESSION,
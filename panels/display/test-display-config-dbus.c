@@ -0,0 +1,344 @@
+/*
+ * Copyright (C) 2017  Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <config.h>
+
+#include <gio/gio.h>
+
+#include "cc-display-config-dbus.h"
+
+/* A mock of mutter's DisplayConfig service on a private session bus. Calls
+ * are answered only when the test flushes them, so that it controls which
+ * requests are in flight. */
+
+#define CURRENT_STATE_FORMAT "(ua((ssss)a(iiddu)a{sv})a(iiduba(ssss)a{sv})ada{sv})"
+
+/* Scale the mock service refuses to apply */
+#define REJECTED_SCALE 3.0
+
+static const gchar introspection_xml[] =
+  "<node>"
+  "  <interface name='org.gnome.Mutter.DisplayConfig'>"
+  "    <method name='ApplyMonitorsConfig'>"
+  "      <arg name='serial' direction='in' type='u'/>"
+  "      <arg name='method' direction='in' type='u'/>"
+  "      <arg name='logical_monitors' direction='in' type='a(iiduba(s(iid)a{sv}))'/>"
+  "      <arg name='properties' direction='in' type='a{sv}'/>"
+  "    </method>"
+  "  </interface>"
+  "</node>";
+
+typedef struct
+{
+  GTestDBus *bus;
+  GDBusConnection *connection;
+  guint owner_id;
+  gboolean name_acquired;
+  guint registration_id;
+  GPtrArray *invocations;
+  guint n_calls;
+  CcDisplayConfig *config;
+} Fixture;
+
+typedef struct
+{
+  gboolean done;
+  gboolean applicable;
+  GError *error;
+} VerifyResult;
+
+static void
+handle_method_call (GDBusConnection       *connection,
+                    const gchar           *sender,
+                    const gchar           *object_path,
+                    const gchar           *interface_name,
+                    const gchar           *method_name,
+                    GVariant              *parameters,
+                    GDBusMethodInvocation *invocation,
+                    gpointer               user_data)
+{
+  Fixture *fixture = user_data;
+
+  fixture->n_calls++;
+  g_ptr_array_add (fixture->invocations, invocation);
+}
+
+static const GDBusInterfaceVTable interface_vtable = {
+  handle_method_call,
+  NULL,
+  NULL
+};
+
+static void
+flush_invocations (Fixture *fixture)
+{
+  guint i;
+
+  for (i = 0; i < fixture->invocations->len; i++)
+    {
+      GDBusMethodInvocation *invocation = g_ptr_array_index (fixture->invocations, i);
+      GVariant *parameters = g_dbus_method_invocation_get_parameters (invocation);
+      GVariantIter *logical_monitors;
+      gboolean rejected = FALSE;
+      double scale;
+
+      g_variant_get (parameters, "(uua(iiduba(s(iid)a{sv}))a{sv})",
+                     NULL, NULL, &logical_monitors, NULL);
+      while (g_variant_iter_next (logical_monitors, "(iidub@a(s(iid)a{sv}))",
+                                  NULL, NULL, &scale, NULL, NULL, NULL))
+        {
+          if (scale == REJECTED_SCALE)
+            rejected = TRUE;
+        }
+      g_variant_iter_free (logical_monitors);
+
+      if (rejected)
+        g_dbus_method_invocation_return_error (invocation,
+                                               G_DBUS_ERROR,
+                                               G_DBUS_ERROR_INVALID_ARGS,
+                                               "Scale not supported");
+      else
+        g_dbus_method_invocation_return_value (invocation, NULL);
+    }
+
+  g_ptr_array_set_size (fixture->invocations, 0);
+}
+
+static void
+name_acquired (GDBusConnection *connection,
+               const gchar     *name,
+               gpointer         user_data)
+{
+  Fixture *fixture = user_data;
+
+  fixture->name_acquired = TRUE;
+}
+
+static GVariant *
+create_state (void)
+{
+  GError *error = NULL;
+  GVariant *state;
+
+  state = g_variant_parse (G_VARIANT_TYPE (CURRENT_STATE_FORMAT),
+                           "(1,"
+                           " [(('DP-1', 'MetaProducts Inc.', 'MetaMonitor', '0x123456'),"
+                           "   [(1920, 1080, 60.0, 1.0, 3), (1280, 720, 60.0, 1.0, 0)],"
+                           "   @a{sv} {})],"
+                           " [(0, 0, 1.0, 0, true,"
+                           "   [('DP-1', 'MetaProducts Inc.', 'MetaMonitor', '0x123456')],"
+                           "   @a{sv} {})],"
+                           " [1.0, 2.0, 3.0],"
+                           " @a{sv} {})",
+                           NULL, NULL, &error);
+  g_assert_no_error (error);
+
+  return state;
+}
+
+static void
+fixture_setup (Fixture       *fixture,
+               gconstpointer  user_data)
+{
+  GDBusNodeInfo *introspection_data;
+  GError *error = NULL;
+
+  fixture->bus = g_test_dbus_new (G_TEST_DBUS_NONE);
+  g_test_dbus_up (fixture->bus);
+
+  /* The same connection serves the mock and is used by the config; the
+   * calls still go through the bus daemon. */
+  fixture->connection =
+    g_dbus_connection_new_for_address_sync (g_test_dbus_get_bus_address (fixture->bus),
+                                            G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+                                            G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,
+                                            NULL, NULL, &error);
+  g_assert_no_error (error);
+
+  introspection_data = g_dbus_node_info_new_for_xml (introspection_xml, &error);
+  g_assert_no_error (error);
+  fixture->invocations = g_ptr_array_new ();
+  fixture->n_calls = 0;
+  fixture->registration_id =
+    g_dbus_connection_register_object (fixture->connection,
+                                       "/org/gnome/Mutter/DisplayConfig",
+                                       introspection_data->interfaces[0],
+                                       &interface_vtable,
+                                       fixture, NULL, &error);
+  g_assert_no_error (error);
+  g_dbus_node_info_unref (introspection_data);
+
+  fixture->name_acquired = FALSE;
+  fixture->owner_id = g_bus_own_name_on_connection (fixture->connection,
+                                                    "org.gnome.Mutter.DisplayConfig",
+                                                    G_BUS_NAME_OWNER_FLAGS_NONE,
+                                                    name_acquired, NULL,
+                                                    fixture, NULL);
+  while (!fixture->name_acquired)
+    g_main_context_iteration (NULL, TRUE);
+
+  fixture->config = g_object_new (CC_TYPE_DISPLAY_CONFIG_DBUS,
+                                  "state", create_state (),
+                                  "connection", fixture->connection,
+                                  NULL);
+}
+
+static void
+fixture_teardown (Fixture       *fixture,
+                  gconstpointer  user_data)
+{
+  flush_invocations (fixture);
+  g_object_unref (fixture->config);
+  g_bus_unown_name (fixture->owner_id);
+  g_dbus_connection_unregister_object (fixture->connection, fixture->registration_id);
+  g_ptr_array_free (fixture->invocations, TRUE);
+  g_dbus_connection_close_sync (fixture->connection, NULL, NULL);
+  g_object_unref (fixture->connection);
+
+  g_test_dbus_down (fixture->bus);
+  g_object_unref (fixture->bus);
+}
+
+static void
+verify_cb (GObject      *source,
+           GAsyncResult *res,
+           gpointer      user_data)
+{
+  VerifyResult *result = user_data;
+
+  result->applicable = cc_display_config_is_applicable_finish (CC_DISPLAY_CONFIG (source),
+                                                               res, &result->error);
+  result->done = TRUE;
+}
+
+static void
+wait_for_calls (Fixture *fixture,
+                guint    n_calls)
+{
+  while (fixture->n_calls < n_calls)
+    g_main_context_iteration (NULL, TRUE);
+}
+
+static void
+wait_for_result (VerifyResult *result)
+{
+  while (!result->done)
+    g_main_context_iteration (NULL, TRUE);
+}
+
+static void
+verify (Fixture      *fixture,
+        VerifyResult *result)
+{
+  result->done = FALSE;
+  g_clear_error (&result->error);
+  cc_display_config_is_applicable_async (fixture->config, NULL, verify_cb, result);
+}
+
+static void
+set_scale (Fixture *fixture,
+           double   scale)
+{
+  GList *monitors = cc_display_config_get_monitors (fixture->config);
+
+  cc_display_monitor_set_scale (CC_DISPLAY_MONITOR (monitors->data), scale);
+}
+
+static void
+test_verify_coalesces (Fixture       *fixture,
+                       gconstpointer  user_data)
+{
+  VerifyResult results[3] = { { 0, }, };
+
+  /* The first request goes out, the others wait for it and the second
+   * one is superseded by the third one. */
+  verify (fixture, &results[0]);
+  set_scale (fixture, 2.0);
+  verify (fixture, &results[1]);
+  set_scale (fixture, 1.0);
+  verify (fixture, &results[2]);
+
+  wait_for_calls (fixture, 1);
+  wait_for_result (&results[1]);
+  g_assert_false (results[1].applicable);
+  g_assert_error (results[1].error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+  g_assert_false (results[0].done);
+
+  flush_invocations (fixture);
+  wait_for_result (&results[0]);
+  g_assert_true (results[0].applicable);
+  g_assert_no_error (results[0].error);
+
+  /* The last request was identical to the first one, so it is answered
+   * from the memo without another round trip. */
+  wait_for_result (&results[2]);
+  g_assert_true (results[2].applicable);
+  g_assert_cmpuint (fixture->n_calls, ==, 1);
+
+  g_clear_error (&results[1].error);
+}
+
+static void
+test_verify_memo (Fixture       *fixture,
+                  gconstpointer  user_data)
+{
+  VerifyResult result = { 0, };
+
+  set_scale (fixture, 2.0);
+  verify (fixture, &result);
+  wait_for_calls (fixture, 1);
+  flush_invocations (fixture);
+  wait_for_result (&result);
+  g_assert_true (result.applicable);
+
+  set_scale (fixture, REJECTED_SCALE);
+  verify (fixture, &result);
+  wait_for_calls (fixture, 2);
+  flush_invocations (fixture);
+  wait_for_result (&result);
+  g_assert_false (result.applicable);
+  g_assert_nonnull (result.error);
+
+  /* Both verdicts are remembered */
+  verify (fixture, &result);
+  wait_for_result (&result);
+  g_assert_false (result.applicable);
+  g_assert_nonnull (result.error);
+
+  set_scale (fixture, 2.0);
+  verify (fixture, &result);
+  wait_for_result (&result);
+  g_assert_true (result.applicable);
+  g_clear_error (&result.error);
+
+  g_assert_cmpuint (fixture->n_calls, ==, 2);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add ("/display/config-dbus/verify-coalesces", Fixture, NULL,
+              fixture_setup, test_verify_coalesces, fixture_teardown);
+  g_test_add ("/display/config-dbus/verify-memo", Fixture, NULL,
+              fixture_setup, test_verify_memo, fixture_teardown);
+
+  return g_test_run ();
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2017  Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <config.h>
+
+#include <glib.h>
+
+#include "cc-display-edge-index.h"
+
+/* Time allowed to snap on each pointer motion, for a 60 Hz frame */
+#define FRAME_BUDGET (G_USEC_PER_SEC / 60)
+
+static void
+test_snap_side (void)
+{
+  GdkRectangle rects[] = {
+    { 0, 0, 1920, 1080 },
+    { 1930, 15, 1280, 1024 },
+  };
+  CcDisplayEdgeIndex *index;
+  int x, y;
+
+  index = cc_display_edge_index_new (rects, G_N_ELEMENTS (rects), 1);
+
+  /* Dropped slightly to the right, snaps against the right edge */
+  g_assert_true (cc_display_edge_index_snap (index, 1930, 15, &x, &y));
+  g_assert_cmpint (x, ==, 1920);
+  g_assert_cmpint (y, ==, 15);
+
+  /* Dropped close to a corner, snaps to the corner */
+  g_assert_true (cc_display_edge_index_snap (index, 1925, -5, &x, &y));
+  g_assert_cmpint (x, ==, 1920);
+  g_assert_cmpint (y, ==, 0);
+
+  cc_display_edge_index_free (index);
+}
+
+static void
+test_snap_no_overlap (void)
+{
+  GdkRectangle rects[] = {
+    { 0, 0, 1920, 1080 },
+    { 1920, 0, 1920, 1080 },
+    { 0, 1080, 1920, 1080 },
+  };
+  CcDisplayEdgeIndex *index;
+  GdkRectangle moved;
+  guint i;
+  int x, y;
+
+  index = cc_display_edge_index_new (rects, G_N_ELEMENTS (rects), 2);
+
+  /* Dragged on top of the other monitors */
+  g_assert_true (cc_display_edge_index_snap (index, 900, 500, &x, &y));
+
+  moved = rects[2];
+  moved.x = x;
+  moved.y = y;
+  for (i = 0; i < 2; i++)
+    g_assert_false (gdk_rectangle_intersect (&moved, &rects[i], NULL));
+
+  cc_display_edge_index_free (index);
+}
+
+static void
+test_snap_keeps_others_aligned (void)
+{
+  /* The third monitor is only attached to the one being moved */
+  GdkRectangle rects[] = {
+    { 0, 0, 1920, 1080 },
+    { 1920, 0, 1920, 1080 },
+    { 3840, 0, 1920, 1080 },
+  };
+  CcDisplayEdgeIndex *index;
+  int x, y;
+
+  index = cc_display_edge_index_new (rects, G_N_ELEMENTS (rects), 1);
+
+  /* Sliding it between its neighbours is fine */
+  g_assert_true (cc_display_edge_index_snap (index, 1925, 10, &x, &y));
+  g_assert_cmpint (x, ==, 1920);
+  g_assert_cmpint (y, ==, 10);
+
+  /* Moving it below the first one would leave the third one floating */
+  g_assert_false (cc_display_edge_index_snap (index, 0, 1500, &x, &y));
+
+  cc_display_edge_index_free (index);
+}
+
+static void
+test_snap_perf (void)
+{
+  GdkRectangle rects[8];
+  CcDisplayEdgeIndex *index;
+  GTimer *timer;
+  guint n_motions = 1000;
+  guint i;
+  gdouble elapsed, per_motion;
+  int x, y;
+
+  if (g_test_perf ())
+    n_motions = 100000;
+
+  /* A 4x2 wall of monitors, the bottom right one being dragged around */
+  for (i = 0; i < G_N_ELEMENTS (rects); i++)
+    {
+      rects[i].x = (i % 4) * 1920;
+      rects[i].y = (i / 4) * 1080;
+      rects[i].width = 1920;
+      rects[i].height = 1080;
+    }
+
+  timer = g_timer_new ();
+
+  index = cc_display_edge_index_new (rects, G_N_ELEMENTS (rects), 7);
+  for (i = 0; i < n_motions; i++)
+    cc_display_edge_index_snap (index,
+                                5760 + (i % 400) - 200,
+                                1080 + (i % 300) - 150,
+                                &x, &y);
+  cc_display_edge_index_free (index);
+
+  elapsed = g_timer_elapsed (timer, NULL);
+  g_timer_destroy (timer);
+
+  per_motion = elapsed * G_USEC_PER_SEC / n_motions;
+  g_test_minimized_result (per_motion, "%.2f µs per motion event", per_motion);
+  g_assert_cmpfloat (per_motion, <, FRAME_BUDGET);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/display/edge-index/snap-side", test_snap_side);
+  g_test_add_func ("/display/edge-index/snap-no-overlap", test_snap_no_overlap);
+  g_test_add_func ("/display/edge-index/snap-keeps-others-aligned", test_snap_keeps_others_aligned);
+  g_test_add_func ("/display/edge-index/perf", test_snap_perf);
+
+  return g_test_run ();
+}
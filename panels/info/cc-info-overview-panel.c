@@ -53,6 +53,26 @@ typedef struct {
   char *hardware_string;
 } GraphicsData;
 
+typedef struct {
+  CcInfoOverviewPanel *self;
+  GCancellable        *cancellable;
+  char                *cache_key;
+  char                *renderer;
+  char                *discrete_renderer;
+  guint                pending;
+  gboolean             failed;
+} GraphicsProbe;
+
+typedef struct {
+  GraphicsProbe *probe;
+  GSubprocess   *subprocess;
+  gboolean       discrete_gpu;
+  guint          timeout_id;
+} HelperCall;
+
+#define RENDERER_HELPER_TIMEOUT 10 /* seconds */
+#define RENDERER_CACHE_GROUP "Renderer"
+
 typedef struct
 {
   GtkWidget      *system_image;
@@ -76,13 +96,8 @@ typedef struct
   char           *gnome_distributor;
   char           *gnome_date;
 
-  GCancellable   *cancellable;
-
-  /* Free space */
-  GList          *primary_mounts;
-  guint64         total_bytes;
-
   GraphicsData   *graphics_data;
+  GCancellable   *graphics_cancellable;
 } CcInfoOverviewPanelPrivate;
 
 struct _CcInfoOverviewPanel
@@ -93,7 +108,34 @@ struct _CcInfoOverviewPanel
  CcInfoOverviewPanelPrivate *priv;
 };
 
-static void get_primary_disc_info_start (CcInfoOverviewPanel *self);
+/* Time allowed for a single mount to report its size, so that a hung
+ * network filesystem does not hold back the total; the total is shown
+ * once the time is up, even if the query is still stuck in statfs() */
+#define DISK_QUERY_TIMEOUT 5 /* seconds */
+
+typedef struct
+{
+  GHashTable *devices;
+  GSList     *waiters;
+  guint64     total_bytes;
+  guint       pending;
+  gboolean    stale;
+} DiskScan;
+
+typedef struct
+{
+  DiskScan     *scan;
+  GFile        *file;
+  GCancellable *cancellable;
+  guint         timeout_id;
+} DiskQuery;
+
+/* The disk size is shared by all the instances of the panel, and only
+ * recomputed when the mount table changes */
+static GUnixMountMonitor *disk_monitor = NULL;
+static DiskScan *disk_scan = NULL;
+static guint64 disk_total_bytes = 0;
+static gboolean disk_total_valid = FALSE;
 
 typedef struct
 {
@@ -257,45 +299,6 @@ get_renderer_from_session (void)
   return renderer;
 }
 
-static char *
-get_renderer_from_helper (gboolean discrete_gpu)
-{
-  int status;
-  char *argv[] = { GNOME_SESSION_DIR "/gnome-session-check-accelerated", NULL };
-  char **envp = NULL;
-  char *renderer = NULL;
-  char *ret = NULL;
-  GError *error = NULL;
-
-  if (discrete_gpu)
-    {
-      envp = g_get_environ ();
-      envp = g_environ_setenv (envp, "DRI_PRIME", "1", TRUE);
-    }
-
-  if (!g_spawn_sync (NULL, (char **) argv, envp, 0, NULL, NULL, &renderer, NULL, &status, &error))
-    {
-      g_debug ("Failed to get %s GPU: %s",
-               discrete_gpu ? "discrete" : "integrated",
-               error->message);
-      g_error_free (error);
-      goto out;
-    }
-
-  if (!g_spawn_check_exit_status (status, NULL))
-    goto out;
-
-  if (renderer == NULL || *renderer == '\0')
-    goto out;
-
-  ret = info_cleanup (renderer);
-
-out:
-  g_free (renderer);
-  g_strfreev (envp);
-  return ret;
-}
-
 static gboolean
 has_dual_gpu (void)
 {
@@ -337,13 +340,266 @@ has_dual_gpu (void)
   return ret;
 }
 
-static GraphicsData *
-get_graphics_data (void)
+static gint
+compare_strings (gconstpointer a,
+                 gconstpointer b)
+{
+  return g_strcmp0 (*(const char **) a, *(const char **) b);
+}
+
+static char *
+get_renderer_cache_key (void)
+{
+  GDir *dir;
+  GPtrArray *cards;
+  const char *name;
+  char *boot_id;
+  char *devices;
+  char *key;
+
+  if (!g_file_get_contents ("/proc/sys/kernel/random/boot_id", &boot_id, NULL, NULL))
+    return NULL;
+
+  /* The renderer can only change if the DRM devices change, which, short of
+   * a GPU hotplug, requires a reboot */
+  cards = g_ptr_array_new_with_free_func (g_free);
+  dir = g_dir_open ("/sys/class/drm", 0, NULL);
+  if (dir != NULL)
+    {
+      while ((name = g_dir_read_name (dir)) != NULL)
+        {
+          /* Skip the connectors, eg. "card0-HDMI-A-1" */
+          if (g_str_has_prefix (name, "card") && strchr (name, '-') == NULL)
+            g_ptr_array_add (cards, g_strdup (name));
+        }
+      g_dir_close (dir);
+    }
+  g_ptr_array_sort (cards, compare_strings);
+  g_ptr_array_add (cards, NULL);
+
+  devices = g_strjoinv (",", (char **) cards->pdata);
+  key = g_strconcat (g_strstrip (boot_id), ";", devices, NULL);
+
+  g_free (devices);
+  g_free (boot_id);
+  g_ptr_array_free (cards, TRUE);
+
+  return key;
+}
+
+static char *
+get_renderer_cache_path (void)
+{
+  return g_build_filename (g_get_user_cache_dir (), "gnome-control-center", "info-renderer", NULL);
+}
+
+static char *
+load_cached_renderer (const char *key)
+{
+  GKeyFile *keyfile;
+  char *path;
+  char *cached_key;
+  char *ret = NULL;
+
+  keyfile = g_key_file_new ();
+  path = get_renderer_cache_path ();
+
+  if (g_key_file_load_from_file (keyfile, path, G_KEY_FILE_NONE, NULL))
+    {
+      cached_key = g_key_file_get_string (keyfile, RENDERER_CACHE_GROUP, "Key", NULL);
+      if (g_strcmp0 (cached_key, key) == 0)
+        ret = g_key_file_get_string (keyfile, RENDERER_CACHE_GROUP, "Renderer", NULL);
+      g_free (cached_key);
+    }
+
+  g_free (path);
+  g_key_file_free (keyfile);
+
+  return ret;
+}
+
+static void
+save_cached_renderer (const char *key,
+                      const char *renderer)
+{
+  GKeyFile *keyfile;
+  GError *error = NULL;
+  char *path;
+  char *dir;
+
+  path = get_renderer_cache_path ();
+  dir = g_path_get_dirname (path);
+  if (g_mkdir_with_parents (dir, 0700) < 0)
+    {
+      g_debug ("Could not create directory '%s': %m", dir);
+      goto out;
+    }
+
+  keyfile = g_key_file_new ();
+  g_key_file_set_string (keyfile, RENDERER_CACHE_GROUP, "Key", key);
+  g_key_file_set_string (keyfile, RENDERER_CACHE_GROUP, "Renderer", renderer);
+  if (!g_key_file_save_to_file (keyfile, path, &error))
+    {
+      g_debug ("Could not save renderer cache '%s': %s", path, error->message);
+      g_error_free (error);
+    }
+  g_key_file_free (keyfile);
+
+out:
+  g_free (dir);
+  g_free (path);
+}
+
+static void
+set_graphics_label (CcInfoOverviewPanel *self,
+                    const char          *hardware_string)
+{
+  CcInfoOverviewPanelPrivate *priv = cc_info_overview_panel_get_instance_private (self);
+
+  g_free (priv->graphics_data->hardware_string);
+  priv->graphics_data->hardware_string = g_strdup (hardware_string ? hardware_string : _("Unknown"));
+
+  gtk_label_set_markup (GTK_LABEL (priv->graphics_label), priv->graphics_data->hardware_string);
+}
+
+static void
+graphics_probe_finish (GraphicsProbe *probe)
+{
+  char *hardware_string;
+
+  if (probe->discrete_renderer == NULL)
+    hardware_string = g_strdup (probe->renderer);
+  else if (probe->renderer == NULL)
+    hardware_string = g_strdup (probe->discrete_renderer);
+  else
+    hardware_string = g_strdup_printf ("%s / %s",
+                                       probe->renderer,
+                                       probe->discrete_renderer);
+
+  /* A helper that timed out or failed may well answer next time */
+  if (hardware_string != NULL && probe->cache_key != NULL && !probe->failed)
+    save_cached_renderer (probe->cache_key, hardware_string);
+
+  if (!g_cancellable_is_cancelled (probe->cancellable))
+    set_graphics_label (probe->self, hardware_string);
+
+  g_free (hardware_string);
+  g_free (probe->renderer);
+  g_free (probe->discrete_renderer);
+  g_free (probe->cache_key);
+  g_object_unref (probe->cancellable);
+  g_slice_free (GraphicsProbe, probe);
+}
+
+static gboolean
+helper_timeout (gpointer user_data)
+{
+  HelperCall *call = user_data;
+
+  g_debug ("Timed out getting %s GPU",
+           call->discrete_gpu ? "discrete" : "integrated");
+
+  call->timeout_id = 0;
+  call->probe->failed = TRUE;
+  g_subprocess_force_exit (call->subprocess);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+helper_done (GObject      *source,
+             GAsyncResult *res,
+             gpointer      user_data)
+{
+  HelperCall *call = user_data;
+  GraphicsProbe *probe = call->probe;
+  char *renderer = NULL;
+  GError *error = NULL;
+
+  if (!g_subprocess_communicate_utf8_finish (call->subprocess, res, &renderer, NULL, &error))
+    {
+      g_debug ("Failed to get %s GPU: %s",
+               call->discrete_gpu ? "discrete" : "integrated",
+               error->message);
+      g_error_free (error);
+      g_subprocess_force_exit (call->subprocess);
+      probe->failed = TRUE;
+    }
+  else if (g_subprocess_get_successful (call->subprocess) &&
+           renderer != NULL && *renderer != '\0')
+    {
+      if (call->discrete_gpu)
+        probe->discrete_renderer = info_cleanup (renderer);
+      else
+        probe->renderer = info_cleanup (renderer);
+    }
+  else
+    {
+      probe->failed = TRUE;
+    }
+
+  g_free (renderer);
+  if (call->timeout_id != 0)
+    g_source_remove (call->timeout_id);
+  g_object_unref (call->subprocess);
+  g_slice_free (HelperCall, call);
+
+  if (--probe->pending == 0)
+    graphics_probe_finish (probe);
+}
+
+static void
+graphics_probe_spawn_helper (GraphicsProbe *probe,
+                             gboolean       discrete_gpu)
 {
-  GraphicsData *result;
+  GSubprocessLauncher *launcher;
+  GSubprocess *subprocess;
+  HelperCall *call;
+  GError *error = NULL;
+
+  launcher = g_subprocess_launcher_new (G_SUBPROCESS_FLAGS_STDOUT_PIPE);
+  if (discrete_gpu)
+    g_subprocess_launcher_setenv (launcher, "DRI_PRIME", "1", TRUE);
+
+  subprocess = g_subprocess_launcher_spawn (launcher, &error,
+                                            GNOME_SESSION_DIR "/gnome-session-check-accelerated",
+                                            NULL);
+  g_object_unref (launcher);
+
+  if (subprocess == NULL)
+    {
+      g_debug ("Failed to get %s GPU: %s",
+               discrete_gpu ? "discrete" : "integrated",
+               error->message);
+      g_error_free (error);
+      probe->failed = TRUE;
+      return;
+    }
+
+  call = g_slice_new0 (HelperCall);
+  call->probe = probe;
+  call->subprocess = subprocess;
+  call->discrete_gpu = discrete_gpu;
+  call->timeout_id = g_timeout_add_seconds (RENDERER_HELPER_TIMEOUT, helper_timeout, call);
+  probe->pending++;
+
+  g_subprocess_communicate_utf8_async (subprocess,
+                                       NULL,
+                                       probe->cancellable,
+                                       helper_done,
+                                       call);
+}
+
+static void
+info_overview_panel_setup_graphics (CcInfoOverviewPanel *self)
+{
+  CcInfoOverviewPanelPrivate *priv = cc_info_overview_panel_get_instance_private (self);
+  GraphicsProbe *probe;
   GdkDisplay *display;
+  char *cache_key;
+  char *hardware_string;
 
-  result = g_slice_new0 (GraphicsData);
+  priv->graphics_data = g_slice_new0 (GraphicsData);
 
   display = gdk_display_get_default ();
 
@@ -358,29 +614,38 @@ get_graphics_data (void)
 
   if (x11_or_wayland)
     {
-      char *discrete_renderer = NULL;
-      char *renderer;
+      cache_key = get_renderer_cache_key ();
+      hardware_string = cache_key ? load_cached_renderer (cache_key) : NULL;
+      if (hardware_string != NULL)
+        {
+          set_graphics_label (self, hardware_string);
+          g_free (hardware_string);
+          g_free (cache_key);
+          return;
+        }
+
+      priv->graphics_cancellable = g_cancellable_new ();
 
-      renderer = get_renderer_from_session ();
-      if (!renderer)
-        renderer = get_renderer_from_helper (FALSE);
+      probe = g_slice_new0 (GraphicsProbe);
+      probe->self = self;
+      probe->cancellable = g_object_ref (priv->graphics_cancellable);
+      probe->cache_key = cache_key;
+
+      /* Both helpers run concurrently, the label is updated once they
+       * have both exited */
+      probe->renderer = get_renderer_from_session ();
+      if (!probe->renderer)
+        graphics_probe_spawn_helper (probe, FALSE);
       if (has_dual_gpu ())
-        discrete_renderer = get_renderer_from_helper (TRUE);
-      if (!discrete_renderer)
-        result->hardware_string = g_strdup (renderer);
-      else
-        result->hardware_string = g_strdup_printf ("%s / %s",
-                                                   renderer,
-                                                   discrete_renderer);
-      g_free (renderer);
-      g_free (discrete_renderer);
+        graphics_probe_spawn_helper (probe, TRUE);
+
+      if (probe->pending == 0)
+        graphics_probe_finish (probe);
+      return;
     }
 #endif
 
-  if (!result->hardware_string)
-    result->hardware_string = g_strdup (_("Unknown"));
-
-  return result;
+  set_graphics_label (self, NULL);
 }
 
 static GHashTable*
@@ -497,66 +762,199 @@ get_os_type (void)
 }
 
 static void
-query_done (GFile               *file,
-            GAsyncResult        *res,
-            CcInfoOverviewPanel *self)
+set_disk_label (CcInfoOverviewPanel *self,
+                guint64              total_bytes)
+{
+  CcInfoOverviewPanelPrivate *priv = cc_info_overview_panel_get_instance_private (self);
+  char *size;
+
+  size = g_format_size (total_bytes);
+  gtk_label_set_text (GTK_LABEL (priv->disk_label), size);
+  g_free (size);
+}
+
+static void
+disk_scan_finish (DiskScan *scan)
+{
+  GSList *l;
+
+  /* Only remember the total if no mount changed while we were counting */
+  if (!scan->stale)
+    {
+      disk_total_bytes = scan->total_bytes;
+      disk_total_valid = TRUE;
+    }
+
+  for (l = scan->waiters; l != NULL; l = l->next)
+    set_disk_label (l->data, scan->total_bytes);
+
+  if (disk_scan == scan)
+    disk_scan = NULL;
+
+  g_slist_free (scan->waiters);
+  g_hash_table_destroy (scan->devices);
+  g_slice_free (DiskScan, scan);
+}
+
+static void
+disk_query_free (DiskQuery *query)
 {
+  DiskScan *scan = query->scan;
+
+  if (query->timeout_id != 0)
+    g_source_remove (query->timeout_id);
+  g_object_unref (query->cancellable);
+  g_object_unref (query->file);
+  g_slice_free (DiskQuery, query);
+
+  if (--scan->pending == 0)
+    disk_scan_finish (scan);
+}
+
+static void
+disk_query_warn (DiskQuery    *query,
+                 const GError *error)
+{
+  char *path;
+
+  path = g_file_get_path (query->file);
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    g_warning ("Timed out getting filesystem size for '%s'", path);
+  else
+    g_warning ("Failed to get filesystem free space for '%s': %s", path, error->message);
+  g_free (path);
+}
+
+static gboolean
+disk_query_timeout (gpointer user_data)
+{
+  DiskQuery *query = user_data;
+
+  query->timeout_id = 0;
+  g_cancellable_cancel (query->cancellable);
+
+  return G_SOURCE_REMOVE;
+}
+
+typedef struct
+{
+  gboolean has_device;
+  guint32  device;
+  guint64  size;
+} DiskQueryResult;
+
+/* Runs in a thread, as statfs() on a hung network filesystem can block
+ * for much longer than the deadline */
+static void
+disk_query_thread (GTask        *task,
+                   gpointer      source_object,
+                   gpointer      task_data,
+                   GCancellable *cancellable)
+{
+  GFile *file = source_object;
+  DiskQueryResult *result;
   GFileInfo *info;
   GError *error = NULL;
-  CcInfoOverviewPanelPrivate *priv = cc_info_overview_panel_get_instance_private (self);
 
-  priv->cancellable = NULL;
-  info = g_file_query_filesystem_info_finish (file, res, &error);
+  result = g_new0 (DiskQueryResult, 1);
+
+  info = g_file_query_info (file,
+                            G_FILE_ATTRIBUTE_UNIX_DEVICE,
+                            G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                            cancellable,
+                            NULL);
   if (info != NULL)
     {
-      priv->total_bytes += g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_FILESYSTEM_SIZE);
+      result->has_device = TRUE;
+      result->device = g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_UNIX_DEVICE);
       g_object_unref (info);
     }
-  else
+
+  info = g_file_query_filesystem_info (file,
+                                       G_FILE_ATTRIBUTE_FILESYSTEM_SIZE,
+                                       cancellable,
+                                       &error);
+  if (info == NULL)
     {
-      char *path;
-      path = g_file_get_path (file);
-      g_warning ("Failed to get filesystem free space for '%s': %s", path, error->message);
-      g_free (path);
-      g_error_free (error);
+      g_free (result);
+      g_task_return_error (task, error);
+      return;
     }
 
-  /* And onto the next element */
-  get_primary_disc_info_start (self);
+  result->size = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_FILESYSTEM_SIZE);
+  g_object_unref (info);
+
+  g_task_return_pointer (task, result, g_free);
 }
 
 static void
-get_primary_disc_info_start (CcInfoOverviewPanel *self)
+disk_query_done (GObject      *source,
+                 GAsyncResult *res,
+                 gpointer      user_data)
 {
-  GUnixMountEntry *mount;
-  GFile *file;
-  CcInfoOverviewPanelPrivate *priv = cc_info_overview_panel_get_instance_private (self);
+  DiskQuery *query = user_data;
+  DiskQueryResult *result;
+  GError *error = NULL;
 
-  if (priv->primary_mounts == NULL)
+  result = g_task_propagate_pointer (G_TASK (res), &error);
+  if (result == NULL)
     {
-      char *size;
+      disk_query_warn (query, error);
+      g_error_free (error);
+      disk_query_free (query);
+      return;
+    }
 
-      size = g_format_size (priv->total_bytes);
-      gtk_label_set_text (GTK_LABEL (priv->disk_label), size);
-      g_free (size);
+  /* Bind mounts share the device of the filesystem they expose, so
+   * only the first mount seen for a device is counted. */
+  if (result->has_device)
+    {
+      gpointer device = GUINT_TO_POINTER (result->device);
 
-      return;
+      if (g_hash_table_contains (query->scan->devices, device))
+        {
+          g_free (result);
+          disk_query_free (query);
+          return;
+        }
+      g_hash_table_add (query->scan->devices, device);
     }
 
-  mount = priv->primary_mounts->data;
-  priv->primary_mounts = g_list_remove (priv->primary_mounts, mount);
-  file = g_file_new_for_path (g_unix_mount_get_mount_path (mount));
-  g_unix_mount_free (mount);
+  query->scan->total_bytes += result->size;
+
+  g_free (result);
+  disk_query_free (query);
+}
 
-  priv->cancellable = g_cancellable_new ();
+static void
+disk_scan_add_mount (DiskScan        *scan,
+                     GUnixMountEntry *mount)
+{
+  DiskQuery *query;
+  GTask *task;
+
+  query = g_slice_new0 (DiskQuery);
+  query->scan = scan;
+  query->file = g_file_new_for_path (g_unix_mount_get_mount_path (mount));
+  query->cancellable = g_cancellable_new ();
+  query->timeout_id = g_timeout_add_seconds (DISK_QUERY_TIMEOUT, disk_query_timeout, query);
+  scan->pending++;
+
+  /* The query is given up on at the deadline, without waiting for the
+   * thread to come back from the filesystem */
+  task = g_task_new (query->file, query->cancellable, disk_query_done, query);
+  g_task_set_return_on_cancel (task, TRUE);
+  g_task_run_in_thread (task, disk_query_thread);
+  g_object_unref (task);
+}
 
-  g_file_query_filesystem_info_async (file,
-                                      G_FILE_ATTRIBUTE_FILESYSTEM_SIZE,
-                                      0,
-                                      priv->cancellable,
-                                      (GAsyncReadyCallback) query_done,
-                                      self);
-  g_object_unref (file);
+static void
+on_mounts_changed (GUnixMountMonitor *monitor,
+                   gpointer           user_data)
+{
+  disk_total_valid = FALSE;
+  if (disk_scan != NULL)
+    disk_scan->stale = TRUE;
 }
 
 static void
@@ -565,7 +963,34 @@ get_primary_disc_info (CcInfoOverviewPanel *self)
   GList *points;
   GList *p;
   GHashTable *hash;
-  CcInfoOverviewPanelPrivate *priv = cc_info_overview_panel_get_instance_private (self);
+  DiskScan *scan;
+
+  if (disk_monitor == NULL)
+    {
+      disk_monitor = g_unix_mount_monitor_get ();
+      g_signal_connect (disk_monitor, "mounts-changed",
+                        G_CALLBACK (on_mounts_changed), NULL);
+      g_signal_connect (disk_monitor, "mountpoints-changed",
+                        G_CALLBACK (on_mounts_changed), NULL);
+    }
+
+  if (disk_total_valid)
+    {
+      set_disk_label (self, disk_total_bytes);
+      return;
+    }
+
+  /* A scan started by another instance of the panel is still running */
+  if (disk_scan != NULL)
+    {
+      disk_scan->waiters = g_slist_prepend (disk_scan->waiters, self);
+      return;
+    }
+
+  scan = g_slice_new0 (DiskScan);
+  scan->devices = g_hash_table_new (g_direct_hash, g_direct_equal);
+  scan->waiters = g_slist_prepend (NULL, self);
+  disk_scan = scan;
 
   hash = g_hash_table_new (g_str_hash, g_str_equal);
   points = g_unix_mount_points_get (NULL);
@@ -586,23 +1011,21 @@ get_primary_disc_info (CcInfoOverviewPanel *self)
       /* Do not count multiple mounts with same device_path, because it is
        * probably something like btrfs subvolume. Use only the first one in
        * order to count the real size. */
-      if (gsd_should_ignore_unix_mount (mount) ||
-          gsd_is_removable_mount (mount) ||
-          g_str_has_prefix (mount_path, "/media/") ||
-          g_str_has_prefix (mount_path, g_get_home_dir ()) ||
-          g_hash_table_lookup (hash, device_path) != NULL)
+      if (!gsd_should_ignore_unix_mount (mount) &&
+          !gsd_is_removable_mount (mount) &&
+          !g_str_has_prefix (mount_path, "/media/") &&
+          !g_str_has_prefix (mount_path, g_get_home_dir ()) &&
+          g_hash_table_lookup (hash, device_path) == NULL)
         {
-          g_unix_mount_free (mount);
-          continue;
+          g_hash_table_insert (hash, (gpointer) device_path, (gpointer) device_path);
+          disk_scan_add_mount (scan, mount);
         }
-
-      priv->primary_mounts = g_list_prepend (priv->primary_mounts, mount);
-      g_hash_table_insert (hash, (gpointer) device_path, (gpointer) device_path);
     }
-  g_list_free (points);
   g_hash_table_destroy (hash);
+  g_list_free_full (points, (GDestroyNotify) g_unix_mount_free);
 
-  get_primary_disc_info_start (self);
+  if (scan->pending == 0)
+    disk_scan_finish (scan);
 }
 
 static char *
@@ -824,8 +1247,6 @@ info_overview_panel_setup_overview (CcInfoOverviewPanel *self)
   g_free (text);
 
   get_primary_disc_info (self);
-
-  gtk_label_set_markup (GTK_LABEL (priv->graphics_label), priv->graphics_data->hardware_string);
 }
 
 static gboolean
@@ -872,6 +1293,15 @@ cc_info_overview_panel_dispose (GObject *object)
 {
   CcInfoOverviewPanelPrivate *priv = cc_info_overview_panel_get_instance_private (CC_INFO_OVERVIEW_PANEL (object));
 
+  if (disk_scan != NULL)
+    disk_scan->waiters = g_slist_remove (disk_scan->waiters, object);
+
+  if (priv->graphics_cancellable)
+    {
+      g_cancellable_cancel (priv->graphics_cancellable);
+      g_clear_object (&priv->graphics_cancellable);
+    }
+
   g_clear_pointer (&priv->graphics_data, graphics_data_free);
 
   G_OBJECT_CLASS (cc_info_overview_panel_parent_class)->dispose (object);
@@ -882,12 +1312,6 @@ cc_info_overview_panel_finalize (GObject *object)
 {
   CcInfoOverviewPanelPrivate *priv = cc_info_overview_panel_get_instance_private (CC_INFO_OVERVIEW_PANEL (object));
 
-  if (priv->cancellable)
-    {
-      g_cancellable_cancel (priv->cancellable);
-      g_clear_object (&priv->cancellable);
-    }
-
   g_free (priv->gnome_version);
   g_free (priv->gnome_date);
   g_free (priv->gnome_distributor);
@@ -929,7 +1353,7 @@ cc_info_overview_panel_init (CcInfoOverviewPanel *self)
 
   gtk_widget_init_template (GTK_WIDGET (self));
 
-  priv->graphics_data = get_graphics_data ();
+  info_overview_panel_setup_graphics (self);
 
   if (does_gnome_software_exist () || does_gpk_update_viewer_exist ())
     {
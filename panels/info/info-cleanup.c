@@ -20,6 +20,7 @@
 
 #include <config.h>
 
+#include <string.h>
 #include <glib.h>
 #include "info-cleanup.h"
 
@@ -29,46 +30,74 @@ typedef struct
   char *replacement;
 } ReplaceStrings;
 
+static const ReplaceStrings rs[] = {
+  { "Mesa DRI ", ""},
+  { "Intel[(]R[)]", "Intel<sup>\302\256</sup>"},
+  { "Core[(]TM[)]", "Core<sup>\342\204\242</sup>"},
+  { "Atom[(]TM[)]", "Atom<sup>\342\204\242</sup>"},
+  { "Gallium .* on (AMD .*)", "\\1"},
+  { "(AMD .*) [(].*", "\\1"},
+  { "(AMD [A-Z])(.*)", "\\1\\L\\2\\E"},
+  { "AMD", "AMD<sup>\302\256</sup>"},
+  { "Graphics Controller", "Graphics"},
+};
+
+/* The rules are compiled once, and shared by all the callers, as GRegex
+ * is safe to use from multiple threads once created */
+static GRegex * const *
+get_rules (void)
+{
+  static GRegex *rules[G_N_ELEMENTS (rs)];
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized))
+    {
+      int i;
+
+      for (i = 0; i < G_N_ELEMENTS (rs); i++)
+        {
+          GError *error = NULL;
+
+          rules[i] = g_regex_new (rs[i].regex, G_REGEX_OPTIMIZE, 0, &error);
+          if (rules[i] == NULL)
+            {
+              g_warning ("Error building regex: %s", error->message);
+              g_error_free (error);
+            }
+        }
+
+      g_once_init_leave (&initialized, 1);
+    }
+
+  return rules;
+}
+
 static char *
 prettify_info (const char *info)
 {
+  GRegex * const *rules;
   char *pretty;
   int   i;
-  static const ReplaceStrings rs[] = {
-    { "Mesa DRI ", ""},
-    { "Intel[(]R[)]", "Intel<sup>\302\256</sup>"},
-    { "Core[(]TM[)]", "Core<sup>\342\204\242</sup>"},
-    { "Atom[(]TM[)]", "Atom<sup>\342\204\242</sup>"},
-    { "Gallium .* on (AMD .*)", "\\1"},
-    { "(AMD .*) [(].*", "\\1"},
-    { "(AMD [A-Z])(.*)", "\\1\\L\\2\\E"},
-    { "AMD", "AMD<sup>\302\256</sup>"},
-    { "Graphics Controller", "Graphics"},
-  };
 
   if (*info == '\0')
     return NULL;
 
+  rules = get_rules ();
+
   pretty = g_markup_escape_text (info, -1);
   pretty = g_strchug (g_strchomp (pretty));
 
   for (i = 0; i < G_N_ELEMENTS (rs); i++)
     {
       GError *error;
-      GRegex *re;
       char   *new;
 
-      error = NULL;
+      if (rules[i] == NULL)
+        continue;
 
-      re = g_regex_new (rs[i].regex, 0, 0, &error);
-      if (re == NULL)
-        {
-          g_warning ("Error building regex: %s", error->message);
-          g_error_free (error);
-          continue;
-        }
+      error = NULL;
 
-      new = g_regex_replace (re,
+      new = g_regex_replace (rules[i],
                              pretty,
                              -1,
                              0,
@@ -76,8 +105,6 @@ prettify_info (const char *info)
                              0,
                              &error);
 
-      g_regex_unref (re);
-
       if (error != NULL)
         {
           g_warning ("Error replacing %s: %s", rs[i].regex, error->message);
@@ -95,35 +122,33 @@ prettify_info (const char *info)
 static char *
 remove_duplicate_whitespace (const char *old)
 {
-  char   *new;
-  GRegex *re;
-  GError *error;
+  char       *new;
+  char       *out;
+  const char *in;
+  gboolean    in_space = FALSE;
 
   if (old == NULL)
     return NULL;
 
-  error = NULL;
-  re = g_regex_new ("[ \t\n\r]+", G_REGEX_MULTILINE, 0, &error);
-  if (re == NULL)
-    {
-      g_warning ("Error building regex: %s", error->message);
-      g_error_free (error);
-      return g_strdup (old);
-    }
-  new = g_regex_replace (re,
-                         old,
-                         -1,
-                         0,
-                         " ",
-                         0,
-                         &error);
-  g_regex_unref (re);
-  if (new == NULL)
+  /* Collapse runs of [ \t\n\r] into a single space, in one pass */
+  new = g_malloc (strlen (old) + 1);
+  out = new;
+
+  for (in = old; *in != '\0'; in++)
     {
-      g_warning ("Error replacing string: %s", error->message);
-      g_error_free (error);
-      return g_strdup (old);
+      if (*in == ' ' || *in == '\t' || *in == '\n' || *in == '\r')
+        {
+          if (!in_space)
+            *out++ = ' ';
+          in_space = TRUE;
+        }
+      else
+        {
+          *out++ = *in;
+          in_space = FALSE;
+        }
     }
+  *out = '\0';
 
   return new;
 }
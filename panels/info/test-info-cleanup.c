@@ -75,6 +75,52 @@ test_info (void)
 	g_free (contents);
 }
 
+/* Strings as reported by /proc/cpuinfo and the GL renderer on real machines */
+static const char *perf_corpus[] = {
+	"Intel(R) Core(TM) i7-6700HQ CPU @ 2.60GHz",
+	"Intel(R) Core(TM) i5-4590T CPU @ 2.00GHz",
+	"Intel(R) Atom(TM) CPU  N270   @ 1.60GHz",
+	"Intel(R) Xeon(R) CPU E5-2680 v4 @ 2.40GHz",
+	"AMD Ryzen 7 1700X Eight-Core Processor",
+	"AMD A10-7850K Radeon R7, 12 Compute Cores 4C+8G",
+	"ARMv7 Processor rev 10 (v7l)",
+	"Mesa DRI Intel(R) Haswell Mobile ",
+	"Mesa DRI Intel(R) HD Graphics 520 (Skylake GT2) ",
+	"Mesa DRI Intel(R) Ivybridge Desktop ",
+	"Intel(R) 82945G/GZ Graphics Controller",
+	"Gallium 0.4 on AMD KAVERI (DRM 2.48.0 / 4.9.0-0.rc4.git2.2.fc26.x86_64, LLVM3)",
+	"Gallium 0.4 on AMD POLARIS10 (DRM 3.9.0 / 4.10.0-rc5, LLVM 3.9.1)",
+	"AMD Radeon (TM) RX 480 Graphics (POLARIS10 / DRM 3.18.0 / 4.11.0, LLVM 4.0.0)",
+	"Gallium 0.4 on NV117",
+	"GeForce GTX 1060 6GB/PCIe/SSE2",
+	"llvmpipe (LLVM 3.9, 256 bits)",
+	"Gallium 0.4 on SVGA3D; build: RELEASE;  LLVM;",
+};
+
+static void
+test_info_perf (void)
+{
+	GTimer *timer;
+	guint iterations = 10000;
+	guint i, j;
+	gdouble elapsed;
+
+	if (!g_test_perf ())
+		iterations = 100;
+
+	timer = g_timer_new ();
+	for (i = 0; i < iterations; i++) {
+		for (j = 0; j < G_N_ELEMENTS (perf_corpus); j++)
+			g_free (info_cleanup (perf_corpus[j]));
+	}
+	elapsed = g_timer_elapsed (timer, NULL);
+	g_timer_destroy (timer);
+
+	g_test_minimized_result (elapsed * G_USEC_PER_SEC / (iterations * G_N_ELEMENTS (perf_corpus)),
+				 "%u strings cleaned up in %.3f s",
+				 iterations * (guint) G_N_ELEMENTS (perf_corpus), elapsed);
+}
+
 int main (int argc, char **argv)
 {
 	setlocale (LC_ALL, "");
@@ -83,6 +129,7 @@ int main (int argc, char **argv)
 	g_setenv ("G_DEBUG", "fatal_warnings", FALSE);
 
 	g_test_add_func ("/info/info", test_info);
+	g_test_add_func ("/info/perf", test_info_perf);
 
 	return g_test_run ();
 }
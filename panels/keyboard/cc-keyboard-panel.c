@@ -656,6 +656,28 @@ cc_keyboard_panel_constructed (GObject *object)
                               self->search_bar);
 }
 
+/* The toplevel outlives the panel while it is cached, and would keep
+ * feeding its key presses to the hidden search bar */
+static void
+cc_keyboard_panel_suspend (CcPanel *panel)
+{
+  CcKeyboardPanel *self = CC_KEYBOARD_PANEL (panel);
+  GtkWidget *window;
+
+  window = cc_shell_get_toplevel (cc_panel_get_shell (panel));
+  g_signal_handler_block (window, self->search_bar_handler_id);
+}
+
+static void
+cc_keyboard_panel_resume (CcPanel *panel)
+{
+  CcKeyboardPanel *self = CC_KEYBOARD_PANEL (panel);
+  GtkWidget *window;
+
+  window = cc_shell_get_toplevel (cc_panel_get_shell (panel));
+  g_signal_handler_unblock (window, self->search_bar_handler_id);
+}
+
 static void
 cc_keyboard_panel_class_init (CcKeyboardPanelClass *klass)
 {
@@ -664,6 +686,8 @@ cc_keyboard_panel_class_init (CcKeyboardPanelClass *klass)
   CcPanelClass *panel_class = CC_PANEL_CLASS (klass);
 
   panel_class->get_help_uri = cc_keyboard_panel_get_help_uri;
+  panel_class->suspend = cc_keyboard_panel_suspend;
+  panel_class->resume = cc_keyboard_panel_resume;
 
   object_class->set_property = cc_keyboard_panel_set_property;
   object_class->finalize = cc_keyboard_panel_finalize;
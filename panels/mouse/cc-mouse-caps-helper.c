@@ -18,72 +18,158 @@
  * Author: Felipe Borges <feborges@redhat.com>
  */
 
+#include <string.h>
 #include <gdk/gdkx.h>
 #include <X11/Xatom.h>
 #include <X11/extensions/XInput2.h>
 
 #include "cc-mouse-caps-helper.h"
 
-static gboolean
-touchpad_check_capabilities_x11 (gboolean *have_two_finger_scrolling,
-                                 gboolean *have_edge_scrolling,
-                                 gboolean *have_tap_to_click)
+/* Capabilities of a touchpad, cached by XInput device ID for as long as
+ * the device is plugged in. The cache is shared by every panel in the
+ * process, so each device only costs a couple of round-trips once. */
+typedef struct {
+        gboolean have_synaptics;
+        gboolean have_two_finger_scrolling;
+        gboolean have_edge_scrolling;
+        gboolean have_tap_to_click;
+} TouchpadCaps;
+
+enum {
+        PROP_SCROLL_METHODS,
+        PROP_TAPPING_ENABLED,
+        PROP_SYNAPTICS_CAPABILITIES,
+        N_PROPS
+};
+
+static char *prop_names[N_PROPS] = {
+        "libinput Scroll Methods Available",
+        "libinput Tapping Enabled",
+        "Synaptics Capabilities"
+};
+
+static Atom props[N_PROPS];
+static GHashTable *caps_cache = NULL;
+
+static void
+seat_device_removed (GdkSeat   *seat,
+                     GdkDevice *device,
+                     gpointer   user_data)
 {
+        g_hash_table_remove (caps_cache,
+                             GINT_TO_POINTER (gdk_x11_device_get_id (device)));
+}
+
+static TouchpadCaps *
+probe_touchpad (Display *display,
+                int      device_id)
+{
+        TouchpadCaps *caps;
+        gboolean have_scroll_methods = FALSE;
+        Atom *device_props;
+        int n_device_props, i;
+        Atom realtype;
+        int realformat;
+        unsigned long nitems, bytes_after;
+        unsigned char *data;
+
+        caps = g_new0 (TouchpadCaps, 1);
+
+        /* A single request tells which properties the device has; only
+         * the available scroll methods need their value fetched. */
+        device_props = XIListProperties (display, device_id, &n_device_props);
+        for (i = 0; i < n_device_props; i++) {
+                if (device_props[i] == props[PROP_SCROLL_METHODS])
+                        have_scroll_methods = TRUE;
+                else if (device_props[i] == props[PROP_TAPPING_ENABLED])
+                        caps->have_tap_to_click = TRUE;
+                else if (device_props[i] == props[PROP_SYNAPTICS_CAPABILITIES])
+                        caps->have_synaptics = TRUE;
+        }
+        if (device_props)
+                XFree (device_props);
+
+        /* xorg-x11-drv-libinput */
+        if (have_scroll_methods &&
+            (XIGetProperty (display, device_id, props[PROP_SCROLL_METHODS],
+                            0, 2, False, XA_INTEGER, &realtype, &realformat, &nitems,
+                            &bytes_after, &data) == Success) && (realtype != None)) {
+                /* Property data is booleans for two-finger, edge, on-button scroll available. */
+                if (nitems >= 2) {
+                        caps->have_two_finger_scrolling = data[0] != 0;
+                        caps->have_edge_scrolling = data[1] != 0;
+                }
+
+                XFree (data);
+        }
+
+        return caps;
+}
+
+/* Fills @result with the union of the capabilities of all the touchpads */
+static void
+touchpad_get_capabilities_x11 (TouchpadCaps *result)
+{
+        GdkDisplay *gdk_display;
+        GdkSeat *seat;
         Display *display;
-	GList *devicelist, *l;
-	Atom realtype, prop_scroll_methods, prop_tapping_enabled;
-	int realformat;
-	unsigned long nitems, bytes_after;
-	unsigned char *data;
-
-        display = GDK_DISPLAY_XDISPLAY (gdk_display_get_default ());
-	prop_scroll_methods = XInternAtom (display, "libinput Scroll Methods Available", False);
-	prop_tapping_enabled = XInternAtom (display, "libinput Tapping Enabled", False);
-	if (!prop_scroll_methods || !prop_tapping_enabled)
-		return FALSE;
-
-	*have_two_finger_scrolling = FALSE;
-	*have_edge_scrolling = FALSE;
-	*have_tap_to_click = FALSE;
+        GList *devicelist, *l;
 
-        gdk_error_trap_push ();
+        gdk_display = gdk_display_get_default ();
+        display = GDK_DISPLAY_XDISPLAY (gdk_display);
+        seat = gdk_display_get_default_seat (gdk_display);
 
-	devicelist = gdk_seat_get_slaves (gdk_display_get_default_seat (gdk_display_get_default ()),
-                                          GDK_SEAT_CAPABILITY_ALL_POINTING);
-	for (l = devicelist; l != NULL; l = l->next) {
-                GdkDevice *device = l->data;
-                if (gdk_device_get_source (device) != GDK_SOURCE_TOUCHPAD)
-			continue;
+        if (!caps_cache) {
+                caps_cache = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+                XInternAtoms (display, prop_names, N_PROPS, False, props);
+                g_signal_connect (seat, "device-removed",
+                                  G_CALLBACK (seat_device_removed), NULL);
+        }
 
-		/* xorg-x11-drv-libinput */
-		if ((XIGetProperty (display, gdk_x11_device_get_id (device), prop_scroll_methods,
-                                    0, 2, False, XA_INTEGER, &realtype, &realformat, &nitems,
-                                    &bytes_after, &data) == Success) && (realtype != None)) {
-			/* Property data is booleans for two-finger, edge, on-button scroll available. */
+        memset (result, 0, sizeof (TouchpadCaps));
 
-			if (data[0])
-				*have_two_finger_scrolling = TRUE;
+        gdk_error_trap_push ();
 
-			if (data[1])
-				*have_edge_scrolling = TRUE;
+        devicelist = gdk_seat_get_slaves (seat, GDK_SEAT_CAPABILITY_ALL_POINTING);
+        for (l = devicelist; l != NULL; l = l->next) {
+                GdkDevice *device = l->data;
+                TouchpadCaps *caps;
+                int device_id;
 
-			XFree (data);
-		}
+                if (gdk_device_get_source (device) != GDK_SOURCE_TOUCHPAD)
+                        continue;
 
-		if ((XIGetProperty (display, gdk_x11_device_get_id (device), prop_tapping_enabled,
-                                    0, 1, False, XA_INTEGER, &realtype, &realformat, &nitems,
-                                    &bytes_after, &data) == Success) && (realtype != None)) {
-			/* Property data is boolean for tapping enabled. */
-			*have_tap_to_click = TRUE;
+                device_id = gdk_x11_device_get_id (device);
+                caps = g_hash_table_lookup (caps_cache, GINT_TO_POINTER (device_id));
+                if (!caps) {
+                        caps = probe_touchpad (display, device_id);
+                        g_hash_table_insert (caps_cache, GINT_TO_POINTER (device_id), caps);
+                }
 
-			XFree (data);
-		}
-	}
+                result->have_synaptics |= caps->have_synaptics;
+                result->have_two_finger_scrolling |= caps->have_two_finger_scrolling;
+                result->have_edge_scrolling |= caps->have_edge_scrolling;
+                result->have_tap_to_click |= caps->have_tap_to_click;
+        }
         g_list_free (devicelist);
 
         gdk_error_trap_pop_ignored ();
+}
+
+static gboolean
+touchpad_check_capabilities_x11 (gboolean *have_two_finger_scrolling,
+                                 gboolean *have_edge_scrolling,
+                                 gboolean *have_tap_to_click)
+{
+        TouchpadCaps caps;
+
+        touchpad_get_capabilities_x11 (&caps);
 
-	return TRUE;
+        *have_two_finger_scrolling = caps.have_two_finger_scrolling;
+        *have_edge_scrolling = caps.have_edge_scrolling;
+        *have_tap_to_click = caps.have_tap_to_click;
+
+        return TRUE;
 }
 
 gboolean
@@ -105,42 +191,12 @@ cc_touchpad_check_capabilities (gboolean *have_two_finger_scrolling,
 gboolean
 cc_synaptics_check (void)
 {
-        Display *display;
-        GList *devicelist, *l;
-        Atom prop, realtype;
-        int realformat;
-        unsigned long nitems, bytes_after;
-        unsigned char *data;
-        gboolean have_synaptics = FALSE;
+        TouchpadCaps caps;
 
         if (!GDK_IS_X11_DISPLAY (gdk_display_get_default ()))
                 return FALSE;
 
-        display = GDK_DISPLAY_XDISPLAY (gdk_display_get_default ());
-        prop = XInternAtom (display, "Synaptics Capabilities", False);
-
-        gdk_error_trap_push ();
-
-        devicelist = gdk_seat_get_slaves (gdk_display_get_default_seat (gdk_display_get_default ()),
-                                          GDK_SEAT_CAPABILITY_ALL_POINTING);
-        for (l = devicelist; l != NULL; l = l->next) {
-                GdkDevice *device = l->data;
-                if (gdk_device_get_source (device) != GDK_SOURCE_TOUCHPAD)
-			continue;
-
-                if ((XIGetProperty (display, gdk_x11_device_get_id (device), prop,
-                                    0, 2, False, XA_INTEGER, &realtype, &realformat, &nitems,
-                                    &bytes_after, &data) == Success) && (realtype != None)) {
-                        have_synaptics = TRUE;
-                        XFree (data);
-                }
-
-                if (have_synaptics)
-                        break;
-        }
-        g_list_free (devicelist);
-
-        gdk_error_trap_pop_ignored ();
+        touchpad_get_capabilities_x11 (&caps);
 
-        return have_synaptics;
+        return caps.have_synaptics;
 }
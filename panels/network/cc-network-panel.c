@@ -32,6 +32,7 @@
 #include "net-device-mobile.h"
 #include "net-device-wifi.h"
 #include "net-device-ethernet.h"
+#include "net-mobile-providers.h"
 #include "net-object.h"
 #include "net-proxy.h"
 #include "net-vpn.h"
@@ -62,9 +63,11 @@ struct _CcNetworkPanelPrivate
         GCancellable     *cancellable;
         GtkBuilder       *builder;
         GtkWidget        *treeview;
+        GHashTable       *rows;             /* NetObject ID → GtkTreeRowReference */
         NMClient         *client;
         MMManager        *modem_manager;
         gboolean          updating_device;
+        gint64            bootstrap_time;
 
         /* Killswitch stuff */
         GDBusProxy       *rfkill_proxy;
@@ -90,6 +93,7 @@ enum {
 };
 
 static NetObject *find_in_model_by_id (CcNetworkPanel *panel, const gchar *id, GtkTreeIter *iter_out);
+static void panel_track_row (CcNetworkPanel *panel, NetObject *object, GtkTreeIter *iter);
 static void handle_argv (CcNetworkPanel *panel);
 
 static void
@@ -221,6 +225,7 @@ cc_network_panel_dispose (GObject *object)
 
         g_clear_object (&priv->cancellable);
         g_clear_object (&priv->rfkill_proxy);
+        g_clear_pointer (&priv->rows, g_hash_table_destroy);
         g_clear_object (&priv->builder);
         g_clear_object (&priv->client);
         g_clear_object (&priv->modem_manager);
@@ -435,39 +440,29 @@ select_tree_iter (CcNetworkPanel *panel, GtkTreeIter *iter)
 }
 
 static void
-object_removed_cb (NetObject *object, CcNetworkPanel *panel)
+panel_remove_row (CcNetworkPanel *panel, const gchar *id, gboolean select_first)
 {
-        gboolean ret;
-        NetObject *object_tmp;
         GtkTreeIter iter;
         GtkTreeModel *model;
         GtkTreeSelection *selection;
 
-        selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (panel->priv->treeview));
+        if (find_in_model_by_id (panel, id, &iter) == NULL)
+                return;
 
-        /* remove device from model */
         model = GTK_TREE_MODEL (gtk_builder_get_object (panel->priv->builder,
                                                         "liststore_devices"));
-        ret = gtk_tree_model_get_iter_first (model, &iter);
-        if (!ret)
-                return;
+        g_hash_table_remove (panel->priv->rows, id);
+        if (gtk_list_store_remove (GTK_LIST_STORE (model), &iter) && select_first) {
+                selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (panel->priv->treeview));
+                if (gtk_tree_model_get_iter_first (model, &iter))
+                        gtk_tree_selection_select_iter (selection, &iter);
+        }
+}
 
-        /* get the other elements */
-        do {
-                gtk_tree_model_get (model, &iter,
-                                    PANEL_DEVICES_COLUMN_OBJECT, &object_tmp,
-                                    -1);
-                if (g_strcmp0 (net_object_get_id (object),
-                               net_object_get_id (object_tmp)) == 0) {
-                        g_object_unref (object_tmp);
-                        if (gtk_list_store_remove (GTK_LIST_STORE (model), &iter)) {
-                                if (gtk_tree_model_get_iter_first (model, &iter))
-                                        gtk_tree_selection_select_iter (selection, &iter);
-                        }
-                        break;
-                }
-                g_object_unref (object_tmp);
-        } while (gtk_tree_model_iter_next (model, &iter));
+static void
+object_removed_cb (NetObject *object, CcNetworkPanel *panel)
+{
+        panel_remove_row (panel, net_object_get_id (object), TRUE);
 }
 
 GPtrArray *
@@ -731,6 +726,40 @@ state_changed_cb (NMDevice *device,
                            -1);
 }
 
+static void
+panel_setup_modem_object (CcNetworkPanel *panel,
+                          NetDevice      *net_device)
+{
+        CcNetworkPanelPrivate *priv = panel->priv;
+        GDBusObject *modem_object;
+        NMDevice *device;
+
+        device = net_device_get_nm_device (net_device);
+        if (!g_str_has_prefix (nm_device_get_udi (device), "/org/freedesktop/ModemManager1/Modem/"))
+                return;
+
+        /* This is done again once ModemManager answers */
+        if (priv->modem_manager == NULL) {
+                g_debug ("Not grabbing information for modem at %s yet: No ModemManager support",
+                         nm_device_get_udi (device));
+                return;
+        }
+
+        modem_object = g_dbus_object_manager_get_object (G_DBUS_OBJECT_MANAGER (priv->modem_manager),
+                                                         nm_device_get_udi (device));
+        if (modem_object == NULL) {
+                g_warning ("Cannot grab information for modem at %s: Not found",
+                           nm_device_get_udi (device));
+                return;
+        }
+
+        /* Set the modem object in the NetDeviceMobile */
+        g_object_set (net_device,
+                      "mm-object", modem_object,
+                      NULL);
+        g_object_unref (modem_object);
+}
+
 static gboolean
 panel_add_device (CcNetworkPanel *panel, NMDevice *device)
 {
@@ -790,30 +819,8 @@ panel_add_device (CcNetworkPanel *panel, NMDevice *device)
                                    "id", nm_device_get_udi (device),
                                    NULL);
 
-        if (type == NM_DEVICE_TYPE_MODEM &&
-            g_str_has_prefix (nm_device_get_udi (device), "/org/freedesktop/ModemManager1/Modem/")) {
-                GDBusObject *modem_object;
-
-                if (priv->modem_manager == NULL) {
-                        g_warning ("Cannot grab information for modem at %s: No ModemManager support",
-                                   nm_device_get_udi (device));
-                        goto out;
-                }
-
-                modem_object = g_dbus_object_manager_get_object (G_DBUS_OBJECT_MANAGER (priv->modem_manager),
-                                                                 nm_device_get_udi (device));
-                if (modem_object == NULL) {
-                        g_warning ("Cannot grab information for modem at %s: Not found",
-                                   nm_device_get_udi (device));
-                        goto out;
-                }
-
-                /* Set the modem object in the NetDeviceMobile */
-                g_object_set (net_device,
-                              "mm-object", modem_object,
-                              NULL);
-                g_object_unref (modem_object);
-        }
+        if (type == NM_DEVICE_TYPE_MODEM)
+                panel_setup_modem_object (panel, net_device);
 
         /* add as a panel */
         if (device_g_type != NET_TYPE_DEVICE) {
@@ -836,6 +843,7 @@ panel_add_device (CcNetworkPanel *panel, NMDevice *device)
                             PANEL_DEVICES_COLUMN_ICON, panel_device_to_icon_name (device, TRUE),
                             PANEL_DEVICES_COLUMN_OBJECT, net_device,
                             -1);
+        panel_track_row (panel, NET_OBJECT (net_device), &iter);
         g_signal_connect (net_device, "notify::title",
                           G_CALLBACK (panel_net_object_notify_title_cb), panel);
 
@@ -850,31 +858,7 @@ out:
 static void
 panel_remove_device (CcNetworkPanel *panel, NMDevice *device)
 {
-        gboolean ret;
-        NetObject *object_tmp;
-        GtkTreeIter iter;
-        GtkTreeModel *model;
-
-        /* remove device from model */
-        model = GTK_TREE_MODEL (gtk_builder_get_object (panel->priv->builder,
-                                                        "liststore_devices"));
-        ret = gtk_tree_model_get_iter_first (model, &iter);
-        if (!ret)
-                return;
-
-        /* get the other elements */
-        do {
-                gtk_tree_model_get (model, &iter,
-                                    PANEL_DEVICES_COLUMN_OBJECT, &object_tmp,
-                                    -1);
-                if (g_strcmp0 (net_object_get_id (object_tmp),
-                               nm_device_get_udi (device)) == 0) {
-                        gtk_list_store_remove (GTK_LIST_STORE (model), &iter);
-                        g_object_unref (object_tmp);
-                        break;
-                }
-                g_object_unref (object_tmp);
-        } while (gtk_tree_model_iter_next (model, &iter));
+        panel_remove_row (panel, nm_device_get_udi (device), FALSE);
 }
 
 static void
@@ -1018,6 +1002,7 @@ panel_add_proxy_device (CcNetworkPanel *panel)
                             PANEL_DEVICES_COLUMN_ICON, "preferences-system-network-symbolic",
                             PANEL_DEVICES_COLUMN_OBJECT, proxy,
                             -1);
+        panel_track_row (panel, NET_OBJECT (proxy), &iter);
 
         /* NOTE: No connect to notify::title here as it is guaranteed to not
          *       be changed by anyone.*/
@@ -1090,6 +1075,7 @@ manager_running (NMClient *client, GParamSpec *pspec, gpointer user_data)
                 g_debug ("NM disappeared");
                 liststore_devices = GTK_LIST_STORE (gtk_builder_get_object (panel->priv->builder,
                                                     "liststore_devices"));
+                g_hash_table_remove_all (panel->priv->rows);
                 gtk_list_store_clear (liststore_devices);
                 panel_add_proxy_device (panel);
                 goto out;
@@ -1120,38 +1106,54 @@ out:
 static NetObject *
 find_in_model_by_id (CcNetworkPanel *panel, const gchar *id, GtkTreeIter *iter_out)
 {
-        gboolean ret;
-        NetObject *object_tmp;
+        GtkTreeRowReference *reference;
+        GtkTreePath *path;
         GtkTreeIter iter;
         GtkTreeModel *model;
-        NetObject *object = NULL;
+        NetObject *object;
 
-        /* find in model */
-        model = GTK_TREE_MODEL (gtk_builder_get_object (panel->priv->builder,
-                                                        "liststore_devices"));
-        ret = gtk_tree_model_get_iter_first (model, &iter);
-        if (!ret)
-                goto out;
+        if (id == NULL)
+                return NULL;
+
+        reference = g_hash_table_lookup (panel->priv->rows, id);
+        if (reference == NULL || !gtk_tree_row_reference_valid (reference))
+                return NULL;
+
+        model = gtk_tree_row_reference_get_model (reference);
+        path = gtk_tree_row_reference_get_path (reference);
+        gtk_tree_model_get_iter (model, &iter, path);
+        gtk_tree_path_free (path);
+
+        gtk_tree_model_get (model, &iter,
+                            PANEL_DEVICES_COLUMN_OBJECT, &object,
+                            -1);
+        g_object_unref (object);
 
-        /* get the other elements */
-        ret = FALSE;
-        do {
-                gtk_tree_model_get (model, &iter,
-                                    PANEL_DEVICES_COLUMN_OBJECT, &object_tmp,
-                                    -1);
-                if (object_tmp != NULL) {
-                        g_debug ("got %s", net_object_get_id (object_tmp));
-                        if (g_strcmp0 (net_object_get_id (object_tmp), id) == 0)
-                                object = object_tmp;
-                        g_object_unref (object_tmp);
-                }
-        } while (object == NULL && gtk_tree_model_iter_next (model, &iter));
-out:
         if (iter_out)
                 *iter_out = iter;
         return object;
 }
 
+/* Keeps a reference to the row of @object, to find it by ID without
+ * going through the whole model; the rows move as the model is sorted */
+static void
+panel_track_row (CcNetworkPanel *panel, NetObject *object, GtkTreeIter *iter)
+{
+        GtkTreeModel *model;
+        GtkTreePath *path;
+
+        if (net_object_get_id (object) == NULL)
+                return;
+
+        model = GTK_TREE_MODEL (gtk_builder_get_object (panel->priv->builder,
+                                                        "liststore_devices"));
+        path = gtk_tree_model_get_path (model, iter);
+        g_hash_table_insert (panel->priv->rows,
+                             g_strdup (net_object_get_id (object)),
+                             gtk_tree_row_reference_new (model, path));
+        gtk_tree_path_free (path);
+}
+
 static void
 panel_add_vpn_device (CcNetworkPanel *panel, NMConnection *connection)
 {
@@ -1199,6 +1201,7 @@ panel_add_vpn_device (CcNetworkPanel *panel, NMConnection *connection)
                             PANEL_DEVICES_COLUMN_ICON, "network-vpn-symbolic",
                             PANEL_DEVICES_COLUMN_OBJECT, net_vpn,
                             -1);
+        panel_track_row (panel, NET_OBJECT (net_vpn), &iter);
         g_signal_connect (net_vpn, "notify::title",
                           G_CALLBACK (panel_net_object_notify_title_cb), panel);
 
@@ -1319,7 +1322,145 @@ on_toplevel_map (GtkWidget      *widget,
 {
         /* is the user compiling against a new version, but not running
          * the daemon? */
-        panel_check_network_manager_version (panel);
+        if (panel->priv->client != NULL)
+                panel_check_network_manager_version (panel);
+}
+
+/* Logs how long after the panel was created each of the services it
+ * depends on was ready, to find out which ones slow it down */
+static void
+bootstrap_stage_done (CcNetworkPanel *panel,
+                      const gchar    *stage)
+{
+        g_debug ("%s ready after %.1f ms", stage,
+                 (g_get_monotonic_time () - panel->priv->bootstrap_time) / 1000.0);
+}
+
+static void
+modem_manager_ready_cb (GObject      *source_object,
+                        GAsyncResult *res,
+                        gpointer      user_data)
+{
+        CcNetworkPanel *panel;
+        MMManager *modem_manager;
+        GtkTreeModel *model;
+        GtkTreeIter iter;
+        GError *error = NULL;
+        gboolean ret;
+
+        modem_manager = mm_manager_new_finish (res, &error);
+        if (modem_manager == NULL) {
+                if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+                        g_warning ("Error connecting to ModemManager: %s",
+                                   error->message);
+                g_error_free (error);
+                return;
+        }
+
+        panel = CC_NETWORK_PANEL (user_data);
+        panel->priv->modem_manager = modem_manager;
+        bootstrap_stage_done (panel, "ModemManager");
+
+        /* the modems that were added before ModemManager answered */
+        model = GTK_TREE_MODEL (gtk_builder_get_object (panel->priv->builder,
+                                                        "liststore_devices"));
+        ret = gtk_tree_model_get_iter_first (model, &iter);
+        while (ret) {
+                NetObject *object;
+
+                gtk_tree_model_get (model, &iter,
+                                    PANEL_DEVICES_COLUMN_OBJECT, &object,
+                                    -1);
+                if (NET_IS_DEVICE_MOBILE (object))
+                        panel_setup_modem_object (panel, NET_DEVICE (object));
+                g_object_unref (object);
+
+                ret = gtk_tree_model_iter_next (model, &iter);
+        }
+}
+
+static void
+system_bus_ready_cb (GObject      *source_object,
+                     GAsyncResult *res,
+                     gpointer      user_data)
+{
+        CcNetworkPanel *panel;
+        GDBusConnection *system_bus;
+        GError *error = NULL;
+
+        system_bus = g_bus_get_finish (res, &error);
+        if (system_bus == NULL) {
+                if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+                        g_warning ("Error connecting to system D-Bus: %s",
+                                   error->message);
+                g_error_free (error);
+                return;
+        }
+
+        panel = CC_NETWORK_PANEL (user_data);
+        bootstrap_stage_done (panel, "System bus");
+
+        mm_manager_new (system_bus,
+                        G_DBUS_OBJECT_MANAGER_CLIENT_FLAGS_NONE,
+                        panel->priv->cancellable,
+                        modem_manager_ready_cb,
+                        panel);
+        g_object_unref (system_bus);
+}
+
+static void
+client_ready_cb (GObject      *source_object,
+                 GAsyncResult *res,
+                 gpointer      user_data)
+{
+        CcNetworkPanel *panel;
+        NMClient *client;
+        const GPtrArray *connections;
+        GtkWidget *widget;
+        GError *error = NULL;
+        guint i;
+
+        client = nm_client_new_finish (res, &error);
+        if (client == NULL) {
+                if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+                        g_warning ("Error connecting to NetworkManager: %s",
+                                   error->message);
+                g_error_free (error);
+                return;
+        }
+
+        panel = CC_NETWORK_PANEL (user_data);
+        panel->priv->client = client;
+        bootstrap_stage_done (panel, "NetworkManager client");
+
+        g_signal_connect (panel->priv->client, "notify::nm-running" ,
+                          G_CALLBACK (manager_running), panel);
+        g_signal_connect (panel->priv->client, "notify::active-connections",
+                          G_CALLBACK (active_connections_changed), panel);
+        g_signal_connect (panel->priv->client, "device-added",
+                          G_CALLBACK (device_added_cb), panel);
+        g_signal_connect (panel->priv->client, "device-removed",
+                          G_CALLBACK (device_removed_cb), panel);
+
+        /* add remote settings such as VPN settings as virtual devices */
+        g_signal_connect (panel->priv->client, NM_CLIENT_CONNECTION_ADDED,
+                          G_CALLBACK (notify_connection_added_cb), panel);
+
+        widget = GTK_WIDGET (gtk_builder_get_object (panel->priv->builder,
+                                                     "add_toolbutton"));
+        gtk_widget_set_sensitive (widget, TRUE);
+
+        /* Cold-plug existing connections */
+        connections = nm_client_get_connections (panel->priv->client);
+        for (i = 0; i < connections->len; i++)
+                add_connection (panel, connections->pdata[i]);
+
+        g_debug ("Calling handle_argv() after cold-plugging connections");
+        handle_argv (panel);
+
+        /* the devices are added once the panel is shown */
+        if (gtk_widget_get_mapped (GTK_WIDGET (panel)))
+                panel_check_network_manager_version (panel);
 }
 
 static void
@@ -1330,12 +1471,12 @@ cc_network_panel_init (CcNetworkPanel *panel)
         GtkTreeSelection *selection;
         GtkWidget *widget;
         GtkWidget *toplevel;
-        GDBusConnection *system_bus;
         GtkCssProvider *provider;
-        const GPtrArray *connections;
-        guint i;
 
         panel->priv = NETWORK_PANEL_PRIVATE (panel);
+        panel->priv->bootstrap_time = g_get_monotonic_time ();
+        panel->priv->rows = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                                   (GDestroyNotify) gtk_tree_row_reference_free);
         g_resources_register (cc_network_get_resource ());
 
         panel->priv->builder = gtk_builder_new ();
@@ -1350,6 +1491,10 @@ cc_network_panel_init (CcNetworkPanel *panel)
 
         panel->priv->cancellable = g_cancellable_new ();
 
+        /* Parsing the operator names takes a while, so don't wait for a
+         * modem to show up before starting */
+        net_mobile_providers_load_async (panel->priv->cancellable, NULL, NULL);
+
         panel->priv->treeview = GTK_WIDGET (gtk_builder_get_object (panel->priv->builder,
                                                                     "treeview_devices"));
         panel_add_devices_columns (panel, GTK_TREE_VIEW (panel->priv->treeview));
@@ -1372,40 +1517,17 @@ cc_network_panel_init (CcNetworkPanel *panel)
         /* add the virtual proxy device */
         panel_add_proxy_device (panel);
 
-        /* use NetworkManager client */
-        panel->priv->client = nm_client_new (NULL, NULL);
-        g_signal_connect (panel->priv->client, "notify::nm-running" ,
-                          G_CALLBACK (manager_running), panel);
-        g_signal_connect (panel->priv->client, "notify::active-connections",
-                          G_CALLBACK (active_connections_changed), panel);
-        g_signal_connect (panel->priv->client, "device-added",
-                          G_CALLBACK (device_added_cb), panel);
-        g_signal_connect (panel->priv->client, "device-removed",
-                          G_CALLBACK (device_removed_cb), panel);
-
-        /* Setup ModemManager client */
-        system_bus = g_bus_get_sync (G_BUS_TYPE_SYSTEM, NULL, &error);
-        if (system_bus == NULL) {
-                g_warning ("Error connecting to system D-Bus: %s",
-                           error->message);
-                g_clear_error (&error);
-        } else {
-                panel->priv->modem_manager = mm_manager_new_sync (system_bus,
-                                                                  G_DBUS_OBJECT_MANAGER_CLIENT_FLAGS_NONE,
-                                                                  NULL,
-                                                                  &error);
-                if (panel->priv->modem_manager == NULL) {
-                        g_warning ("Error connecting to ModemManager: %s",
-                                   error->message);
-                        g_clear_error (&error);
-                }
-                g_object_unref (system_bus);
-        }
+        /* The devices and connections show up as the services answer,
+         * which can take a while on a busy system bus */
+        nm_client_new_async (panel->priv->cancellable, client_ready_cb, panel);
+        g_bus_get (G_BUS_TYPE_SYSTEM, panel->priv->cancellable,
+                   system_bus_ready_cb, panel);
 
         widget = GTK_WIDGET (gtk_builder_get_object (panel->priv->builder,
                                                      "add_toolbutton"));
         g_signal_connect (widget, "clicked",
                           G_CALLBACK (add_connection_cb), panel);
+        gtk_widget_set_sensitive (widget, FALSE);
 
         /* disable for now, until we actually show removable connections */
         widget = GTK_WIDGET (gtk_builder_get_object (panel->priv->builder,
@@ -1413,10 +1535,6 @@ cc_network_panel_init (CcNetworkPanel *panel)
         g_signal_connect (widget, "clicked",
                           G_CALLBACK (remove_connection), panel);
 
-        /* add remote settings such as VPN settings as virtual devices */
-        g_signal_connect (panel->priv->client, NM_CLIENT_CONNECTION_ADDED,
-                          G_CALLBACK (notify_connection_added_cb), panel);
-
         toplevel = gtk_widget_get_toplevel (GTK_WIDGET (panel));
         g_signal_connect_after (toplevel, "map", G_CALLBACK (on_toplevel_map), panel);
 
@@ -1435,12 +1553,4 @@ cc_network_panel_init (CcNetworkPanel *panel)
                                                    GTK_STYLE_PROVIDER (provider),
                                                    GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
         g_object_unref (provider);
-
-        /* Cold-plug existing connections */
-        connections = nm_client_get_connections (panel->priv->client);
-        for (i = 0; i < connections->len; i++)
-                add_connection (panel, connections->pdata[i]);
-
-        g_debug ("Calling handle_argv() after cold-plugging connections");
-        handle_argv (panel);
 }
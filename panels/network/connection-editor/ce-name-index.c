@@ -0,0 +1,163 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2017 Red Hat, Inc
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+
+#include <glib/gi18n.h>
+
+#include "ce-name-index.h"
+
+/* Keeps the names of the existing connections, to find unused ones
+ * without going through all of them for every candidate. Several
+ * connections can have the same name, so the names are counted. */
+struct _CENameIndex {
+        GHashTable *owners;     /* owner → name */
+        GHashTable *names;      /* name → number of owners */
+
+        /* format → lowest suffix that may be free, so that allocating
+         * names one after the other does not try the taken ones again */
+        GHashTable *hints;
+};
+
+CENameIndex *
+ce_name_index_new (void)
+{
+        CENameIndex *index;
+
+        index = g_slice_new0 (CENameIndex);
+        index->owners = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+        index->names = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+        index->hints = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+        return index;
+}
+
+void
+ce_name_index_free (CENameIndex *index)
+{
+        g_hash_table_destroy (index->owners);
+        g_hash_table_destroy (index->names);
+        g_hash_table_destroy (index->hints);
+        g_slice_free (CENameIndex, index);
+}
+
+static void
+add_name (CENameIndex *index,
+          const gchar *name)
+{
+        guint count;
+
+        count = GPOINTER_TO_UINT (g_hash_table_lookup (index->names, name));
+        if (count == 0)
+                g_hash_table_insert (index->names, g_strdup (name), GUINT_TO_POINTER (1));
+        else
+                g_hash_table_replace (index->names, g_strdup (name), GUINT_TO_POINTER (count + 1));
+}
+
+static void
+remove_name (CENameIndex *index,
+             const gchar *name)
+{
+        guint count;
+
+        count = GPOINTER_TO_UINT (g_hash_table_lookup (index->names, name));
+        if (count <= 1)
+                g_hash_table_remove (index->names, name);
+        else
+                g_hash_table_replace (index->names, g_strdup (name), GUINT_TO_POINTER (count - 1));
+
+        /* A lower suffix may be free now */
+        g_hash_table_remove_all (index->hints);
+}
+
+/* Records @name as the name of @owner, replacing its previous name. A
+ * %NULL @name forgets about @owner. */
+void
+ce_name_index_set (CENameIndex *index,
+                   gpointer     owner,
+                   const gchar *name)
+{
+        const gchar *old_name;
+
+        old_name = g_hash_table_lookup (index->owners, owner);
+        if (g_strcmp0 (old_name, name) == 0)
+                return;
+
+        if (old_name != NULL)
+                remove_name (index, old_name);
+
+        if (name != NULL) {
+                add_name (index, name);
+                g_hash_table_insert (index->owners, owner, g_strdup (name));
+        } else {
+                g_hash_table_remove (index->owners, owner);
+        }
+}
+
+gboolean
+ce_name_index_contains (CENameIndex *index,
+                        const gchar *name)
+{
+        return g_hash_table_contains (index->names, name);
+}
+
+static gchar *
+format_name (NameFormat   format,
+             const gchar *type_name,
+             gint         i)
+{
+        switch (format) {
+                case NAME_FORMAT_TYPE:
+                        return g_strdup_printf ("%s %d", type_name, i);
+                case NAME_FORMAT_PROFILE:
+                        return g_strdup_printf (_("Profile %d"), i);
+                default:
+                        g_assert_not_reached ();
+        }
+}
+
+/* Returns the name with the lowest suffix, starting at 1, that no
+ * connection uses */
+gchar *
+ce_name_index_get_next_available (CENameIndex *index,
+                                  NameFormat   format,
+                                  const gchar *type_name)
+{
+        gchar *key;
+        gchar *name;
+        gint i;
+
+        key = g_strdup_printf ("%d:%s", format, type_name ? type_name : "");
+        i = GPOINTER_TO_INT (g_hash_table_lookup (index->hints, key));
+        if (i == 0)
+                i = 1;
+
+        for (;; i++) {
+                name = format_name (format, type_name, i);
+                if (!g_hash_table_contains (index->names, name))
+                        break;
+                g_free (name);
+        }
+
+        g_hash_table_replace (index->hints, key, GINT_TO_POINTER (i));
+
+        return name;
+}
@@ -0,0 +1,49 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2017 Red Hat, Inc
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __CE_NAME_INDEX_H
+#define __CE_NAME_INDEX_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum {
+        NAME_FORMAT_TYPE,
+        NAME_FORMAT_PROFILE
+} NameFormat;
+
+typedef struct _CENameIndex CENameIndex;
+
+CENameIndex *ce_name_index_new                (void);
+void         ce_name_index_free               (CENameIndex *index);
+void         ce_name_index_set                (CENameIndex *index,
+                                               gpointer     owner,
+                                               const gchar *name);
+gboolean     ce_name_index_contains           (CENameIndex *index,
+                                               const gchar *name);
+gchar       *ce_name_index_get_next_available (CENameIndex *index,
+                                               NameFormat   format,
+                                               const gchar *type_name);
+
+G_END_DECLS
+
+#endif /* __CE_NAME_INDEX_H */
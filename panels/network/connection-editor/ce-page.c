@@ -489,53 +489,81 @@ ce_spin_output_with_default (GtkSpinButton *spin, gpointer user_data)
         return TRUE;
 }
 
-gchar *
-ce_page_get_next_available_name (const GPtrArray *connections,
-                                 NameFormat format,
-                                 const gchar *type_name)
+#define NAME_INDEX_KEY "ce-page-name-index"
+
+static void
+connection_changed_cb (NMConnection *connection,
+                       NMClient     *client)
 {
-        GSList *names = NULL, *l;
-        gchar *cname = NULL;
-        gint i = 0;
-        guint con_idx;
-
-        for (con_idx = 0; con_idx < connections->len; con_idx++) {
-                NMConnection *connection = g_ptr_array_index (connections, con_idx);
-                const gchar *id;
-
-                id = nm_connection_get_id (connection);
-                g_assert (id);
-                names = g_slist_append (names, (gpointer) id);
-        }
+        CENameIndex *index;
 
-        /* Find the next available unique connection name */
-        while (!cname && (i++ < 10000)) {
-                gchar *temp;
-                gboolean found = FALSE;
-
-                switch (format) {
-                        case NAME_FORMAT_TYPE:
-                                temp = g_strdup_printf ("%s %d", type_name, i);
-                                break;
-                        case NAME_FORMAT_PROFILE:
-                                temp = g_strdup_printf (_("Profile %d"), i);
-                                break;
-                        default:
-                                g_assert_not_reached ();
-                }
+        index = g_object_get_data (G_OBJECT (client), NAME_INDEX_KEY);
+        ce_name_index_set (index, connection, nm_connection_get_id (connection));
+}
 
-                for (l = names; l; l = l->next) {
-                        if (!strcmp (l->data, temp)) {
-                                found = TRUE;
-                                break;
-                        }
-                }
-                if (!found)
-                        cname = temp;
-                else
-                        g_free (temp);
-        }
-        g_slist_free (names);
+static void
+track_connection (NMClient     *client,
+                  CENameIndex  *index,
+                  NMConnection *connection)
+{
+        ce_name_index_set (index, connection, nm_connection_get_id (connection));
+
+        /* Renames don't go through the client */
+        g_signal_connect_object (connection, NM_CONNECTION_CHANGED,
+                                 G_CALLBACK (connection_changed_cb), client, 0);
+}
+
+static void
+connection_added_cb (NMClient           *client,
+                     NMRemoteConnection *connection,
+                     CENameIndex        *index)
+{
+        track_connection (client, index, NM_CONNECTION (connection));
+}
 
-        return cname;
+static void
+connection_removed_cb (NMClient           *client,
+                       NMRemoteConnection *connection,
+                       CENameIndex        *index)
+{
+        g_signal_handlers_disconnect_by_func (connection, connection_changed_cb, client);
+        ce_name_index_set (index, connection, NULL);
+}
+
+/* The names of the connections are indexed once per client, and the
+ * index is kept up to date from then on */
+static CENameIndex *
+get_name_index (NMClient *client)
+{
+        CENameIndex *index;
+        const GPtrArray *connections;
+        guint i;
+
+        index = g_object_get_data (G_OBJECT (client), NAME_INDEX_KEY);
+        if (index != NULL)
+                return index;
+
+        index = ce_name_index_new ();
+        g_object_set_data_full (G_OBJECT (client), NAME_INDEX_KEY,
+                                index, (GDestroyNotify) ce_name_index_free);
+
+        connections = nm_client_get_connections (client);
+        for (i = 0; i < connections->len; i++)
+                track_connection (client, index, g_ptr_array_index (connections, i));
+
+        g_signal_connect (client, NM_CLIENT_CONNECTION_ADDED,
+                          G_CALLBACK (connection_added_cb), index);
+        g_signal_connect (client, NM_CLIENT_CONNECTION_REMOVED,
+                          G_CALLBACK (connection_removed_cb), index);
+
+        return index;
+}
+
+gchar *
+ce_page_get_next_available_name (NMClient *client,
+                                 NameFormat format,
+                                 const gchar *type_name)
+{
+        return ce_name_index_get_next_available (get_name_index (client),
+                                                 format, type_name);
 }
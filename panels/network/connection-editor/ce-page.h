@@ -28,6 +28,8 @@
 
 #include <gtk/gtk.h>
 
+#include "ce-name-index.h"
+
 G_BEGIN_DECLS
 
 #define CE_TYPE_PAGE          (ce_page_get_type ())
@@ -97,12 +99,7 @@ gint         ce_spin_output_with_default (GtkSpinButton *spin,
 gboolean     ce_page_address_is_valid (const gchar *addr);
 gchar       *ce_page_trim_address (const gchar *addr);
 
-typedef enum {
-        NAME_FORMAT_TYPE,
-        NAME_FORMAT_PROFILE
-} NameFormat;
-
-gchar * ce_page_get_next_available_name (const GPtrArray *connections,
+gchar * ce_page_get_next_available_name (NMClient *client,
                                          NameFormat format,
                                          const gchar *type_name);
 
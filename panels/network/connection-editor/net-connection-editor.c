@@ -628,11 +628,9 @@ complete_vpn_connection (NetConnectionEditor *editor, NMConnection *connection)
         }
 
         if (!nm_setting_connection_get_id (s_con)) {
-                const GPtrArray *connections;
                 gchar *id;
 
-                connections = nm_client_get_connections (editor->client);
-                id = ce_page_get_next_available_name (connections, NAME_FORMAT_TYPE, _("VPN"));
+                id = ce_page_get_next_available_name (editor->client, NAME_FORMAT_TYPE, _("VPN"));
                 g_object_set (s_con,
                               NM_SETTING_CONNECTION_ID, id,
                               NULL);
@@ -0,0 +1,160 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2017 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include "ce-name-index.h"
+
+#define N_CONNECTIONS 12000
+
+/* The owners only need to be distinct pointers */
+#define OWNER(i) GINT_TO_POINTER ((i) + 1)
+
+static void
+assert_next_name (CENameIndex *index,
+                  const gchar *type_name,
+                  const gchar *expected)
+{
+        gchar *name;
+
+        name = ce_name_index_get_next_available (index, NAME_FORMAT_TYPE, type_name);
+        g_assert_cmpstr (name, ==, expected);
+        g_free (name);
+}
+
+static void
+test_gaps (void)
+{
+        CENameIndex *index;
+
+        index = ce_name_index_new ();
+        assert_next_name (index, "VPN", "VPN 1");
+
+        ce_name_index_set (index, OWNER (1), "VPN 1");
+        ce_name_index_set (index, OWNER (2), "VPN 2");
+        ce_name_index_set (index, OWNER (4), "VPN 4");
+        assert_next_name (index, "VPN", "VPN 3");
+
+        ce_name_index_set (index, OWNER (3), "VPN 3");
+        assert_next_name (index, "VPN", "VPN 5");
+
+        /* Other types don't get in the way */
+        assert_next_name (index, "Bond", "Bond 1");
+
+        /* Removing a connection frees its name again */
+        ce_name_index_set (index, OWNER (2), NULL);
+        assert_next_name (index, "VPN", "VPN 2");
+
+        ce_name_index_free (index);
+}
+
+static void
+test_renames (void)
+{
+        CENameIndex *index;
+
+        index = ce_name_index_new ();
+        ce_name_index_set (index, OWNER (1), "VPN 1");
+        ce_name_index_set (index, OWNER (2), "VPN 2");
+        assert_next_name (index, "VPN", "VPN 3");
+
+        ce_name_index_set (index, OWNER (1), "Office");
+        g_assert_false (ce_name_index_contains (index, "VPN 1"));
+        g_assert_true (ce_name_index_contains (index, "Office"));
+        assert_next_name (index, "VPN", "VPN 1");
+
+        ce_name_index_free (index);
+}
+
+static void
+test_duplicates (void)
+{
+        CENameIndex *index;
+
+        index = ce_name_index_new ();
+        ce_name_index_set (index, OWNER (1), "VPN 1");
+        ce_name_index_set (index, OWNER (2), "VPN 1");
+
+        /* The name is still taken as long as one connection uses it */
+        ce_name_index_set (index, OWNER (1), NULL);
+        g_assert_true (ce_name_index_contains (index, "VPN 1"));
+        assert_next_name (index, "VPN", "VPN 2");
+
+        ce_name_index_set (index, OWNER (2), NULL);
+        g_assert_false (ce_name_index_contains (index, "VPN 1"));
+        assert_next_name (index, "VPN", "VPN 1");
+
+        ce_name_index_free (index);
+}
+
+static void
+test_many_profiles (void)
+{
+        CENameIndex *index;
+        GTimer *timer;
+        gchar *name;
+        gint i;
+
+        index = ce_name_index_new ();
+
+        /* Adding profiles one after the other, as the ethernet page does */
+        timer = g_timer_new ();
+        for (i = 0; i < N_CONNECTIONS; i++) {
+                gchar *expected;
+
+                name = ce_name_index_get_next_available (index, NAME_FORMAT_PROFILE, NULL);
+                expected = g_strdup_printf ("Profile %d", i + 1);
+                g_assert_cmpstr (name, ==, expected);
+                g_free (expected);
+
+                ce_name_index_set (index, OWNER (i), name);
+                g_free (name);
+        }
+        g_test_minimized_result (g_timer_elapsed (timer, NULL) * 1000,
+                                 "Allocated %d names in %.1f ms", N_CONNECTIONS,
+                                 g_timer_elapsed (timer, NULL) * 1000);
+
+        /* More than the 10000 names the old lookup tried */
+        name = ce_name_index_get_next_available (index, NAME_FORMAT_PROFILE, NULL);
+        g_assert_cmpstr (name, ==, "Profile 12001");
+        g_free (name);
+
+        ce_name_index_set (index, OWNER (2500), NULL);
+        name = ce_name_index_get_next_available (index, NAME_FORMAT_PROFILE, NULL);
+        g_assert_cmpstr (name, ==, "Profile 2501");
+        g_free (name);
+
+        g_timer_destroy (timer);
+        ce_name_index_free (index);
+}
+
+int
+main (int argc, char **argv)
+{
+        g_test_init (&argc, &argv, NULL);
+
+        g_test_add_func ("/network/name-index/gaps", test_gaps);
+        g_test_add_func ("/network/name-index/renames", test_renames);
+        g_test_add_func ("/network/name-index/duplicates", test_duplicates);
+        g_test_add_func ("/network/name-index/many-profiles", test_many_profiles);
+
+        return g_test_run ();
+}
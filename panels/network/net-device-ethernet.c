@@ -197,7 +197,7 @@ device_state_to_off_switch (NMDeviceState state)
 }
 
 static void
-device_ethernet_refresh_ui (NetDeviceEthernet *device)
+device_ethernet_update_ui (NetDeviceEthernet *device)
 {
         NMDevice *nm_device;
         NMDeviceState state;
@@ -230,6 +230,38 @@ device_ethernet_refresh_ui (NetDeviceEthernet *device)
         populate_ui (device);
 }
 
+static gboolean
+refresh_ui_tick_cb (GtkWidget     *widget,
+                    GdkFrameClock *frame_clock,
+                    gpointer       user_data)
+{
+        NetDeviceEthernet *device = user_data;
+
+        device->refresh_id = 0;
+        g_clear_object (&device->refresh_widget);
+        device_ethernet_update_ui (device);
+
+        return G_SOURCE_REMOVE;
+}
+
+/* NetworkManager tends to send bursts of signals, for instance when a
+ * dock keeps losing its link, so they are folded into one update on the
+ * next frame */
+static void
+device_ethernet_refresh_ui (NetDeviceEthernet *device)
+{
+        GtkWidget *widget;
+
+        if (device->refresh_id != 0)
+                return;
+
+        /* the page may be destroyed with the notebook before we are */
+        widget = GTK_WIDGET (gtk_builder_get_object (device->builder, "vbox6"));
+        device->refresh_widget = g_object_ref (widget);
+        device->refresh_id = gtk_widget_add_tick_callback (widget, refresh_ui_tick_cb,
+                                                           device, NULL);
+}
+
 static void
 editor_done (NetConnectionEditor *editor,
              gboolean             success,
@@ -281,16 +313,21 @@ show_details_for_wired (GtkButton *button, NetDeviceEthernet *device)
 }
 
 static void
-add_row (NetDeviceEthernet *device, NMConnection *connection)
+update_row (NetDeviceEthernet *device, GtkWidget *row)
 {
-        GtkWidget *row;
-        GtkWidget *widget;
-        GtkWidget *box;
+        NMConnection *connection;
+        GtkWidget *label;
         GtkWidget *details;
         NMDevice *nmdev;
         NMActiveConnection *aconn;
         gboolean active;
-        GtkWidget *image;
+        GList *children, *c;
+
+        connection = g_object_get_data (G_OBJECT (row), "connection");
+
+        label = g_object_get_data (G_OBJECT (row), "label");
+        if (g_strcmp0 (gtk_label_get_label (GTK_LABEL (label)), nm_connection_get_id (connection)) != 0)
+                gtk_label_set_label (GTK_LABEL (label), nm_connection_get_id (connection));
 
         active = FALSE;
 
@@ -303,6 +340,37 @@ add_row (NetDeviceEthernet *device, NMConnection *connection)
                 active = g_strcmp0 (uuid1, uuid2) == 0;
         }
 
+        gtk_widget_set_visible (g_object_get_data (G_OBJECT (row), "check"), active);
+
+        /* only the active connection has details, and its addresses can
+         * change while it is up */
+        details = g_object_get_data (G_OBJECT (row), "details");
+        if (!active && !gtk_widget_get_visible (details))
+                return;
+
+        children = gtk_container_get_children (GTK_CONTAINER (details));
+        for (c = children; c; c = c->next) {
+                gtk_container_remove (GTK_CONTAINER (details), c->data);
+        }
+        g_list_free (children);
+
+        if (active) {
+                add_details (details, nmdev, connection);
+                gtk_widget_show_all (details);
+        } else {
+                gtk_widget_hide (details);
+        }
+}
+
+static GtkWidget *
+add_row (NetDeviceEthernet *device, NMConnection *connection)
+{
+        GtkWidget *row;
+        GtkWidget *widget;
+        GtkWidget *box;
+        GtkWidget *details;
+        GtkWidget *image;
+
         row = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
         box = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
         gtk_box_pack_start (GTK_BOX (row), box, FALSE, TRUE, 0);
@@ -312,21 +380,21 @@ add_row (NetDeviceEthernet *device, NMConnection *connection)
         gtk_widget_set_margin_top (widget, 12);
         gtk_widget_set_margin_bottom (widget, 12);
         gtk_box_pack_start (GTK_BOX (box), widget, FALSE, TRUE, 0);
+        g_object_set_data (G_OBJECT (row), "label", widget);
 
-        if (active) {
-                widget = gtk_image_new_from_icon_name ("object-select-symbolic", GTK_ICON_SIZE_MENU);
-                gtk_widget_set_halign (widget, GTK_ALIGN_CENTER);
-                gtk_widget_set_valign (widget, GTK_ALIGN_CENTER);
-                gtk_box_pack_start (GTK_BOX (box), widget, FALSE, TRUE, 0);
-
-                details = gtk_grid_new ();
-                gtk_grid_set_row_spacing (GTK_GRID (details), 10);
-                gtk_grid_set_column_spacing (GTK_GRID (details), 10);
+        widget = gtk_image_new_from_icon_name ("object-select-symbolic", GTK_ICON_SIZE_MENU);
+        gtk_widget_set_halign (widget, GTK_ALIGN_CENTER);
+        gtk_widget_set_valign (widget, GTK_ALIGN_CENTER);
+        gtk_widget_set_no_show_all (widget, TRUE);
+        gtk_box_pack_start (GTK_BOX (box), widget, FALSE, TRUE, 0);
+        g_object_set_data (G_OBJECT (row), "check", widget);
 
-                gtk_box_pack_start (GTK_BOX (row), details, FALSE, TRUE, 0);
-
-                add_details (details, nmdev, connection);
-        }
+        details = gtk_grid_new ();
+        gtk_grid_set_row_spacing (GTK_GRID (details), 10);
+        gtk_grid_set_column_spacing (GTK_GRID (details), 10);
+        gtk_widget_set_no_show_all (details, TRUE);
+        gtk_box_pack_start (GTK_BOX (row), details, FALSE, TRUE, 0);
+        g_object_set_data (G_OBJECT (row), "details", details);
 
         /* filler */
         widget = gtk_label_new ("");
@@ -357,6 +425,9 @@ add_row (NetDeviceEthernet *device, NMConnection *connection)
         g_object_set_data (G_OBJECT (row), "connection", connection);
 
         gtk_container_add (GTK_CONTAINER (device->list), row);
+        g_hash_table_insert (device->connections, connection, row);
+
+        return row;
 }
 
 static void
@@ -364,8 +435,20 @@ connection_removed (NMClient           *client,
                     NMRemoteConnection *connection,
                     NetDeviceEthernet  *device)
 {
-        if (g_hash_table_remove (device->connections, connection))
-                device_ethernet_refresh_ui (device);
+        GtkWidget *row;
+
+        row = g_hash_table_lookup (device->connections, connection);
+        if (row == NULL)
+                return;
+
+        /* the widgets must not outlive their connection */
+        gtk_widget_destroy (gtk_widget_get_parent (row));
+        g_hash_table_remove (device->connections, connection);
+        if (g_object_get_data (G_OBJECT (device->details_button), "connection") == connection) {
+                g_object_set_data (G_OBJECT (device->details_button), "connection", NULL);
+                gtk_widget_hide (device->details_button);
+        }
+        device_ethernet_refresh_ui (device);
 }
 
 static void
@@ -374,28 +457,35 @@ populate_ui (NetDeviceEthernet *device)
         GList *children, *c;
         GSList *connections, *l;
         NMConnection *connection;
+        GHashTable *valid;
+        GHashTableIter iter;
+        gpointer row;
         gint n_connections;
 
-        children = gtk_container_get_children (GTK_CONTAINER (device->list));
-        for (c = children; c; c = c->next) {
-                gtk_container_remove (GTK_CONTAINER (device->list), c->data);
-        }
-        g_list_free (children);
+        connections = net_device_get_valid_connections (NET_DEVICE (device));
+        n_connections = g_slist_length (connections);
 
-        children = gtk_container_get_children (GTK_CONTAINER (device->details));
-        for (c = children; c; c = c->next) {
-                gtk_container_remove (GTK_CONTAINER (device->details), c->data);
+        /* drop the rows of the connections that are gone */
+        valid = g_hash_table_new (NULL, NULL);
+        for (l = connections; l; l = l->next)
+                g_hash_table_add (valid, l->data);
+        g_hash_table_iter_init (&iter, device->connections);
+        while (g_hash_table_iter_next (&iter, (gpointer *) &connection, &row)) {
+                if (g_hash_table_contains (valid, connection))
+                        continue;
+                gtk_widget_destroy (gtk_widget_get_parent (row));
+                g_hash_table_iter_remove (&iter);
         }
-        g_list_free (children);
+        g_hash_table_destroy (valid);
 
-        connections = net_device_get_valid_connections (NET_DEVICE (device));
+        /* and only update the ones that are left */
         for (l = connections; l; l = l->next) {
-                NMConnection *connection = l->data;
-                if (!g_hash_table_contains (device->connections, connection)) {
-                        g_hash_table_add (device->connections, connection);
-                }
+                connection = l->data;
+                row = g_hash_table_lookup (device->connections, connection);
+                if (row == NULL)
+                        row = add_row (device, connection);
+                update_row (device, row);
         }
-        n_connections = g_slist_length (connections);
 
         if (n_connections > 4) {
                 gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (device->scrolled_window),
@@ -409,13 +499,15 @@ populate_ui (NetDeviceEthernet *device)
                 gtk_widget_set_vexpand (device->scrolled_window, FALSE);
         }
 
+        children = gtk_container_get_children (GTK_CONTAINER (device->details));
+        for (c = children; c; c = c->next) {
+                gtk_container_remove (GTK_CONTAINER (device->details), c->data);
+        }
+        g_list_free (children);
+
         if (n_connections > 1) {
                 gtk_widget_hide (device->details);
                 gtk_widget_hide (device->details_button);
-                for (l = connections; l; l = l->next) {
-                        NMConnection *connection = l->data;
-                        add_row (device, connection);
-                }
                 gtk_widget_show (device->scrolled_window);
         } else if (n_connections == 1) {
                 connection = connections->data;
@@ -453,7 +545,6 @@ add_profile (GtkButton *button, NetDeviceEthernet *device)
         GtkWidget *window;
         NMClient *client;
         NMDevice *nmdev;
-        const GPtrArray *connections;
 
         connection = nm_simple_connection_new ();
         sc = NM_SETTING_CONNECTION (nm_setting_connection_new ());
@@ -462,8 +553,7 @@ add_profile (GtkButton *button, NetDeviceEthernet *device)
         uuid = nm_utils_uuid_generate ();
 
         client = net_object_get_client (NET_OBJECT (device));
-        connections = nm_client_get_connections (client);
-        id = ce_page_get_next_available_name (connections, NAME_FORMAT_PROFILE, NULL);
+        id = ce_page_get_next_available_name (client, NAME_FORMAT_PROFILE, NULL);
 
         g_object_set (sc,
                       NM_SETTING_CONNECTION_UUID, uuid,
@@ -582,7 +672,7 @@ device_ethernet_constructed (GObject *object)
         g_signal_connect_object (client, NM_CLIENT_CONNECTION_REMOVED,
                                  G_CALLBACK (connection_removed), device, 0);
 
-        device_ethernet_refresh_ui (device);
+        device_ethernet_update_ui (device);
 }
 
 static void
@@ -590,6 +680,10 @@ device_ethernet_finalize (GObject *object)
 {
         NetDeviceEthernet *device = NET_DEVICE_ETHERNET (object);
 
+        if (device->refresh_id != 0) {
+                gtk_widget_remove_tick_callback (device->refresh_widget, device->refresh_id);
+                g_clear_object (&device->refresh_widget);
+        }
         g_object_unref (device->builder);
         g_hash_table_destroy (device->connections);
 
@@ -52,7 +52,9 @@ struct _NetDeviceEthernet
         GtkWidget *add_profile_button;
         gboolean   updating_device;
 
-        GHashTable *connections;
+        GHashTable *connections;        /* NMConnection → row */
+        guint       refresh_id;
+        GtkWidget  *refresh_widget;     /* owns the refresh_id tick callback */
 };
 
 struct _NetDeviceEthernetClass
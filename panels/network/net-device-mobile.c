@@ -27,11 +27,11 @@
 
 #include <NetworkManager.h>
 #include <libmm-glib.h>
-#include <nma-mobile-providers.h>
 
 #include "panel-common.h"
 #include "network-dialogs.h"
 #include "net-device-mobile.h"
+#include "net-mobile-providers.h"
 
 #define NET_DEVICE_MOBILE_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NET_TYPE_DEVICE_MOBILE, NetDeviceMobilePrivate))
 
@@ -50,7 +50,7 @@ struct _NetDeviceMobilePrivate
         MMObject   *mm_object;
         guint       operator_name_updated;
 
-        NMAMobileProvidersDatabase *mpd;
+        GCancellable *providers_cancellable;
 };
 
 enum {
@@ -268,44 +268,75 @@ device_mobile_refresh_equipment_id (NetDeviceMobile *device_mobile)
         panel_set_device_widget_details (device_mobile->priv->builder, "imei", equipment_id);
 }
 
-static gchar *
-device_mobile_find_provider (NetDeviceMobile *device_mobile,
-                             const gchar     *mccmnc,
-                             guint32          sid)
-{
-        NMAMobileProvider *provider;
-        GString *name = NULL;
+static void device_mobile_refresh_operator_name (NetDeviceMobile *device_mobile);
+static void device_mobile_get_registration_info_cb (GObject      *source_object,
+                                                    GAsyncResult *res,
+                                                    gpointer      user_data);
+static void device_mobile_get_serving_system_cb (GObject      *source_object,
+                                                 GAsyncResult *res,
+                                                 gpointer      user_data);
 
-        if (device_mobile->priv->mpd == NULL) {
-                GError *error = NULL;
+static void
+device_mobile_providers_loaded_cb (GObject      *source_object,
+                                   GAsyncResult *res,
+                                   gpointer      user_data)
+{
+        NetDeviceMobile *device_mobile;
+        GError *error = NULL;
 
-                /* Use defaults */
-                device_mobile->priv->mpd = nma_mobile_providers_database_new_sync (NULL, NULL, NULL, &error);
-                if (device_mobile->priv->mpd == NULL) {
+        if (net_mobile_providers_load_finish (res, &error) == NULL) {
+                if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
                         g_debug ("Couldn't load mobile providers database: %s",
-                                 error ? error->message : "");
-                        g_clear_error (&error);
-                        return NULL;
-                }
+                                 error->message);
+                g_error_free (error);
+                return;
         }
 
-        if (mccmnc != NULL) {
-                provider = nma_mobile_providers_database_lookup_3gpp_mcc_mnc (device_mobile->priv->mpd, mccmnc);
-                if (provider != NULL)
-                        name = g_string_new (nma_mobile_provider_get_name (provider));
-        }
+        /* Now that the names are known, guess the operator again */
+        device_mobile = NET_DEVICE_MOBILE (user_data);
+        if (device_mobile->priv->mm_object != NULL)
+                device_mobile_refresh_operator_name (device_mobile);
+        if (device_mobile->priv->gsm_proxy != NULL)
+                g_dbus_proxy_call (device_mobile->priv->gsm_proxy,
+                                   "GetRegistrationInfo",
+                                   NULL,
+                                   G_DBUS_CALL_FLAGS_NONE,
+                                   -1,
+                                   NULL,
+                                   device_mobile_get_registration_info_cb,
+                                   device_mobile);
+        if (device_mobile->priv->cdma_proxy != NULL)
+                g_dbus_proxy_call (device_mobile->priv->cdma_proxy,
+                                   "GetServingSystem",
+                                   NULL,
+                                   G_DBUS_CALL_FLAGS_NONE,
+                                   -1,
+                                   NULL,
+                                   device_mobile_get_serving_system_cb,
+                                   device_mobile);
+}
 
-        if (sid != 0) {
-                provider = nma_mobile_providers_database_lookup_cdma_sid (device_mobile->priv->mpd, sid);
-                if (provider != NULL) {
-                        if (name == NULL)
-                                name = g_string_new (nma_mobile_provider_get_name (provider));
-                        else
-                                g_string_append_printf (name, ", %s", nma_mobile_provider_get_name (provider));
+static gchar *
+device_mobile_find_provider (NetDeviceMobile *device_mobile,
+                             const gchar     *mccmnc,
+                             guint32          sid)
+{
+        NetMobileProviders *providers;
+
+        /* The database is loaded in the background, the operator is
+         * looked up again when it is there */
+        providers = net_mobile_providers_peek ();
+        if (providers == NULL) {
+                if (device_mobile->priv->providers_cancellable == NULL) {
+                        device_mobile->priv->providers_cancellable = g_cancellable_new ();
+                        net_mobile_providers_load_async (device_mobile->priv->providers_cancellable,
+                                                         device_mobile_providers_loaded_cb,
+                                                         device_mobile);
                 }
+                return NULL;
         }
 
-        return (name != NULL ? g_string_free (name, FALSE) : NULL);
+        return net_mobile_providers_find (providers, mccmnc, sid);
 }
 
 static void
@@ -865,7 +896,9 @@ net_device_mobile_dispose (GObject *object)
                 priv->operator_name_updated = 0;
         }
         g_clear_object (&priv->mm_object);
-        g_clear_object (&priv->mpd);
+        if (priv->providers_cancellable != NULL)
+                g_cancellable_cancel (priv->providers_cancellable);
+        g_clear_object (&priv->providers_cancellable);
 
         G_OBJECT_CLASS (net_device_mobile_parent_class)->dispose (object);
 }
@@ -36,6 +36,13 @@ struct _NetDevicePrivate
 {
         NMDevice                        *nm_device;
         guint                            changed_id;
+        guint                            notify_id;
+
+        /* connection → whether it is valid for the device, for all the
+         * connections of the client that were looked at so far */
+        GHashTable                      *connections;
+        NMClient                        *connections_client;
+        gboolean                         connections_stale;
 };
 
 enum {
@@ -172,10 +179,28 @@ state_changed_cb (NMDevice *device,
                   NMDeviceStateReason reason,
                   NetDevice *net_device)
 {
+        net_device->priv->connections_stale = TRUE;
         net_object_emit_changed (NET_OBJECT (net_device));
         net_object_refresh (NET_OBJECT (net_device));
 }
 
+/* Whether a connection applies to the device depends on these, and
+ * some of them are only known once the device is set up; a modem only
+ * reports its current capabilities once it is registered, and some
+ * drivers only get their MAC address late */
+static void
+device_notify_cb (NMDevice   *device,
+                  GParamSpec *pspec,
+                  NetDevice  *net_device)
+{
+        if (g_str_equal (pspec->name, "interface") ||
+            g_str_equal (pspec->name, "capabilities") ||
+            g_str_equal (pspec->name, "current-capabilities") ||
+            g_str_equal (pspec->name, "hw-address") ||
+            g_str_equal (pspec->name, "perm-hw-address"))
+                net_device->priv->connections_stale = TRUE;
+}
+
 NMDevice *
 net_device_get_nm_device (NetDevice *device)
 {
@@ -203,6 +228,123 @@ net_device_edit (NetObject *object)
         g_free (cmdline);
 }
 
+static void
+connection_changed_cb (NMConnection *connection,
+                       NetDevice    *device)
+{
+        gboolean valid;
+
+        /* the interface name or MAC address may have been edited */
+        valid = nm_device_connection_valid (device->priv->nm_device, connection);
+        g_hash_table_insert (device->priv->connections, connection, GINT_TO_POINTER (valid));
+}
+
+static void
+forget_connection (NetDevice    *device,
+                   NMConnection *connection)
+{
+        g_signal_handlers_disconnect_by_func (connection, connection_changed_cb, device);
+}
+
+static void
+client_connection_removed_cb (NMClient           *client,
+                              NMRemoteConnection *connection,
+                              NetDevice          *device)
+{
+        if (g_hash_table_remove (device->priv->connections, connection))
+                forget_connection (device, NM_CONNECTION (connection));
+}
+
+static void
+clear_connections (NetDevice *device)
+{
+        NetDevicePrivate *priv = device->priv;
+        GHashTableIter iter;
+        gpointer connection;
+
+        g_hash_table_iter_init (&iter, priv->connections);
+        while (g_hash_table_iter_next (&iter, &connection, NULL))
+                forget_connection (device, connection);
+        g_hash_table_remove_all (priv->connections);
+
+        if (priv->connections_client != NULL) {
+                g_signal_handlers_disconnect_by_func (priv->connections_client,
+                                                      client_connection_removed_cb,
+                                                      device);
+                priv->connections_client = NULL;
+        }
+}
+
+/* Checks the connections of the client that were not seen yet against
+ * the device, and drops the ones that are gone. Our handlers may run
+ * after the ones of the subclasses, which already ask for the valid
+ * connections, so the cache is checked against the client every time:
+ * the connections that are missing from it are added first, and any
+ * entry left over after that belongs to a connection that went away. */
+static void
+update_connections (NetDevice       *device,
+                    NMClient        *client,
+                    const GPtrArray *all)
+{
+        NetDevicePrivate *priv = device->priv;
+        guint i;
+
+        if (client != priv->connections_client) {
+                clear_connections (device);
+                priv->connections_client = client;
+                g_signal_connect_object (client, NM_CLIENT_CONNECTION_REMOVED,
+                                         G_CALLBACK (client_connection_removed_cb),
+                                         device, 0);
+        }
+
+        if (priv->connections_stale) {
+                GHashTableIter iter;
+                gpointer connection;
+
+                g_hash_table_iter_init (&iter, priv->connections);
+                while (g_hash_table_iter_next (&iter, &connection, NULL)) {
+                        gboolean valid;
+
+                        valid = nm_device_connection_valid (priv->nm_device, connection);
+                        g_hash_table_iter_replace (&iter, GINT_TO_POINTER (valid));
+                }
+                priv->connections_stale = FALSE;
+        }
+
+        for (i = 0; i < all->len; i++) {
+                NMConnection *connection = g_ptr_array_index (all, i);
+                gboolean valid;
+
+                if (g_hash_table_contains (priv->connections, connection))
+                        continue;
+
+                valid = nm_device_connection_valid (priv->nm_device, connection);
+                g_hash_table_insert (priv->connections, connection, GINT_TO_POINTER (valid));
+                g_signal_connect_object (connection, NM_CONNECTION_CHANGED,
+                                         G_CALLBACK (connection_changed_cb),
+                                         device, 0);
+        }
+
+        if (g_hash_table_size (priv->connections) > all->len) {
+                GHashTable *present;
+                GHashTableIter iter;
+                gpointer connection;
+
+                present = g_hash_table_new (NULL, NULL);
+                for (i = 0; i < all->len; i++)
+                        g_hash_table_add (present, g_ptr_array_index (all, i));
+
+                g_hash_table_iter_init (&iter, priv->connections);
+                while (g_hash_table_iter_next (&iter, &connection, NULL)) {
+                        if (g_hash_table_contains (present, connection))
+                                continue;
+                        forget_connection (device, connection);
+                        g_hash_table_iter_remove (&iter);
+                }
+                g_hash_table_destroy (present);
+        }
+}
+
 /**
  * net_device_get_property:
  **/
@@ -239,18 +381,29 @@ net_device_set_property (GObject *device_,
 
         switch (prop_id) {
         case PROP_DEVICE:
+                clear_connections (net_device);
                 if (priv->changed_id != 0) {
                         g_signal_handler_disconnect (priv->nm_device,
                                                      priv->changed_id);
                 }
+                if (priv->notify_id != 0) {
+                        g_signal_handler_disconnect (priv->nm_device,
+                                                     priv->notify_id);
+                }
                 priv->nm_device = g_value_dup_object (value);
                 if (priv->nm_device) {
                         priv->changed_id = g_signal_connect (priv->nm_device,
                                                              "state-changed",
                                                              G_CALLBACK (state_changed_cb),
                                                              net_device);
-                } else
+                        priv->notify_id = g_signal_connect (priv->nm_device,
+                                                            "notify",
+                                                            G_CALLBACK (device_notify_cb),
+                                                            net_device);
+                } else {
                         priv->changed_id = 0;
+                        priv->notify_id = 0;
+                }
                 break;
         default:
                 G_OBJECT_WARN_INVALID_PROPERTY_ID (net_device, prop_id, pspec);
@@ -268,6 +421,12 @@ net_device_finalize (GObject *object)
                 g_signal_handler_disconnect (priv->nm_device,
                                              priv->changed_id);
         }
+        if (priv->notify_id != 0) {
+                g_signal_handler_disconnect (priv->nm_device,
+                                             priv->notify_id);
+        }
+        /* the handlers went away with us */
+        g_hash_table_destroy (priv->connections);
         g_clear_object (&priv->nm_device);
 
         G_OBJECT_CLASS (net_device_parent_class)->finalize (object);
@@ -298,6 +457,7 @@ static void
 net_device_init (NetDevice *device)
 {
         device->priv = NET_DEVICE_GET_PRIVATE (device);
+        device->priv->connections = g_hash_table_new (NULL, NULL);
 }
 
 NetDevice *
@@ -314,23 +474,27 @@ GSList *
 net_device_get_valid_connections (NetDevice *device)
 {
         GSList *valid;
+        NMClient *client;
         NMConnection *connection;
         NMSettingConnection *s_con;
         NMActiveConnection *active_connection;
         const char *active_uuid;
         const GPtrArray *all;
-        GPtrArray *filtered;
         guint i;
 
-        all = nm_client_get_connections (net_object_get_client (NET_OBJECT (device)));
-        filtered = nm_device_filter_connections (net_device_get_nm_device (device), all);
+        client = net_object_get_client (NET_OBJECT (device));
+        all = nm_client_get_connections (client);
+        update_connections (device, client, all);
 
         active_connection = nm_device_get_active_connection (net_device_get_nm_device (device));
         active_uuid = active_connection ? nm_active_connection_get_uuid (active_connection) : NULL;
 
         valid = NULL;
-        for (i = 0; i < filtered->len; i++) {
-                connection = g_ptr_array_index (filtered, i);
+        for (i = 0; i < all->len; i++) {
+                connection = g_ptr_array_index (all, i);
+                if (!g_hash_table_lookup (device->priv->connections, connection))
+                        continue;
+
                 s_con = nm_connection_get_setting_connection (connection);
                 if (!s_con)
                         continue;
@@ -341,7 +505,6 @@ net_device_get_valid_connections (NetDevice *device)
 
                 valid = g_slist_prepend (valid, connection);
         }
-        g_ptr_array_free (filtered, FALSE);
 
         return g_slist_reverse (valid);
 }
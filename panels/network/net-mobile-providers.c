@@ -0,0 +1,411 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2017 Red Hat, Inc.
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <string.h>
+#include <glib/gstdio.h>
+
+#include <nma-mobile-providers.h>
+
+#include "net-mobile-providers.h"
+
+/* The names of the operators, by MCC/MNC and by CDMA SID. Parsing the
+ * whole serviceproviders.xml takes long enough to be noticed, so only
+ * these two maps are kept, and saved to a cache that is used for as long
+ * as the database file keeps the same modification time. The database
+ * picks the names translated for the current languages, so those are
+ * part of the cache key too. */
+
+#define CACHE_FORMAT  "(ussxa{ss}a{us})"
+#define CACHE_VERSION 2
+
+struct _NetMobileProviders {
+        GHashTable *mcc_mnc;    /* "MCCMNC" → name */
+        GHashTable *sid;        /* SID → name */
+};
+
+static NetMobileProviders *
+net_mobile_providers_alloc (void)
+{
+        NetMobileProviders *providers;
+
+        providers = g_slice_new0 (NetMobileProviders);
+        providers->mcc_mnc = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+        providers->sid = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+
+        return providers;
+}
+
+void
+net_mobile_providers_free (NetMobileProviders *providers)
+{
+        g_hash_table_destroy (providers->mcc_mnc);
+        g_hash_table_destroy (providers->sid);
+        g_slice_free (NetMobileProviders, providers);
+}
+
+static void
+add_mcc_mnc (NetMobileProviders *providers,
+             gchar              *mcc_mnc,
+             const gchar        *name)
+{
+        /* the first provider wins, as in the database lookups */
+        if (g_hash_table_contains (providers->mcc_mnc, mcc_mnc)) {
+                g_free (mcc_mnc);
+                return;
+        }
+        g_hash_table_insert (providers->mcc_mnc, mcc_mnc, g_strdup (name));
+}
+
+static void
+add_sid (NetMobileProviders *providers,
+         guint32             sid,
+         const gchar        *name)
+{
+        if (g_hash_table_contains (providers->sid, GUINT_TO_POINTER (sid)))
+                return;
+        g_hash_table_insert (providers->sid, GUINT_TO_POINTER (sid), g_strdup (name));
+}
+
+static NetMobileProviders *
+load_database (const gchar  *database,
+               GError      **error)
+{
+        NMAMobileProvidersDatabase *mpd;
+        NetMobileProviders *providers;
+        GHashTableIter iter;
+        NMACountryInfo *country;
+
+        mpd = nma_mobile_providers_database_new_sync (NULL, database, NULL, error);
+        if (mpd == NULL)
+                return NULL;
+
+        providers = net_mobile_providers_alloc ();
+
+        g_hash_table_iter_init (&iter, nma_mobile_providers_database_get_countries (mpd));
+        while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &country)) {
+                GSList *p;
+
+                for (p = nma_country_info_get_providers (country); p != NULL; p = p->next) {
+                        NMAMobileProvider *provider = p->data;
+                        const gchar *name;
+                        GSList *l;
+
+                        name = nma_mobile_provider_get_name (provider);
+                        if (name == NULL)
+                                continue;
+
+                        /* Matching a 6 digit MCCMNC against a 3 digit MNC
+                         * comes first, then a 5 digit one against the
+                         * first 2 digits of the MNC */
+                        for (l = nma_mobile_provider_get_3gpp_mcc_mnc (provider); l != NULL; l = l->next) {
+                                const gchar *mcc, *mnc;
+
+                                mcc = nma_mcc_mnc_get_mcc (l->data);
+                                mnc = nma_mcc_mnc_get_mnc (l->data);
+                                if (mcc == NULL || mnc == NULL || strlen (mcc) != 3)
+                                        continue;
+
+                                if (strlen (mnc) == 3)
+                                        add_mcc_mnc (providers, g_strconcat (mcc, mnc, NULL), name);
+                                if (strlen (mnc) >= 2)
+                                        add_mcc_mnc (providers, g_strdup_printf ("%s%.2s", mcc, mnc), name);
+                        }
+
+                        for (l = nma_mobile_provider_get_cdma_sid (provider); l != NULL; l = l->next)
+                                add_sid (providers, GPOINTER_TO_UINT (l->data), name);
+                }
+        }
+
+        g_object_unref (mpd);
+
+        return providers;
+}
+
+/* return value must be freed by caller with g_free() */
+static gchar *
+get_languages (void)
+{
+        return g_strjoinv (":", (gchar **) g_get_language_names ());
+}
+
+static NetMobileProviders *
+load_cache (const gchar *cache,
+            const gchar *database,
+            gint64       mtime)
+{
+        NetMobileProviders *providers = NULL;
+        GVariant *variant;
+        GVariantIter *mcc_mnc_iter, *sid_iter;
+        const gchar *cached_languages;
+        const gchar *cached_database;
+        gchar *languages;
+        const gchar *key, *name;
+        gint64 cached_mtime;
+        guint32 version, sid;
+        gchar *contents;
+        gsize length;
+
+        if (!g_file_get_contents (cache, &contents, &length, NULL))
+                return NULL;
+
+        variant = g_variant_new_from_data (G_VARIANT_TYPE (CACHE_FORMAT),
+                                           contents, length, FALSE,
+                                           g_free, contents);
+        g_variant_ref_sink (variant);
+
+        g_variant_get (variant, "(u&s&sxa{ss}a{us})",
+                       &version, &cached_languages, &cached_database, &cached_mtime,
+                       &mcc_mnc_iter, &sid_iter);
+
+        languages = get_languages ();
+
+        if (version == CACHE_VERSION &&
+            g_strcmp0 (cached_languages, languages) == 0 &&
+            g_strcmp0 (cached_database, database) == 0 &&
+            cached_mtime == mtime) {
+                providers = net_mobile_providers_alloc ();
+                while (g_variant_iter_next (mcc_mnc_iter, "{&s&s}", &key, &name))
+                        add_mcc_mnc (providers, g_strdup (key), name);
+                while (g_variant_iter_next (sid_iter, "{u&s}", &sid, &name))
+                        add_sid (providers, sid, name);
+        }
+
+        g_variant_iter_free (mcc_mnc_iter);
+        g_variant_iter_free (sid_iter);
+        g_variant_unref (variant);
+        g_free (languages);
+
+        return providers;
+}
+
+static void
+save_cache (NetMobileProviders *providers,
+            const gchar        *cache,
+            const gchar        *database,
+            gint64              mtime)
+{
+        GVariantBuilder mcc_mnc_builder, sid_builder;
+        GHashTableIter iter;
+        gpointer key, name;
+        GVariant *variant;
+        GError *error = NULL;
+        gchar *languages;
+        gchar *dir;
+
+        dir = g_path_get_dirname (cache);
+        if (g_mkdir_with_parents (dir, 0700) < 0) {
+                g_debug ("Could not create directory '%s': %m", dir);
+                g_free (dir);
+                return;
+        }
+        g_free (dir);
+
+        g_variant_builder_init (&mcc_mnc_builder, G_VARIANT_TYPE ("a{ss}"));
+        g_hash_table_iter_init (&iter, providers->mcc_mnc);
+        while (g_hash_table_iter_next (&iter, &key, &name))
+                g_variant_builder_add (&mcc_mnc_builder, "{ss}", key, name);
+
+        g_variant_builder_init (&sid_builder, G_VARIANT_TYPE ("a{us}"));
+        g_hash_table_iter_init (&iter, providers->sid);
+        while (g_hash_table_iter_next (&iter, &key, &name))
+                g_variant_builder_add (&sid_builder, "{us}", GPOINTER_TO_UINT (key), name);
+
+        languages = get_languages ();
+        variant = g_variant_new (CACHE_FORMAT, CACHE_VERSION, languages, database, mtime,
+                                 &mcc_mnc_builder, &sid_builder);
+        g_variant_ref_sink (variant);
+        g_free (languages);
+
+        if (!g_file_set_contents (cache,
+                                  g_variant_get_data (variant),
+                                  g_variant_get_size (variant),
+                                  &error)) {
+                g_debug ("Could not save mobile providers cache '%s': %s", cache, error->message);
+                g_error_free (error);
+        }
+
+        g_variant_unref (variant);
+}
+
+/* Loads the operator names from @database, or from @cache if it was
+ * saved for the current version of @database. This blocks. */
+NetMobileProviders *
+net_mobile_providers_new (const gchar  *database,
+                          const gchar  *cache,
+                          GError      **error)
+{
+        NetMobileProviders *providers;
+        GStatBuf buf;
+
+        if (g_stat (database, &buf) < 0) {
+                int errsv = errno;
+
+                g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errsv),
+                             "Could not stat '%s': %s", database, g_strerror (errsv));
+                return NULL;
+        }
+
+        providers = load_cache (cache, database, buf.st_mtime);
+        if (providers != NULL)
+                return providers;
+
+        providers = load_database (database, error);
+        if (providers != NULL)
+                save_cache (providers, cache, database, buf.st_mtime);
+
+        return providers;
+}
+
+/* Returns the name of the operator, or of both operators when the
+ * MCC/MNC and the SID don't agree */
+gchar *
+net_mobile_providers_find (NetMobileProviders *providers,
+                           const gchar        *mccmnc,
+                           guint32             sid)
+{
+        const gchar *provider = NULL;
+        GString *name = NULL;
+
+        if (mccmnc != NULL && (strlen (mccmnc) == 5 || strlen (mccmnc) == 6)) {
+                provider = g_hash_table_lookup (providers->mcc_mnc, mccmnc);
+                if (provider == NULL && strlen (mccmnc) == 6) {
+                        gchar *prefix;
+
+                        prefix = g_strndup (mccmnc, 5);
+                        provider = g_hash_table_lookup (providers->mcc_mnc, prefix);
+                        g_free (prefix);
+                }
+                if (provider != NULL)
+                        name = g_string_new (provider);
+        }
+
+        if (sid != 0) {
+                provider = g_hash_table_lookup (providers->sid, GUINT_TO_POINTER (sid));
+                if (provider != NULL) {
+                        if (name == NULL)
+                                name = g_string_new (provider);
+                        else
+                                g_string_append_printf (name, ", %s", provider);
+                }
+        }
+
+        return (name != NULL ? g_string_free (name, FALSE) : NULL);
+}
+
+/* The database is loaded once for the whole process, and shared */
+static NetMobileProviders *default_providers;
+static GList *pending_tasks;
+
+static void
+load_thread (GTask        *task,
+             gpointer      source_object,
+             gpointer      task_data,
+             GCancellable *cancellable)
+{
+        NetMobileProviders *providers;
+        GError *error = NULL;
+        gchar *cache;
+
+        cache = g_build_filename (g_get_user_cache_dir (), "gnome-control-center",
+                                  "mobile-providers", NULL);
+        providers = net_mobile_providers_new (MOBILE_BROADBAND_PROVIDER_INFO_DATABASE,
+                                              cache, &error);
+        g_free (cache);
+
+        if (providers != NULL)
+                g_task_return_pointer (task, providers, (GDestroyNotify) net_mobile_providers_free);
+        else
+                g_task_return_error (task, error);
+}
+
+static void
+load_done_cb (GObject      *source_object,
+              GAsyncResult *result,
+              gpointer      user_data)
+{
+        GError *error = NULL;
+        GList *tasks, *l;
+
+        default_providers = g_task_propagate_pointer (G_TASK (result), &error);
+
+        tasks = pending_tasks;
+        pending_tasks = NULL;
+
+        for (l = tasks; l != NULL; l = l->next) {
+                GTask *task = l->data;
+
+                if (default_providers != NULL)
+                        g_task_return_pointer (task, default_providers, NULL);
+                else
+                        g_task_return_error (task, g_error_copy (error));
+                g_object_unref (task);
+        }
+
+        g_list_free (tasks);
+        g_clear_error (&error);
+}
+
+void
+net_mobile_providers_load_async (GCancellable        *cancellable,
+                                 GAsyncReadyCallback  callback,
+                                 gpointer             user_data)
+{
+        GTask *task;
+
+        task = g_task_new (NULL, cancellable, callback, user_data);
+        g_task_set_source_tag (task, net_mobile_providers_load_async);
+
+        if (default_providers != NULL) {
+                g_task_return_pointer (task, default_providers, NULL);
+                g_object_unref (task);
+                return;
+        }
+
+        /* Several devices may ask while it loads */
+        if (pending_tasks == NULL) {
+                GTask *load_task;
+
+                load_task = g_task_new (NULL, NULL, load_done_cb, NULL);
+                g_task_run_in_thread (load_task, load_thread);
+                g_object_unref (load_task);
+        }
+        pending_tasks = g_list_prepend (pending_tasks, task);
+}
+
+/* The result belongs to the process and is never freed */
+NetMobileProviders *
+net_mobile_providers_load_finish (GAsyncResult  *result,
+                                  GError       **error)
+{
+        g_return_val_if_fail (g_task_is_valid (result, NULL), NULL);
+
+        return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+/* Returns the providers if they were loaded already */
+NetMobileProviders *
+net_mobile_providers_peek (void)
+{
+        return default_providers;
+}
@@ -0,0 +1,244 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2017 Red Hat, Inc.
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+
+#include <utime.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "net-mobile-providers.h"
+
+#define DATABASE_FORMAT                                                 \
+        "<?xml version=\"1.0\"?>"                                       \
+        "<serviceproviders format=\"2.0\">"                             \
+        "  <country code=\"us\">"                                       \
+        "    <provider>"                                                \
+        "      <name>%s</name>"                                         \
+        "      <gsm>"                                                   \
+        "        <network-id mcc=\"310\" mnc=\"410\"/>"                 \
+        "        <apn value=\"broadband\"/>"                            \
+        "      </gsm>"                                                  \
+        "    </provider>"                                               \
+        "    <provider>"                                                \
+        "      <name>Test CDMA</name>"                                  \
+        "      <cdma>"                                                  \
+        "        <sid value=\"4\"/>"                                    \
+        "      </cdma>"                                                 \
+        "    </provider>"                                               \
+        "  </country>"                                                  \
+        "  <country code=\"gb\">"                                       \
+        "    <provider>"                                                \
+        "      <name>Test UK</name>"                                    \
+        "      <gsm>"                                                   \
+        "        <network-id mcc=\"234\" mnc=\"15\"/>"                  \
+        "        <apn value=\"internet\"/>"                             \
+        "      </gsm>"                                                  \
+        "    </provider>"                                               \
+        "  </country>"                                                  \
+        "</serviceproviders>"
+
+typedef struct {
+        gchar *dir;
+        gchar *database;
+        gchar *cache;
+} Fixture;
+
+static void
+write_database (Fixture     *fixture,
+                const gchar *name,
+                time_t       mtime)
+{
+        struct utimbuf times;
+        GError *error = NULL;
+        gchar *contents;
+
+        contents = g_strdup_printf (DATABASE_FORMAT, name);
+        g_file_set_contents (fixture->database, contents, -1, &error);
+        g_assert_no_error (error);
+        g_free (contents);
+
+        times.actime = mtime;
+        times.modtime = mtime;
+        g_assert_cmpint (g_utime (fixture->database, &times), ==, 0);
+}
+
+static void
+fixture_setup (Fixture       *fixture,
+               gconstpointer  user_data)
+{
+        GError *error = NULL;
+
+        fixture->dir = g_dir_make_tmp ("test-mobile-providers-XXXXXX", &error);
+        g_assert_no_error (error);
+        fixture->database = g_build_filename (fixture->dir, "serviceproviders.xml", NULL);
+        fixture->cache = g_build_filename (fixture->dir, "cache", "mobile-providers", NULL);
+}
+
+static void
+fixture_teardown (Fixture       *fixture,
+                  gconstpointer  user_data)
+{
+        gchar *cache_dir;
+
+        cache_dir = g_path_get_dirname (fixture->cache);
+        g_unlink (fixture->cache);
+        g_rmdir (cache_dir);
+        g_unlink (fixture->database);
+        g_rmdir (fixture->dir);
+
+        g_free (cache_dir);
+        g_free (fixture->cache);
+        g_free (fixture->database);
+        g_free (fixture->dir);
+}
+
+static void
+assert_provider (NetMobileProviders *providers,
+                 const gchar        *mccmnc,
+                 guint32             sid,
+                 const gchar        *expected)
+{
+        gchar *name;
+
+        name = net_mobile_providers_find (providers, mccmnc, sid);
+        g_assert_cmpstr (name, ==, expected);
+        g_free (name);
+}
+
+static void
+test_lookup (Fixture       *fixture,
+             gconstpointer  user_data)
+{
+        NetMobileProviders *providers;
+        GError *error = NULL;
+
+        write_database (fixture, "Test GSM", 1000000000);
+        providers = net_mobile_providers_new (fixture->database, fixture->cache, &error);
+        g_assert_no_error (error);
+
+        /* The same matches as the database itself does */
+        assert_provider (providers, "310410", 0, "Test GSM");
+        assert_provider (providers, "31041", 0, "Test GSM");
+        assert_provider (providers, "23415", 0, "Test UK");
+        assert_provider (providers, "234150", 0, "Test UK");
+        assert_provider (providers, "2341", 0, NULL);
+        assert_provider (providers, "310999", 0, NULL);
+        assert_provider (providers, NULL, 4, "Test CDMA");
+        assert_provider (providers, NULL, 5, NULL);
+        assert_provider (providers, "310410", 4, "Test GSM, Test CDMA");
+
+        net_mobile_providers_free (providers);
+}
+
+static void
+test_cache (Fixture       *fixture,
+            gconstpointer  user_data)
+{
+        NetMobileProviders *providers;
+        GError *error = NULL;
+
+        write_database (fixture, "Test GSM", 1000000000);
+        providers = net_mobile_providers_new (fixture->database, fixture->cache, &error);
+        g_assert_no_error (error);
+        g_assert_true (g_file_test (fixture->cache, G_FILE_TEST_IS_REGULAR));
+        net_mobile_providers_free (providers);
+
+        /* Same modification time: the cache is used, and the database
+         * is not looked at */
+        write_database (fixture, "Renamed GSM", 1000000000);
+        providers = net_mobile_providers_new (fixture->database, fixture->cache, &error);
+        g_assert_no_error (error);
+        assert_provider (providers, "310410", 0, "Test GSM");
+        assert_provider (providers, NULL, 4, "Test CDMA");
+        net_mobile_providers_free (providers);
+
+        /* The database was updated */
+        write_database (fixture, "Renamed GSM", 1000000001);
+        providers = net_mobile_providers_new (fixture->database, fixture->cache, &error);
+        g_assert_no_error (error);
+        assert_provider (providers, "310410", 0, "Renamed GSM");
+        net_mobile_providers_free (providers);
+
+        /* A broken cache is ignored */
+        g_file_set_contents (fixture->cache, "garbage", -1, &error);
+        g_assert_no_error (error);
+        providers = net_mobile_providers_new (fixture->database, fixture->cache, &error);
+        g_assert_no_error (error);
+        assert_provider (providers, "310410", 0, "Renamed GSM");
+        net_mobile_providers_free (providers);
+}
+
+static void
+test_cache_languages (Fixture       *fixture,
+                      gconstpointer  user_data)
+{
+        NetMobileProviders *providers;
+        GError *error = NULL;
+
+        g_setenv ("LANGUAGE", "en", TRUE);
+
+        write_database (fixture, "Test GSM", 1000000000);
+        providers = net_mobile_providers_new (fixture->database, fixture->cache, &error);
+        g_assert_no_error (error);
+        net_mobile_providers_free (providers);
+
+        /* The names may be translated differently in another language,
+         * so the cache is not used */
+        write_database (fixture, "Renamed GSM", 1000000000);
+        g_setenv ("LANGUAGE", "de", TRUE);
+        providers = net_mobile_providers_new (fixture->database, fixture->cache, &error);
+        g_assert_no_error (error);
+        assert_provider (providers, "310410", 0, "Renamed GSM");
+        net_mobile_providers_free (providers);
+
+        g_unsetenv ("LANGUAGE");
+}
+
+static void
+test_missing_database (Fixture       *fixture,
+                       gconstpointer  user_data)
+{
+        NetMobileProviders *providers;
+        GError *error = NULL;
+
+        providers = net_mobile_providers_new (fixture->database, fixture->cache, &error);
+        g_assert_error (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+        g_assert_null (providers);
+        g_error_free (error);
+}
+
+int
+main (int argc, char **argv)
+{
+        g_test_init (&argc, &argv, NULL);
+
+        g_test_add ("/network/mobile-providers/lookup", Fixture, NULL,
+                    fixture_setup, test_lookup, fixture_teardown);
+        g_test_add ("/network/mobile-providers/cache", Fixture, NULL,
+                    fixture_setup, test_cache, fixture_teardown);
+        g_test_add ("/network/mobile-providers/cache-languages", Fixture, NULL,
+                    fixture_setup, test_cache_languages, fixture_teardown);
+        g_test_add ("/network/mobile-providers/missing-database", Fixture, NULL,
+                    fixture_setup, test_missing_database, fixture_teardown);
+
+        return g_test_run ();
+}
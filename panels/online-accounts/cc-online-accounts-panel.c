@@ -39,9 +39,15 @@ struct _CcGoaPanel
   CcPanel parent_instance;
 
   GoaClient *client;
+  GCancellable *cancellable;
   GoaObject *active_object;
   GoaObject *removed_object;
 
+  /* GoaObject -> GtkListBoxRow */
+  GHashTable *rows;
+  /* Command line parameters received before the client was ready */
+  GVariant *pending_parameters;
+
   GtkWidget *accounts_frame;
   GtkWidget *accounts_listbox;
   GtkWidget *edit_account_dialog;
@@ -96,6 +102,9 @@ static void on_notification_closed (GtkButton  *button,
 static void on_undo_button_clicked (GtkButton  *button,
                                     CcGoaPanel *self);
 
+static void handle_parameters (CcGoaPanel *panel,
+                               GVariant   *parameters);
+
 CC_PANEL_REGISTER (CcGoaPanel, cc_goa_panel);
 
 enum {
@@ -247,6 +256,10 @@ on_provider_row_activated (CcGoaPanel    *self,
       return;
     }
 
+  /* Still waiting for goa-daemon */
+  if (self->client == NULL)
+    return;
+
   error = NULL;
   provider = g_object_get_data (G_OBJECT (activated_row), "goa-provider");
 
@@ -352,29 +365,22 @@ cc_goa_panel_set_property (GObject *object,
     {
       case PROP_PARAMETERS:
         {
-          GVariant *parameters, *v;
-          const gchar *first_arg = NULL;
+          CcGoaPanel *panel = CC_GOA_PANEL (object);
+          GVariant *parameters;
 
           parameters = g_value_get_variant (value);
           if (parameters == NULL)
             return;
 
-          if (g_variant_n_children (parameters) > 0)
+          /* The accounts are not known until the client is ready */
+          if (panel->client == NULL)
             {
-                g_variant_get_child (parameters, 0, "v", &v);
-                if (g_variant_is_of_type (v, G_VARIANT_TYPE_STRING))
-                  first_arg = g_variant_get_string (v, NULL);
-                else
-                  g_warning ("Wrong type for the second argument GVariant, expected 's' but got '%s'",
-                             (gchar *)g_variant_get_type (v));
-                g_variant_unref (v);
+              g_clear_pointer (&panel->pending_parameters, g_variant_unref);
+              panel->pending_parameters = g_variant_ref (parameters);
+              return;
             }
 
-          if (g_strcmp0 (first_arg, "add") == 0)
-            command_add (CC_GOA_PANEL (object), parameters);
-          else if (first_arg != NULL)
-            select_account_by_id (CC_GOA_PANEL (object), first_arg);
-
+          handle_parameters (panel, parameters);
           return;
         }
     }
@@ -382,20 +388,106 @@ cc_goa_panel_set_property (GObject *object,
   G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
 }
 
+static void
+handle_parameters (CcGoaPanel *panel,
+                   GVariant   *parameters)
+{
+  GVariant *v;
+  const gchar *first_arg = NULL;
+
+  if (g_variant_n_children (parameters) > 0)
+    {
+        g_variant_get_child (parameters, 0, "v", &v);
+        if (g_variant_is_of_type (v, G_VARIANT_TYPE_STRING))
+          first_arg = g_variant_get_string (v, NULL);
+        else
+          g_warning ("Wrong type for the second argument GVariant, expected 's' but got '%s'",
+                     (gchar *)g_variant_get_type (v));
+        g_variant_unref (v);
+    }
+
+  if (g_strcmp0 (first_arg, "add") == 0)
+    command_add (panel, parameters);
+  else if (first_arg != NULL)
+    select_account_by_id (panel, first_arg);
+}
+
+static void
+cc_goa_panel_dispose (GObject *object)
+{
+  CcGoaPanel *panel = CC_GOA_PANEL (object);
+
+  g_cancellable_cancel (panel->cancellable);
+
+  G_OBJECT_CLASS (cc_goa_panel_parent_class)->dispose (object);
+}
+
 static void
 cc_goa_panel_finalize (GObject *object)
 {
   CcGoaPanel *panel = CC_GOA_PANEL (object);
 
+  g_clear_object (&panel->cancellable);
   g_clear_object (&panel->client);
+  g_clear_pointer (&panel->rows, g_hash_table_destroy);
+  g_clear_pointer (&panel->pending_parameters, g_variant_unref);
 
   G_OBJECT_CLASS (cc_goa_panel_parent_class)->finalize (object);
 }
 
 static void
-cc_goa_panel_init (CcGoaPanel *panel)
+goa_client_ready_cb (GObject      *source,
+                     GAsyncResult *res,
+                     gpointer      user_data)
 {
+  CcGoaPanel *panel;
+  GoaClient *client;
   GError *error;
+
+  error = NULL;
+  client = goa_client_new_finish (res, &error);
+  if (client == NULL)
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+          g_warning ("Error getting a GoaClient: %s (%s, %d)",
+                     error->message, g_quark_to_string (error->domain), error->code);
+          gtk_widget_set_sensitive (GTK_WIDGET (user_data), FALSE);
+        }
+      g_error_free (error);
+      return;
+    }
+
+  panel = CC_GOA_PANEL (user_data);
+  panel->client = client;
+
+  g_signal_connect (panel->client,
+                    "account-added",
+                    G_CALLBACK (on_account_added),
+                    panel);
+
+  g_signal_connect (panel->client,
+                    "account-changed",
+                    G_CALLBACK (on_account_changed),
+                    panel);
+
+  g_signal_connect (panel->client,
+                    "account-removed",
+                    G_CALLBACK (on_account_removed),
+                    panel);
+
+  fill_accounts_listbox (panel);
+
+  if (panel->pending_parameters != NULL)
+    {
+      handle_parameters (panel, panel->pending_parameters);
+      g_clear_pointer (&panel->pending_parameters, g_variant_unref);
+    }
+}
+
+static void
+cc_goa_panel_init (CcGoaPanel *panel)
+{
   GNetworkMonitor *monitor;
 
   g_resources_register (cc_online_accounts_get_resource ());
@@ -430,34 +522,13 @@ cc_goa_panel_init (CcGoaPanel *panel)
                           panel->providers_listbox, "sensitive",
                           G_BINDING_SYNC_CREATE);
 
-  /* TODO: probably want to avoid _sync() ... */
-  error = NULL;
-  panel->client = goa_client_new_sync (NULL /* GCancellable */, &error);
-  if (panel->client == NULL)
-    {
-      g_warning ("Error getting a GoaClient: %s (%s, %d)",
-                 error->message, g_quark_to_string (error->domain), error->code);
-      gtk_widget_set_sensitive (GTK_WIDGET (panel), FALSE);
-      g_error_free (error);
-      return;
-    }
+  panel->rows = g_hash_table_new (NULL, NULL);
 
-  g_signal_connect (panel->client,
-                    "account-added",
-                    G_CALLBACK (on_account_added),
-                    panel);
+  /* Until goa-daemon answers, the accounts list stays hidden and the
+   * providers can not be activated. */
+  panel->cancellable = g_cancellable_new ();
+  goa_client_new (panel->cancellable, goa_client_ready_cb, panel);
 
-  g_signal_connect (panel->client,
-                    "account-changed",
-                    G_CALLBACK (on_account_changed),
-                    panel);
-
-  g_signal_connect (panel->client,
-                    "account-removed",
-                    G_CALLBACK (on_account_removed),
-                    panel);
-
-  fill_accounts_listbox (panel);
   goa_provider_get_all (get_all_providers_cb, panel);
 
   gtk_widget_show (GTK_WIDGET (panel));
@@ -493,6 +564,7 @@ cc_goa_panel_class_init (CcGoaPanelClass *klass)
   panel_class->get_help_uri = cc_goa_panel_get_help_uri;
 
   object_class->set_property = cc_goa_panel_set_property;
+  object_class->dispose = cc_goa_panel_dispose;
   object_class->finalize = cc_goa_panel_finalize;
   object_class->constructed = cc_goa_panel_constructed;
 
@@ -658,24 +730,25 @@ fill_accounts_listbox (CcGoaPanel *self)
 
 /* ---------------------------------------------------------------------------------------------------- */
 
-typedef void (*RowForAccountCallback) (CcGoaPanel *self, GtkWidget *row, GList *other_rows);
+typedef void (*RowForAccountCallback) (CcGoaPanel *self, GoaObject *object, GtkWidget *row);
 
 static void
-hide_row_for_account (CcGoaPanel *self, GtkWidget *row, GList *other_rows)
+hide_row_for_account (CcGoaPanel *self, GoaObject *object, GtkWidget *row)
 {
   gtk_widget_hide (row);
-  gtk_widget_set_visible (self->accounts_frame, other_rows != NULL);
+  gtk_widget_set_visible (self->accounts_frame, g_hash_table_size (self->rows) > 1);
 }
 
 static void
-remove_row_for_account (CcGoaPanel *self, GtkWidget *row, GList *other_rows)
+remove_row_for_account (CcGoaPanel *self, GoaObject *object, GtkWidget *row)
 {
+  g_hash_table_remove (self->rows, object);
   gtk_widget_destroy (row);
-  gtk_widget_set_visible (self->accounts_frame, other_rows != NULL);
+  gtk_widget_set_visible (self->accounts_frame, g_hash_table_size (self->rows) > 0);
 }
 
 static void
-show_row_for_account (CcGoaPanel *self, GtkWidget *row, GList *other_rows)
+show_row_for_account (CcGoaPanel *self, GoaObject *object, GtkWidget *row)
 {
   gtk_widget_show (row);
   gtk_widget_show (self->accounts_frame);
@@ -686,27 +759,11 @@ modify_row_for_account (CcGoaPanel *self,
                         GoaObject *object,
                         RowForAccountCallback callback)
 {
-  GList *children, *l;
-
-  children = gtk_container_get_children (GTK_CONTAINER (self->accounts_listbox));
-
-  for (l = children; l != NULL; l = l->next)
-    {
-      GoaObject *row_object;
-
-      row_object = g_object_get_data (G_OBJECT (l->data), "goa-object");
-      if (row_object == object)
-        {
-          GtkWidget *row = GTK_WIDGET (l->data);
-
-          children = g_list_remove_link (children, l);
-          callback (self, row, children);
-          g_list_free (l);
-          break;
-        }
-    }
+  GtkWidget *row;
 
-  g_list_free (children);
+  row = g_hash_table_lookup (self->rows, object);
+  if (row != NULL)
+    callback (self, object, row);
 }
 
 /* ---------------------------------------------------------------------------------------------------- */
@@ -783,6 +840,7 @@ on_account_added (GoaClient *client,
   gtk_container_add (GTK_CONTAINER (row), box);
 
   /* Add to the listbox */
+  g_hash_table_insert (self->rows, object, row);
   gtk_container_add (GTK_CONTAINER (self->accounts_listbox), row);
   gtk_widget_show_all (row);
   gtk_widget_show (self->accounts_frame);
@@ -0,0 +1,277 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*-
+ *
+ * Copyright (C) 2017 Red Hat, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <config.h>
+
+#include "cc-power-capabilities.h"
+
+/* The chassis type and whether the machine can suspend or hibernate are
+ * asked from hostnamed and logind once, with the calls running
+ * concurrently. The answers are then kept on the bus connection, so for
+ * the system bus they last for the session. */
+
+#define CAPABILITIES_KEY "cc-power-capabilities"
+#define PROBE_KEY "cc-power-capabilities-probe"
+
+typedef struct
+{
+  GDBusConnection     *connection;
+  CcPowerCapabilities *caps;
+  guint                n_pending;
+  GList               *tasks;
+} Probe;
+
+static void
+capabilities_free (CcPowerCapabilities *caps)
+{
+  g_free (caps->chassis_type);
+  g_slice_free (CcPowerCapabilities, caps);
+}
+
+static void
+probe_call_done (Probe *probe)
+{
+  GList *l;
+
+  if (--probe->n_pending > 0)
+    return;
+
+  g_object_set_data_full (G_OBJECT (probe->connection), CAPABILITIES_KEY,
+                          probe->caps, (GDestroyNotify) capabilities_free);
+  g_object_set_data (G_OBJECT (probe->connection), PROBE_KEY, NULL);
+
+  probe->tasks = g_list_reverse (probe->tasks);
+  for (l = probe->tasks; l != NULL; l = l->next)
+    {
+      g_task_return_pointer (l->data, probe->caps, NULL);
+      g_object_unref (l->data);
+    }
+
+  g_list_free (probe->tasks);
+  g_object_unref (probe->connection);
+  g_slice_free (Probe, probe);
+}
+
+static void
+got_chassis_cb (GObject      *source_object,
+                GAsyncResult *res,
+                gpointer      user_data)
+{
+  Probe *probe = user_data;
+  GError *error = NULL;
+  GVariant *variant;
+  GVariant *inner;
+
+  variant = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source_object), res, &error);
+  if (!variant)
+    {
+      g_debug ("Failed to get property '%s': %s", "Chassis", error->message);
+      g_error_free (error);
+      goto out;
+    }
+
+  g_variant_get (variant, "(v)", &inner);
+  if (g_variant_is_of_type (inner, G_VARIANT_TYPE_STRING))
+    probe->caps->chassis_type = g_variant_dup_string (inner, NULL);
+  g_variant_unref (inner);
+  g_variant_unref (variant);
+
+out:
+  probe_call_done (probe);
+}
+
+static gboolean
+get_can_result (GDBusConnection *connection,
+                GAsyncResult    *res,
+                const char      *method_name)
+{
+  GError *error = NULL;
+  GVariant *variant;
+  gboolean result;
+  const char *s;
+
+  variant = g_dbus_connection_call_finish (connection, res, &error);
+  if (!variant)
+    {
+      g_debug ("Failed to call %s(): %s", method_name, error->message);
+      g_error_free (error);
+      return FALSE;
+    }
+
+  g_variant_get (variant, "(&s)", &s);
+  result = (g_strcmp0 (s, "yes") == 0);
+  g_variant_unref (variant);
+
+  return result;
+}
+
+static void
+got_can_suspend_cb (GObject      *source_object,
+                    GAsyncResult *res,
+                    gpointer      user_data)
+{
+  Probe *probe = user_data;
+
+  probe->caps->can_suspend = get_can_result (G_DBUS_CONNECTION (source_object), res, "CanSuspend");
+  probe_call_done (probe);
+}
+
+static void
+got_can_hibernate_cb (GObject      *source_object,
+                      GAsyncResult *res,
+                      gpointer      user_data)
+{
+  Probe *probe = user_data;
+
+  probe->caps->can_hibernate = get_can_result (G_DBUS_CONNECTION (source_object), res, "CanHibernate");
+  probe_call_done (probe);
+}
+
+static void
+call_can (Probe               *probe,
+          const char          *method_name,
+          GAsyncReadyCallback  callback)
+{
+  g_dbus_connection_call (probe->connection,
+                          "org.freedesktop.login1",
+                          "/org/freedesktop/login1",
+                          "org.freedesktop.login1.Manager",
+                          method_name,
+                          NULL,
+                          G_VARIANT_TYPE ("(s)"),
+                          G_DBUS_CALL_FLAGS_NONE,
+                          -1,
+                          NULL,
+                          callback,
+                          probe);
+}
+
+static void
+got_connection (GTask           *task,
+                GDBusConnection *connection)
+{
+  CcPowerCapabilities *caps;
+  Probe *probe;
+
+  caps = g_object_get_data (G_OBJECT (connection), CAPABILITIES_KEY);
+  if (caps != NULL)
+    {
+      g_task_return_pointer (task, caps, NULL);
+      g_object_unref (task);
+      return;
+    }
+
+  /* Wait for the answers already asked for */
+  probe = g_object_get_data (G_OBJECT (connection), PROBE_KEY);
+  if (probe != NULL)
+    {
+      probe->tasks = g_list_prepend (probe->tasks, task);
+      return;
+    }
+
+  /* The calls are not cancelled with the task, since their answers are
+   * useful to whoever asks next */
+  probe = g_slice_new0 (Probe);
+  probe->connection = g_object_ref (connection);
+  probe->caps = g_slice_new0 (CcPowerCapabilities);
+  probe->tasks = g_list_prepend (NULL, task);
+  probe->n_pending = 3;
+  g_object_set_data (G_OBJECT (connection), PROBE_KEY, probe);
+
+  g_dbus_connection_call (connection,
+                          "org.freedesktop.hostname1",
+                          "/org/freedesktop/hostname1",
+                          "org.freedesktop.DBus.Properties",
+                          "Get",
+                          g_variant_new ("(ss)",
+                                         "org.freedesktop.hostname1",
+                                         "Chassis"),
+                          G_VARIANT_TYPE ("(v)"),
+                          G_DBUS_CALL_FLAGS_NONE,
+                          -1,
+                          NULL,
+                          got_chassis_cb,
+                          probe);
+  call_can (probe, "CanSuspend", got_can_suspend_cb);
+  call_can (probe, "CanHibernate", got_can_hibernate_cb);
+}
+
+static void
+got_bus_cb (GObject      *source_object,
+            GAsyncResult *res,
+            gpointer      user_data)
+{
+  GTask *task = user_data;
+  GDBusConnection *connection;
+  GError *error = NULL;
+
+  connection = g_bus_get_finish (res, &error);
+  if (!connection)
+    {
+      g_task_return_error (task, error);
+      g_object_unref (task);
+      return;
+    }
+
+  got_connection (task, connection);
+  g_object_unref (connection);
+}
+
+/**
+ * cc_power_capabilities_get:
+ * @connection: (nullable): the connection to ask on, or %NULL for the
+ *   system bus
+ * @cancellable: a #GCancellable
+ * @callback: called when the capabilities are known
+ * @user_data: data for @callback
+ *
+ * Finds out the chassis type of the machine and whether it can suspend
+ * and hibernate. Failing calls are taken to mean that it can't.
+ */
+void
+cc_power_capabilities_get (GDBusConnection     *connection,
+                           GCancellable        *cancellable,
+                           GAsyncReadyCallback  callback,
+                           gpointer             user_data)
+{
+  GTask *task;
+
+  task = g_task_new (NULL, cancellable, callback, user_data);
+  g_task_set_source_tag (task, cc_power_capabilities_get);
+
+  if (connection != NULL)
+    got_connection (task, connection);
+  else
+    g_bus_get (G_BUS_TYPE_SYSTEM, cancellable, got_bus_cb, task);
+}
+
+/**
+ * cc_power_capabilities_get_finish:
+ *
+ * Returns: (transfer none): the capabilities, which stay valid for as
+ *   long as the connection they were asked on
+ */
+const CcPowerCapabilities *
+cc_power_capabilities_get_finish (GAsyncResult  *result,
+                                  GError       **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, NULL), NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
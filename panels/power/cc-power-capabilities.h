@@ -0,0 +1,44 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*-
+ *
+ * Copyright (C) 2017 Red Hat, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef _CC_POWER_CAPABILITIES_H
+#define _CC_POWER_CAPABILITIES_H
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef struct
+{
+  gchar    *chassis_type;
+  gboolean  can_suspend;
+  gboolean  can_hibernate;
+} CcPowerCapabilities;
+
+void                       cc_power_capabilities_get        (GDBusConnection     *connection,
+                                                             GCancellable        *cancellable,
+                                                             GAsyncReadyCallback  callback,
+                                                             gpointer             user_data);
+
+const CcPowerCapabilities *cc_power_capabilities_get_finish (GAsyncResult        *result,
+                                                             GError             **error);
+
+G_END_DECLS
+
+#endif /* _CC_POWER_CAPABILITIES_H */
@@ -0,0 +1,294 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*-
+ *
+ * Copyright (C) 2017 Red Hat, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <config.h>
+
+#include "cc-power-devices.h"
+
+/* Keeps the list of UPower devices up to date, and tells apart the
+ * changes that need the rows to be laid out again (devices coming and
+ * going, or changing kind) from the ones that only change what a row
+ * shows. Wireless peripherals report their levels often, so the changes
+ * are gathered and only signalled once the main loop is idle. */
+struct _CcPowerDevices
+{
+  GObject parent_instance;
+
+  UpClient *client;
+  GPtrArray *devices;
+  UpDevice *display_device;
+
+  GHashTable *changed;  /* UpDevice set */
+  gboolean layout_changed;
+  guint changes_id;
+};
+
+enum {
+  LAYOUT_CHANGED,
+  DEVICE_CHANGED,
+  LAST_SIGNAL
+};
+
+static guint signals[LAST_SIGNAL] = { 0 };
+
+G_DEFINE_TYPE (CcPowerDevices, cc_power_devices, G_TYPE_OBJECT)
+
+static gboolean
+changes_idle_cb (gpointer user_data)
+{
+  CcPowerDevices *self = user_data;
+  GHashTable *changed;
+  GHashTableIter iter;
+  gpointer device;
+
+  self->changes_id = 0;
+
+  if (self->layout_changed)
+    {
+      self->layout_changed = FALSE;
+      g_hash_table_remove_all (self->changed);
+      g_signal_emit (self, signals[LAYOUT_CHANGED], 0);
+      return G_SOURCE_REMOVE;
+    }
+
+  changed = self->changed;
+  self->changed = g_hash_table_new (NULL, NULL);
+
+  g_hash_table_iter_init (&iter, changed);
+  while (g_hash_table_iter_next (&iter, &device, NULL))
+    g_signal_emit (self, signals[DEVICE_CHANGED], 0, device);
+
+  g_hash_table_unref (changed);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+queue_changes (CcPowerDevices *self)
+{
+  if (self->changes_id != 0)
+    return;
+
+  self->changes_id = g_idle_add (changes_idle_cb, self);
+}
+
+static void
+device_notify_cb (UpDevice       *device,
+                  GParamSpec     *pspec,
+                  CcPowerDevices *self)
+{
+  /* The kind of a device decides which list it goes in, and
+   * peripherals that are not present are not shown at all */
+  if (g_str_equal (pspec->name, "kind") ||
+      g_str_equal (pspec->name, "is-present"))
+    self->layout_changed = TRUE;
+  else
+    g_hash_table_add (self->changed, device);
+
+  queue_changes (self);
+}
+
+static void
+watch_device (CcPowerDevices *self,
+              UpDevice       *device)
+{
+  g_signal_connect (device, "notify",
+                    G_CALLBACK (device_notify_cb), self);
+}
+
+static void
+unwatch_device (CcPowerDevices *self,
+                UpDevice       *device)
+{
+  g_signal_handlers_disconnect_by_func (device, device_notify_cb, self);
+  g_hash_table_remove (self->changed, device);
+}
+
+static void
+device_added_cb (UpClient       *client,
+                 UpDevice       *device,
+                 CcPowerDevices *self)
+{
+  g_ptr_array_add (self->devices, g_object_ref (device));
+  watch_device (self, device);
+
+  self->layout_changed = TRUE;
+  queue_changes (self);
+}
+
+static void
+device_removed_cb (UpClient       *client,
+                   const char     *object_path,
+                   CcPowerDevices *self)
+{
+  guint i;
+
+  for (i = 0; i < self->devices->len; i++)
+    {
+      UpDevice *device = g_ptr_array_index (self->devices, i);
+
+      if (g_strcmp0 (object_path, up_device_get_object_path (device)) == 0)
+        {
+          unwatch_device (self, device);
+          g_ptr_array_remove_index (self->devices, i);
+
+          self->layout_changed = TRUE;
+          queue_changes (self);
+          break;
+        }
+    }
+}
+
+static void
+cc_power_devices_dispose (GObject *object)
+{
+  CcPowerDevices *self = CC_POWER_DEVICES (object);
+  guint i;
+
+  if (self->changes_id != 0)
+    {
+      g_source_remove (self->changes_id);
+      self->changes_id = 0;
+    }
+
+  if (self->client)
+    {
+      g_signal_handlers_disconnect_by_data (self->client, self);
+      g_clear_object (&self->client);
+    }
+
+  if (self->devices)
+    {
+      for (i = 0; i < self->devices->len; i++)
+        unwatch_device (self, g_ptr_array_index (self->devices, i));
+      g_clear_pointer (&self->devices, g_ptr_array_unref);
+    }
+
+  if (self->display_device)
+    {
+      unwatch_device (self, self->display_device);
+      g_clear_object (&self->display_device);
+    }
+
+  G_OBJECT_CLASS (cc_power_devices_parent_class)->dispose (object);
+}
+
+static void
+cc_power_devices_finalize (GObject *object)
+{
+  CcPowerDevices *self = CC_POWER_DEVICES (object);
+
+  g_hash_table_unref (self->changed);
+
+  G_OBJECT_CLASS (cc_power_devices_parent_class)->finalize (object);
+}
+
+static void
+cc_power_devices_class_init (CcPowerDevicesClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = cc_power_devices_dispose;
+  object_class->finalize = cc_power_devices_finalize;
+
+  /* Devices were added or removed, or changed kind */
+  signals[LAYOUT_CHANGED] =
+    g_signal_new ("layout-changed",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL, NULL,
+                  G_TYPE_NONE, 0);
+
+  /* The level, state or description of a device changed */
+  signals[DEVICE_CHANGED] =
+    g_signal_new ("device-changed",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL, NULL,
+                  G_TYPE_NONE, 1, UP_TYPE_DEVICE);
+}
+
+static void
+cc_power_devices_init (CcPowerDevices *self)
+{
+  self->changed = g_hash_table_new (NULL, NULL);
+}
+
+CcPowerDevices *
+cc_power_devices_new (UpClient *client)
+{
+  CcPowerDevices *self;
+  GPtrArray *devices;
+  guint i;
+
+  g_return_val_if_fail (UP_IS_CLIENT (client), NULL);
+
+  self = g_object_new (CC_TYPE_POWER_DEVICES, NULL);
+  self->client = g_object_ref (client);
+
+  g_signal_connect (client, "device-added",
+                    G_CALLBACK (device_added_cb), self);
+  g_signal_connect (client, "device-removed",
+                    G_CALLBACK (device_removed_cb), self);
+
+  self->devices = g_ptr_array_new_with_free_func (g_object_unref);
+
+  devices = up_client_get_devices (client);
+  for (i = 0; devices != NULL && i < devices->len; i++)
+    {
+      UpDevice *device = g_ptr_array_index (devices, i);
+
+      g_ptr_array_add (self->devices, g_object_ref (device));
+      watch_device (self, device);
+    }
+  if (devices != NULL)
+    {
+      /* Older libupower-glib hands out the array without a free function */
+      g_ptr_array_set_free_func (devices, g_object_unref);
+      g_ptr_array_unref (devices);
+    }
+
+  self->display_device = up_client_get_display_device (client);
+  if (self->display_device)
+    watch_device (self, self->display_device);
+
+  return self;
+}
+
+/* Returns: (transfer none) (element-type UpDevice): the batteries and
+ * peripherals, without the display device */
+GPtrArray *
+cc_power_devices_get_devices (CcPowerDevices *self)
+{
+  g_return_val_if_fail (CC_IS_POWER_DEVICES (self), NULL);
+
+  return self->devices;
+}
+
+/* Returns: (transfer none) (nullable): the composite device UPower
+ * shows for the whole machine */
+UpDevice *
+cc_power_devices_get_display_device (CcPowerDevices *self)
+{
+  g_return_val_if_fail (CC_IS_POWER_DEVICES (self), NULL);
+
+  return self->display_device;
+}
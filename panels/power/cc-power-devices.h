@@ -0,0 +1,37 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*-
+ *
+ * Copyright (C) 2017 Red Hat, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef _CC_POWER_DEVICES_H
+#define _CC_POWER_DEVICES_H
+
+#include <libupower-glib/upower.h>
+
+G_BEGIN_DECLS
+
+#define CC_TYPE_POWER_DEVICES (cc_power_devices_get_type ())
+G_DECLARE_FINAL_TYPE (CcPowerDevices, cc_power_devices, CC, POWER_DEVICES, GObject)
+
+CcPowerDevices *cc_power_devices_new                (UpClient       *client);
+
+GPtrArray      *cc_power_devices_get_devices        (CcPowerDevices *self);
+UpDevice       *cc_power_devices_get_display_device (CcPowerDevices *self);
+
+G_END_DECLS
+
+#endif /* _CC_POWER_DEVICES_H */
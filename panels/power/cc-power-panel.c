@@ -31,7 +31,10 @@
 
 #include "shell/list-box-helper.h"
 #include "cc-power-panel.h"
+#include "cc-power-capabilities.h"
+#include "cc-power-devices.h"
 #include "cc-power-resources.h"
+#include "cc-rfkill-state.h"
 
 /* Uncomment this to test the behaviour of the panel in
  * battery-less situations:
@@ -60,11 +63,11 @@ struct _CcPowerPanelPrivate
   GtkBuilder    *builder;
   GtkWidget     *automatic_suspend_dialog;
   UpClient      *up_client;
-  GPtrArray     *devices;
+  CcPowerDevices *power_devices;
+  GHashTable    *device_rows;
   GDBusProxy    *screen_proxy;
   GDBusProxy    *kbd_proxy;
   gboolean       has_batteries;
-  char          *chassis_type;
 
   GList         *boxes;
   GList         *boxes_reverse;
@@ -93,8 +96,7 @@ struct _CcPowerPanelPrivate
   GtkWidget     *automatic_suspend_row;
   GtkWidget     *automatic_suspend_label;
 
-  GDBusProxy    *bt_rfkill;
-  GDBusProxy    *bt_properties;
+  CcRfkillState *bt_rfkill;
   GtkWidget     *bt_switch;
   GtkWidget     *bt_row;
 
@@ -125,7 +127,6 @@ cc_power_panel_dispose (GObject *object)
 {
   CcPowerPanelPrivate *priv = CC_POWER_PANEL (object)->priv;
 
-  g_clear_pointer (&priv->chassis_type, g_free);
   g_clear_object (&priv->gsd_settings);
   g_clear_object (&priv->session_settings);
   if (priv->cancellable != NULL)
@@ -138,14 +139,10 @@ cc_power_panel_dispose (GObject *object)
   g_clear_object (&priv->builder);
   g_clear_object (&priv->screen_proxy);
   g_clear_object (&priv->kbd_proxy);
-  if (priv->devices)
-    {
-      g_ptr_array_foreach (priv->devices, (GFunc) g_object_unref, NULL);
-      g_clear_pointer (&priv->devices, g_ptr_array_unref);
-    }
+  g_clear_object (&priv->power_devices);
+  g_clear_pointer (&priv->device_rows, g_hash_table_unref);
   g_clear_object (&priv->up_client);
   g_clear_object (&priv->bt_rfkill);
-  g_clear_object (&priv->bt_properties);
   g_clear_object (&priv->iio_proxy);
 #ifdef HAVE_NETWORK_MANAGER
   g_clear_object (&priv->nm_client);
@@ -187,57 +184,6 @@ no_prelight_row_new (void)
                                      NULL);
 }
 
-static char *
-get_chassis_type (GCancellable *cancellable)
-{
-  char *ret = NULL;
-  GError *error = NULL;
-  GVariant *inner;
-  GVariant *variant = NULL;
-  GDBusConnection *connection;
-
-  connection = g_bus_get_sync (G_BUS_TYPE_SYSTEM,
-                               cancellable,
-                               &error);
-  if (!connection)
-    {
-      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
-        g_warning ("system bus not available: %s", error->message);
-      g_error_free (error);
-      goto out;
-    }
-
-  variant = g_dbus_connection_call_sync (connection,
-                                         "org.freedesktop.hostname1",
-                                         "/org/freedesktop/hostname1",
-                                         "org.freedesktop.DBus.Properties",
-                                         "Get",
-                                         g_variant_new ("(ss)",
-                                                        "org.freedesktop.hostname1",
-                                                        "Chassis"),
-                                         NULL,
-                                         G_DBUS_CALL_FLAGS_NONE,
-                                         -1,
-                                         cancellable,
-                                         &error);
-  if (!variant)
-    {
-      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
-        g_debug ("Failed to get property '%s': %s", "Chassis", error->message);
-      g_error_free (error);
-      goto out;
-    }
-
-  g_variant_get (variant, "(v)", &inner);
-  ret = g_variant_dup_string (inner, NULL);
-  g_variant_unref (inner);
-
-out:
-  g_clear_object (&connection);
-  g_clear_pointer (&variant, g_variant_unref);
-  return ret;
-}
-
 static gchar *
 get_timestring (guint64 time_secs)
 {
@@ -358,38 +304,19 @@ get_details_string (gdouble percentage, UpDeviceState state, guint64 time)
   return details;
 }
 
-static void
-set_primary (CcPowerPanel *panel, UpDevice *device)
+enum
+{
+  ROW_PRIMARY,
+  ROW_BATTERY,
+  ROW_DEVICE
+};
+
+static GtkWidget *
+new_primary_row (CcPowerPanel *panel)
 {
   CcPowerPanelPrivate *priv = panel->priv;
-  gchar *details = NULL;
-  gdouble percentage;
-  guint64 time_empty, time_full, time;
-  UpDeviceState state;
   GtkWidget *box, *box2, *label;
   GtkWidget *levelbar, *row;
-  gchar *s;
-  gdouble energy_full, energy_rate;
-
-  g_object_get (device,
-                "state", &state,
-                "percentage", &percentage,
-                "time-to-empty", &time_empty,
-                "time-to-full", &time_full,
-                "energy-full", &energy_full,
-                "energy-rate", &energy_rate,
-                NULL);
-  if (state == UP_DEVICE_STATE_DISCHARGING)
-    time = time_empty;
-  else
-    time = time_full;
-
-  /* Sometimes the reported state is fully charged but battery is at 99%,
-     refusing to reach 100%. In these cases, just assume 100%. */
-  if (state == UP_DEVICE_STATE_FULLY_CHARGED && (100.0 - percentage <= 1.0))
-    percentage = 100.0;
-
-  details = get_details_string (percentage, state, time);
 
   row = no_prelight_row_new ();
   box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
@@ -401,25 +328,25 @@ set_primary (CcPowerPanel *panel, UpDevice *device)
   gtk_widget_set_margin_bottom (box, 6);
 
   levelbar = gtk_level_bar_new ();
-  gtk_level_bar_set_value (GTK_LEVEL_BAR (levelbar), percentage / 100.0);
   gtk_widget_set_hexpand (levelbar, TRUE);
   gtk_widget_set_halign (levelbar, GTK_ALIGN_FILL);
   gtk_widget_set_valign (levelbar, GTK_ALIGN_CENTER);
   gtk_box_pack_start (GTK_BOX (box), levelbar, TRUE, TRUE, 0);
+  g_object_set_data (G_OBJECT (row), "level-bar", levelbar);
 
   box2 = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 50);
   gtk_box_pack_start (GTK_BOX (box), box2, FALSE, TRUE, 0);
 
-  label = gtk_label_new (details);
+  label = gtk_label_new (NULL);
   gtk_widget_set_halign (label, GTK_ALIGN_START);
   gtk_box_pack_start (GTK_BOX (box2), label, TRUE, TRUE, 0);
+  g_object_set_data (G_OBJECT (row), "details-label", label);
 
-  s = g_strdup_printf ("%d%%", (int)(percentage + 0.5));
-  label = gtk_label_new (s);
-  g_free (s);
+  label = gtk_label_new (NULL);
   gtk_widget_set_halign (label, GTK_ALIGN_END);
   gtk_style_context_add_class (gtk_widget_get_style_context (label), GTK_STYLE_CLASS_DIM_LABEL);
   gtk_box_pack_start (GTK_BOX (box2), label, FALSE, TRUE, 0);
+  g_object_set_data (G_OBJECT (row), "percentage-label", label);
 
   atk_object_add_relationship (gtk_widget_get_accessible (levelbar),
                                ATK_RELATION_LABELLED_BY,
@@ -431,46 +358,66 @@ set_primary (CcPowerPanel *panel, UpDevice *device)
 
   g_object_set_data (G_OBJECT (row), "primary", GINT_TO_POINTER (TRUE));
 
-  g_free (details);
-
-  gtk_widget_set_visible (priv->battery_section, TRUE);
+  return row;
 }
 
 static void
-add_battery (CcPowerPanel *panel, UpDevice *device)
+update_primary_row (GtkWidget *row, UpDevice *device)
 {
-  CcPowerPanelPrivate *priv = panel->priv;
+  gchar *details = NULL;
   gdouble percentage;
-  UpDeviceKind kind;
+  guint64 time_empty, time_full, time;
   UpDeviceState state;
-  GtkWidget *row;
-  GtkWidget *box;
-  GtkWidget *box2;
-  GtkWidget *label;
-  GtkWidget *levelbar;
   GtkWidget *widget;
   gchar *s;
-  gchar *icon_name;
-  const gchar *name;
 
   g_object_get (device,
-                "kind", &kind,
                 "state", &state,
                 "percentage", &percentage,
-                "icon-name", &icon_name,
+                "time-to-empty", &time_empty,
+                "time-to-full", &time_full,
                 NULL);
-
-  if (g_object_get_data (G_OBJECT (device), "is-main-battery") != NULL)
-    name = C_("Battery name", "Main");
+  if (state == UP_DEVICE_STATE_DISCHARGING)
+    time = time_empty;
   else
-    name = C_("Battery name", "Extra");
+    time = time_full;
+
+  /* Sometimes the reported state is fully charged but battery is at 99%,
+     refusing to reach 100%. In these cases, just assume 100%. */
+  if (state == UP_DEVICE_STATE_FULLY_CHARGED && (100.0 - percentage <= 1.0))
+    percentage = 100.0;
+
+  details = get_details_string (percentage, state, time);
+  widget = g_object_get_data (G_OBJECT (row), "details-label");
+  gtk_label_set_text (GTK_LABEL (widget), details);
+  g_free (details);
+
+  widget = g_object_get_data (G_OBJECT (row), "level-bar");
+  gtk_level_bar_set_value (GTK_LEVEL_BAR (widget), percentage / 100.0);
+
+  s = g_strdup_printf ("%d%%", (int)(percentage + 0.5));
+  widget = g_object_get_data (G_OBJECT (row), "percentage-label");
+  gtk_label_set_text (GTK_LABEL (widget), s);
+  g_free (s);
+}
+
+static GtkWidget *
+new_battery_row (CcPowerPanel *panel)
+{
+  CcPowerPanelPrivate *priv = panel->priv;
+  GtkWidget *row;
+  GtkWidget *box;
+  GtkWidget *box2;
+  GtkWidget *label;
+  GtkWidget *levelbar;
+  GtkWidget *widget;
 
   row = no_prelight_row_new ();
   box = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
   gtk_container_add (GTK_CONTAINER (row), box);
 
   box2 = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
-  label = gtk_label_new (name);
+  label = gtk_label_new (NULL);
   gtk_widget_set_halign (label, GTK_ALIGN_START);
   gtk_size_group_add_widget (priv->battery_sizegroup, box2);
   gtk_widget_set_margin_start (label, 20);
@@ -479,52 +426,94 @@ add_battery (CcPowerPanel *panel, UpDevice *device)
   gtk_widget_set_margin_bottom (label, 6);
   gtk_box_pack_start (GTK_BOX (box2), label, FALSE, TRUE, 0);
   gtk_box_pack_start (GTK_BOX (box), box2, FALSE, TRUE, 0);
+  g_object_set_data (G_OBJECT (row), "name-label", label);
 
-#if 1
-  if (icon_name != NULL && *icon_name != '\0')
-    {
-      widget = gtk_image_new_from_icon_name (icon_name, GTK_ICON_SIZE_BUTTON);
-      gtk_style_context_add_class (gtk_widget_get_style_context (widget), GTK_STYLE_CLASS_DIM_LABEL);
-      gtk_widget_set_halign (widget, GTK_ALIGN_END);
-      gtk_widget_set_valign (widget, GTK_ALIGN_CENTER);
-      gtk_box_pack_start (GTK_BOX (box2), widget, TRUE, TRUE, 0);
-    }
-#endif
+  /* Only shown when the battery has an icon */
+  widget = gtk_image_new ();
+  gtk_widget_set_no_show_all (widget, TRUE);
+  gtk_style_context_add_class (gtk_widget_get_style_context (widget), GTK_STYLE_CLASS_DIM_LABEL);
+  gtk_widget_set_halign (widget, GTK_ALIGN_END);
+  gtk_widget_set_valign (widget, GTK_ALIGN_CENTER);
+  gtk_box_pack_start (GTK_BOX (box2), widget, TRUE, TRUE, 0);
+  g_object_set_data (G_OBJECT (row), "icon", widget);
 
   box2 = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 12);
   gtk_widget_set_margin_start (box2, 20);
   gtk_widget_set_margin_end (box2, 20);
 
-  s = g_strdup_printf ("%d%%", (int)percentage);
-  label = gtk_label_new (s);
-  g_free (s);
+  label = gtk_label_new (NULL);
   gtk_widget_set_halign (label, GTK_ALIGN_END);
   gtk_style_context_add_class (gtk_widget_get_style_context (label), GTK_STYLE_CLASS_DIM_LABEL);
   gtk_box_pack_start (GTK_BOX (box2), label, FALSE, TRUE, 0);
   gtk_size_group_add_widget (priv->charge_sizegroup, label);
+  g_object_set_data (G_OBJECT (row), "percentage-label", label);
 
   levelbar = gtk_level_bar_new ();
-  gtk_level_bar_set_value (GTK_LEVEL_BAR (levelbar), percentage / 100.0);
   gtk_widget_set_hexpand (levelbar, TRUE);
   gtk_widget_set_halign (levelbar, GTK_ALIGN_FILL);
   gtk_widget_set_valign (levelbar, GTK_ALIGN_CENTER);
   gtk_box_pack_start (GTK_BOX (box2), levelbar, TRUE, TRUE, 0);
   gtk_size_group_add_widget (priv->level_sizegroup, levelbar);
   gtk_box_pack_start (GTK_BOX (box), box2, TRUE, TRUE, 0);
+  g_object_set_data (G_OBJECT (row), "level-bar", levelbar);
 
   atk_object_add_relationship (gtk_widget_get_accessible (levelbar),
                                ATK_RELATION_LABELLED_BY,
                                gtk_widget_get_accessible (label));
 
-
-  g_object_set_data (G_OBJECT (row), "kind", GINT_TO_POINTER (kind));
   gtk_container_add (GTK_CONTAINER (priv->battery_list), row);
   gtk_size_group_add_widget (priv->row_sizegroup, row);
   gtk_widget_show_all (row);
 
-  g_free (icon_name);
+  return row;
+}
+
+static void
+update_battery_row (GtkWidget *row, UpDevice *device)
+{
+  gdouble percentage;
+  UpDeviceKind kind;
+  GtkWidget *widget;
+  gchar *s;
+  gchar *icon_name;
+  const gchar *name;
+
+  g_object_get (device,
+                "kind", &kind,
+                "percentage", &percentage,
+                "icon-name", &icon_name,
+                NULL);
+
+  if (g_object_get_data (G_OBJECT (device), "is-main-battery") != NULL)
+    name = C_("Battery name", "Main");
+  else
+    name = C_("Battery name", "Extra");
+
+  widget = g_object_get_data (G_OBJECT (row), "name-label");
+  gtk_label_set_text (GTK_LABEL (widget), name);
+
+  widget = g_object_get_data (G_OBJECT (row), "icon");
+  if (icon_name != NULL && *icon_name != '\0')
+    {
+      gtk_image_set_from_icon_name (GTK_IMAGE (widget), icon_name, GTK_ICON_SIZE_BUTTON);
+      gtk_widget_show (widget);
+    }
+  else
+    {
+      gtk_widget_hide (widget);
+    }
+
+  s = g_strdup_printf ("%d%%", (int)percentage);
+  widget = g_object_get_data (G_OBJECT (row), "percentage-label");
+  gtk_label_set_text (GTK_LABEL (widget), s);
+  g_free (s);
+
+  widget = g_object_get_data (G_OBJECT (row), "level-bar");
+  gtk_level_bar_set_value (GTK_LEVEL_BAR (widget), percentage / 100.0);
 
-  gtk_widget_set_visible (priv->battery_section, TRUE);
+  g_object_set_data (G_OBJECT (row), "kind", GINT_TO_POINTER (kind));
+
+  g_free (icon_name);
 }
 
 static const char *
@@ -564,88 +553,14 @@ kind_to_description (UpDeviceKind kind)
   g_assert_not_reached ();
 }
 
-static void
-add_device (CcPowerPanel *panel, UpDevice *device)
+static GtkWidget *
+new_device_row (CcPowerPanel *panel)
 {
   CcPowerPanelPrivate *priv = panel->priv;
-  UpDeviceKind kind;
-  UpDeviceState state;
   GtkWidget *row;
   GtkWidget *hbox;
   GtkWidget *box2;
   GtkWidget *widget;
-  GString *status;
-  GString *description;
-  gdouble percentage;
-  gchar *name;
-  gchar *s;
-  gboolean show_caution = FALSE;
-  gboolean is_present;
-
-  name = NULL;
-  g_object_get (device,
-                "kind", &kind,
-                "percentage", &percentage,
-                "state", &state,
-                "model", &name,
-                "is-present", &is_present,
-                NULL);
-
-  if (!is_present)
-    {
-      g_free (name);
-      return;
-    }
-
-  if (kind == UP_DEVICE_KIND_UPS)
-    show_caution = TRUE;
-
-  if (name == NULL || *name == '\0')
-    description = g_string_new (_(kind_to_description (kind)));
-  else
-    description = g_string_new (name);
-
-  g_free (name);
-
-  switch (state)
-    {
-      case UP_DEVICE_STATE_CHARGING:
-      case UP_DEVICE_STATE_PENDING_CHARGE:
-        /* TRANSLATORS: secondary battery */
-        status = g_string_new(C_("Battery power", "Charging"));
-        break;
-      case UP_DEVICE_STATE_DISCHARGING:
-      case UP_DEVICE_STATE_PENDING_DISCHARGE:
-        if (percentage < 10 && show_caution)
-          {
-            /* TRANSLATORS: secondary battery */
-            status = g_string_new (C_("Battery power", "Caution"));
-          }
-        else if (percentage < 30)
-          {
-            /* TRANSLATORS: secondary battery */
-            status = g_string_new (C_("Battery power", "Low"));
-          }
-        else
-          {
-            /* TRANSLATORS: secondary battery */
-            status = g_string_new (C_("Battery power", "Good"));
-          }
-        break;
-      case UP_DEVICE_STATE_FULLY_CHARGED:
-        /* TRANSLATORS: primary battery */
-        status = g_string_new (C_("Battery power", "Fully charged"));
-        break;
-      case UP_DEVICE_STATE_EMPTY:
-        /* TRANSLATORS: primary battery */
-        status = g_string_new (C_("Battery power", "Empty"));
-        break;
-      default:
-        status = g_string_new (up_device_state_to_string (state));
-        break;
-    }
-  g_string_prepend (status, "<small>");
-  g_string_append (status, "</small>");
 
   /* create the new widget */
   row = no_prelight_row_new ();
@@ -653,74 +568,161 @@ add_device (CcPowerPanel *panel, UpDevice *device)
   gtk_container_add (GTK_CONTAINER (row), hbox);
   widget = gtk_label_new ("");
   gtk_widget_set_halign (widget, GTK_ALIGN_START);
-  gtk_label_set_markup (GTK_LABEL (widget), description->str);
   gtk_widget_set_margin_start (widget, 20);
   gtk_widget_set_margin_end (widget, 20);
   gtk_widget_set_margin_top (widget, 6);
   gtk_widget_set_margin_bottom (widget, 6);
   gtk_box_pack_start (GTK_BOX (hbox), widget, FALSE, TRUE, 0);
   gtk_size_group_add_widget (priv->battery_sizegroup, widget);
+  g_object_set_data (G_OBJECT (row), "name-label", widget);
 
   box2 = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 12);
   gtk_widget_set_margin_start (box2, 20);
   gtk_widget_set_margin_end (box2, 20);
-  s = g_strdup_printf ("%d%%", (int)percentage);
-  widget = gtk_label_new (s);
-  g_free (s);
+  widget = gtk_label_new (NULL);
   gtk_widget_set_halign (widget, GTK_ALIGN_END);
   gtk_style_context_add_class (gtk_widget_get_style_context (widget), GTK_STYLE_CLASS_DIM_LABEL);
   gtk_box_pack_start (GTK_BOX (box2), widget, FALSE, TRUE, 0);
   gtk_size_group_add_widget (priv->charge_sizegroup, widget);
+  g_object_set_data (G_OBJECT (row), "percentage-label", widget);
 
   widget = gtk_level_bar_new ();
   gtk_widget_set_halign (widget, TRUE);
   gtk_widget_set_halign (widget, GTK_ALIGN_FILL);
   gtk_widget_set_valign (widget, GTK_ALIGN_CENTER);
-  gtk_level_bar_set_value (GTK_LEVEL_BAR (widget), percentage / 100.0f);
   gtk_box_pack_start (GTK_BOX (box2), widget, TRUE, TRUE, 0);
   gtk_size_group_add_widget (priv->level_sizegroup, widget);
   gtk_box_pack_start (GTK_BOX (hbox), box2, TRUE, TRUE, 0);
+  g_object_set_data (G_OBJECT (row), "level-bar", widget);
   gtk_widget_show_all (row);
 
   gtk_container_add (GTK_CONTAINER (priv->device_list), row);
   gtk_size_group_add_widget (priv->row_sizegroup, row);
+
+  return row;
+}
+
+static void
+update_device_row (GtkWidget *row, UpDevice *device)
+{
+  UpDeviceKind kind;
+  GtkWidget *widget;
+  gdouble percentage;
+  gchar *name;
+  gchar *s;
+
+  name = NULL;
+  g_object_get (device,
+                "kind", &kind,
+                "percentage", &percentage,
+                "model", &name,
+                NULL);
+
+  widget = g_object_get_data (G_OBJECT (row), "name-label");
+  if (name == NULL || *name == '\0')
+    gtk_label_set_markup (GTK_LABEL (widget), _(kind_to_description (kind)));
+  else
+    gtk_label_set_markup (GTK_LABEL (widget), name);
+  g_free (name);
+
+  s = g_strdup_printf ("%d%%", (int)percentage);
+  widget = g_object_get_data (G_OBJECT (row), "percentage-label");
+  gtk_label_set_text (GTK_LABEL (widget), s);
+  g_free (s);
+
+  widget = g_object_get_data (G_OBJECT (row), "level-bar");
+  gtk_level_bar_set_value (GTK_LEVEL_BAR (widget), percentage / 100.0f);
+
   g_object_set_data (G_OBJECT (row), "kind", GINT_TO_POINTER (kind));
+}
+
+static void
+update_row (GtkWidget *row, UpDevice *device)
+{
+  switch (GPOINTER_TO_INT (g_object_get_data (G_OBJECT (row), "row-type")))
+    {
+      case ROW_PRIMARY:
+        update_primary_row (row, device);
+        break;
+      case ROW_BATTERY:
+        update_battery_row (row, device);
+        break;
+      case ROW_DEVICE:
+        update_device_row (row, device);
+        break;
+      default:
+        g_assert_not_reached ();
+    }
+}
+
+/* Moves the row already showing @device to @rows if it is of the right
+ * type, or creates a new one */
+static void
+add_device_row (CcPowerPanel *self,
+                GHashTable   *rows,
+                UpDevice     *device,
+                gint          row_type)
+{
+  CcPowerPanelPrivate *priv = self->priv;
+  GtkWidget *row;
 
-  g_string_free (description, TRUE);
-  g_string_free (status, TRUE);
+  row = g_hash_table_lookup (priv->device_rows, device);
+  if (row != NULL &&
+      GPOINTER_TO_INT (g_object_get_data (G_OBJECT (row), "row-type")) == row_type)
+    {
+      /* The reference on the device moves along with the row */
+      g_hash_table_steal (priv->device_rows, device);
+      g_hash_table_insert (rows, device, row);
+    }
+  else
+    {
+      switch (row_type)
+        {
+          case ROW_PRIMARY:
+            row = new_primary_row (self);
+            break;
+          case ROW_BATTERY:
+            row = new_battery_row (self);
+            break;
+          case ROW_DEVICE:
+            row = new_device_row (self);
+            break;
+          default:
+            g_assert_not_reached ();
+        }
+      g_object_set_data (G_OBJECT (row), "row-type", GINT_TO_POINTER (row_type));
+      g_hash_table_insert (rows, g_object_ref (device), row);
+    }
 
-  gtk_widget_set_visible (priv->device_section, TRUE);
+  update_row (row, device);
 }
 
+/* Lays the rows out again when devices come and go. Rows for devices
+ * that are still in the same place are kept, so that only the rows that
+ * actually changed get rebuilt */
 static void
-up_client_changed (UpClient     *client,
-                   UpDevice     *device,
-                   CcPowerPanel *self)
+update_device_rows (CcPowerPanel *self)
 {
   CcPowerPanelPrivate *priv = self->priv;
-  GList *children, *l;
+  GPtrArray *devices;
+  GHashTable *rows;
+  GHashTableIter iter;
+  gpointer row;
   gint i;
   UpDeviceKind kind;
   guint n_batteries;
   gboolean on_ups;
+  gboolean has_battery_rows = FALSE;
+  gboolean has_device_rows = FALSE;
   UpDevice *composite;
   gchar *s;
 
-  children = gtk_container_get_children (GTK_CONTAINER (priv->battery_list));
-  for (l = children; l != NULL; l = l->next)
-    gtk_container_remove (GTK_CONTAINER (priv->battery_list), l->data);
-  g_list_free (children);
-  gtk_widget_hide (priv->battery_section);
-
-  children = gtk_container_get_children (GTK_CONTAINER (priv->device_list));
-  for (l = children; l != NULL; l = l->next)
-    gtk_container_remove (GTK_CONTAINER (priv->device_list), l->data);
-  g_list_free (children);
-  gtk_widget_hide (priv->device_section);
+  devices = cc_power_devices_get_devices (priv->power_devices);
 
 #ifdef TEST_FAKE_DEVICES
   {
     static gboolean fake_devices_added = FALSE;
+    UpDevice *device;
 
     if (!fake_devices_added)
       {
@@ -736,7 +738,7 @@ up_client_changed (UpClient     *client,
                       "time-to-empty", 287,
                       "icon-name", "battery-full-symbolic",
                       NULL);
-        g_ptr_array_add (priv->devices, device);
+        g_ptr_array_add (devices, device);
         device = up_device_new ();
         g_object_set (device,
                       "kind", UP_DEVICE_KIND_KEYBOARD,
@@ -747,7 +749,7 @@ up_client_changed (UpClient     *client,
                       "time-to-empty", 250,
                       "icon-name", "battery-good-symbolic",
                       NULL);
-        g_ptr_array_add (priv->devices, device);
+        g_ptr_array_add (devices, device);
         device = up_device_new ();
         g_object_set (device,
                       "kind", UP_DEVICE_KIND_BATTERY,
@@ -761,15 +763,17 @@ up_client_changed (UpClient     *client,
                       "time-to-empty", 400,
                       "icon-name", "battery-full-charged-symbolic",
                       NULL);
-        g_ptr_array_add (priv->devices, device);
+        g_ptr_array_add (devices, device);
       }
   }
 #endif
 
   on_ups = FALSE;
   n_batteries = 0;
-  composite = up_client_get_display_device (priv->up_client);
-  g_object_get (composite, "kind", &kind, NULL);
+  kind = UP_DEVICE_KIND_UNKNOWN;
+  composite = cc_power_devices_get_display_device (priv->power_devices);
+  if (composite != NULL)
+    g_object_get (composite, "kind", &kind, NULL);
   if (kind == UP_DEVICE_KIND_UPS)
     {
       on_ups = TRUE;
@@ -779,18 +783,16 @@ up_client_changed (UpClient     *client,
       gboolean is_extra_battery = FALSE;
 
       /* Count the batteries */
-      for (i = 0; priv->devices != NULL && i < priv->devices->len; i++)
+      for (i = 0; i < devices->len; i++)
         {
-          UpDevice *device = (UpDevice*) g_ptr_array_index (priv->devices, i);
+          UpDevice *device = (UpDevice*) g_ptr_array_index (devices, i);
           g_object_get (device, "kind", &kind, NULL);
           if (kind == UP_DEVICE_KIND_BATTERY)
             {
               n_batteries++;
-              if (is_extra_battery == FALSE)
-                {
-                  is_extra_battery = TRUE;
-                  g_object_set_data (G_OBJECT (device), "is-main-battery", GINT_TO_POINTER(TRUE));
-                }
+              g_object_set_data (G_OBJECT (device), "is-main-battery",
+                                 GINT_TO_POINTER (!is_extra_battery));
+              is_extra_battery = TRUE;
             }
         }
     }
@@ -802,75 +804,72 @@ up_client_changed (UpClient     *client,
   gtk_label_set_label (GTK_LABEL (priv->battery_heading), s);
   g_free (s);
 
-  if (!on_ups && n_batteries > 1)
-    set_primary (self, composite);
+  rows = g_hash_table_new_full (NULL, NULL, g_object_unref, NULL);
 
-  for (i = 0; priv->devices != NULL && i < priv->devices->len; i++)
+  if (!on_ups && n_batteries > 1 && composite != NULL)
     {
-      UpDevice *device = (UpDevice*) g_ptr_array_index (priv->devices, i);
-      g_object_get (device, "kind", &kind, NULL);
+      add_device_row (self, rows, composite, ROW_PRIMARY);
+      has_battery_rows = TRUE;
+    }
+
+  for (i = 0; i < devices->len; i++)
+    {
+      UpDevice *device = (UpDevice*) g_ptr_array_index (devices, i);
+      gboolean is_present;
+
+      g_object_get (device,
+                    "kind", &kind,
+                    "is-present", &is_present,
+                    NULL);
       if (kind == UP_DEVICE_KIND_LINE_POWER)
         {
           /* do nothing */
         }
       else if (kind == UP_DEVICE_KIND_UPS && on_ups)
         {
-          set_primary (self, device);
+          add_device_row (self, rows, device, ROW_PRIMARY);
+          has_battery_rows = TRUE;
         }
       else if (kind == UP_DEVICE_KIND_BATTERY && !on_ups && n_batteries == 1)
         {
-          set_primary (self, device);
+          add_device_row (self, rows, device, ROW_PRIMARY);
+          has_battery_rows = TRUE;
         }
       else if (kind == UP_DEVICE_KIND_BATTERY)
         {
-          add_battery (self, device);
+          add_device_row (self, rows, device, ROW_BATTERY);
+          has_battery_rows = TRUE;
         }
-      else
+      else if (is_present)
         {
-          add_device (self, device);
+          add_device_row (self, rows, device, ROW_DEVICE);
+          has_device_rows = TRUE;
         }
     }
 
-  g_object_unref (composite);
-}
-
-static void
-up_client_device_removed (UpClient     *client,
-                          const char   *object_path,
-                          CcPowerPanel *self)
-{
-  CcPowerPanelPrivate *priv = self->priv;
-  guint i;
-
-  if (priv->devices == NULL)
-    return;
+  /* Whatever is left is for devices that went away, or moved */
+  g_hash_table_iter_init (&iter, priv->device_rows);
+  while (g_hash_table_iter_next (&iter, NULL, &row))
+    gtk_widget_destroy (row);
+  g_hash_table_unref (priv->device_rows);
+  priv->device_rows = rows;
 
-  for (i = 0; i < priv->devices->len; i++)
-    {
-      UpDevice *device = g_ptr_array_index (priv->devices, i);
-
-      if (g_strcmp0 (object_path, up_device_get_object_path (device)) == 0)
-        {
-          g_object_unref (device);
-          g_ptr_array_remove_index (priv->devices, i);
-          break;
-        }
-    }
+  gtk_list_box_invalidate_sort (GTK_LIST_BOX (priv->battery_list));
+  gtk_list_box_invalidate_sort (GTK_LIST_BOX (priv->device_list));
 
-  up_client_changed (self->priv->up_client, NULL, self);
+  gtk_widget_set_visible (priv->battery_section, has_battery_rows);
+  gtk_widget_set_visible (priv->device_section, has_device_rows);
 }
 
 static void
-up_client_device_added (UpClient     *client,
-                        UpDevice     *device,
-                        CcPowerPanel *self)
+device_changed_cb (CcPowerPanel *self,
+                   UpDevice     *device)
 {
-  CcPowerPanelPrivate *priv = self->priv;
+  GtkWidget *row;
 
-  g_ptr_array_add (priv->devices, g_object_ref (device));
-  g_signal_connect (G_OBJECT (device), "notify",
-                    G_CALLBACK (up_client_changed), self);
-  up_client_changed (priv->up_client, NULL, self);
+  row = g_hash_table_lookup (self->priv->device_rows, device);
+  if (row != NULL)
+    update_row (row, device);
 }
 
 static void
@@ -1195,10 +1194,10 @@ set_ac_battery_ui_mode (CcPowerPanel *self)
   UpDevice *device;
   UpDeviceKind kind;
 
-  devices = up_client_get_devices (self->priv->up_client);
-  g_debug ("got %d devices from upower\n", devices ? devices->len : 0);
+  devices = cc_power_devices_get_devices (self->priv->power_devices);
+  g_debug ("got %d devices from upower\n", devices->len);
 
-  for (i = 0; devices != NULL && i < devices->len; i++)
+  for (i = 0; i < devices->len; i++)
     {
       device = g_ptr_array_index (devices, i);
       g_object_get (device, "kind", &kind, NULL);
@@ -1208,7 +1207,6 @@ set_ac_battery_ui_mode (CcPowerPanel *self)
           break;
         }
     }
-  g_clear_pointer (&devices, g_ptr_array_unref);
 
 #ifdef TEST_NO_BATTERIES
   g_print ("forcing no batteries\n");
@@ -1232,14 +1230,7 @@ static void
 bt_set_powered (CcPowerPanel *self,
                 gboolean      powered)
 {
-  g_dbus_proxy_call (self->priv->bt_properties,
-		     "Set",
-		     g_variant_new_parsed ("('org.gnome.SettingsDaemon.Rfkill', 'BluetoothAirplaneMode', %v)",
-					   g_variant_new_boolean (!powered)),
-		     G_DBUS_CALL_FLAGS_NONE,
-		     -1,
-		     self->priv->cancellable,
-		     NULL, NULL);
+  cc_rfkill_state_set_bluetooth_airplane_mode (self->priv->bt_rfkill, !powered);
 }
 
 static void
@@ -1260,23 +1251,22 @@ static void
 bt_powered_state_changed (CcPowerPanel *panel)
 {
   CcPowerPanelPrivate *priv = panel->priv;
-  gboolean powered, has_airplane_mode;
-  GVariant *v;
+  gboolean powered;
 
-  v = g_dbus_proxy_get_cached_property (priv->bt_rfkill, "BluetoothHasAirplaneMode");
-  has_airplane_mode = g_variant_get_boolean (v);
-  g_variant_unref (v);
+  if (!cc_rfkill_state_is_ready (priv->bt_rfkill))
+    {
+      gtk_widget_hide (priv->bt_row);
+      return;
+    }
 
-  if (!has_airplane_mode)
+  if (!cc_rfkill_state_get_bluetooth_has_airplane_mode (priv->bt_rfkill))
     {
       g_debug ("BluetoothHasAirplaneMode is false, hiding Bluetooth power row");
       gtk_widget_hide (priv->bt_row);
       return;
     }
 
-  v = g_dbus_proxy_get_cached_property (priv->bt_rfkill, "BluetoothAirplaneMode");
-  powered = !g_variant_get_boolean (v);
-  g_variant_unref (v);
+  powered = !cc_rfkill_state_get_bluetooth_airplane_mode (priv->bt_rfkill);
 
   g_debug ("bt powered state changed to %s", powered ? "on" : "off");
 
@@ -1883,23 +1873,8 @@ add_power_saving_section (CcPowerPanel *self)
 #endif
 
 #ifdef HAVE_BLUETOOTH
-  priv->bt_rfkill = g_dbus_proxy_new_for_bus_sync (G_BUS_TYPE_SESSION,
-						   G_DBUS_PROXY_FLAGS_NONE,
-						   NULL,
-						   "org.gnome.SettingsDaemon.Rfkill",
-						   "/org/gnome/SettingsDaemon/Rfkill",
-						   "org.gnome.SettingsDaemon.Rfkill",
-						   NULL, NULL);
-  if (priv->bt_rfkill)
-    {
-      priv->bt_properties = g_dbus_proxy_new_for_bus_sync (G_BUS_TYPE_SESSION,
-							   G_DBUS_PROXY_FLAGS_NONE,
-							   NULL,
-							   "org.gnome.SettingsDaemon.Rfkill",
-							   "/org/gnome/SettingsDaemon/Rfkill",
-							   "org.freedesktop.DBus.Properties",
-							   NULL, NULL);
-    }
+  /* the row is shown once gnome-settings-daemon says there's Bluetooth */
+  priv->bt_rfkill = g_object_ref (cc_rfkill_state_get_default ());
 
   row = no_prelight_row_new ();
   box = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 50);
@@ -1924,8 +1899,9 @@ add_power_saving_section (CcPowerPanel *self)
   gtk_widget_show_all (box);
   gtk_widget_set_no_show_all (row, TRUE);
   priv->bt_row = row;
-  g_signal_connect_swapped (G_OBJECT (priv->bt_rfkill), "g-properties-changed",
-			G_CALLBACK (bt_powered_state_changed), self);
+  g_signal_connect_object (priv->bt_rfkill, "changed",
+                           G_CALLBACK (bt_powered_state_changed), self,
+                           G_CONNECT_SWAPPED);
   g_signal_connect (G_OBJECT (priv->bt_switch), "notify::active",
 		G_CALLBACK (bt_switch_changed), self);
 
@@ -2086,60 +2062,9 @@ populate_power_button_model (GtkTreeModel *model,
     }
 }
 
-static gboolean
-can_suspend_or_hibernate (CcPowerPanel *self,
-                          const char   *method_name)
-{
-  CcPowerPanelPrivate *priv = self->priv;
-  GDBusConnection *connection;
-  GVariant *variant;
-  gboolean result = FALSE;
-  GError *error = NULL;
-  const char *s;
-
-  connection = g_bus_get_sync (G_BUS_TYPE_SYSTEM,
-                               priv->cancellable,
-                               &error);
-  if (!connection)
-    {
-      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
-        g_warning ("system bus not available: %s", error->message);
-      g_error_free (error);
-      goto out;
-    }
-
-  variant = g_dbus_connection_call_sync (connection,
-                                         "org.freedesktop.login1",
-                                         "/org/freedesktop/login1",
-                                         "org.freedesktop.login1.Manager",
-                                         method_name,
-                                         NULL,
-                                         NULL,
-                                         G_DBUS_CALL_FLAGS_NONE,
-                                         -1,
-                                         priv->cancellable,
-                                         &error);
-  g_object_unref (connection);
-
-  if (!variant)
-    {
-      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
-        g_debug ("Failed to call %s(): %s", method_name, error->message);
-      g_error_free (error);
-      goto out;
-    }
-
-  g_variant_get (variant, "(&s)", &s);
-  if (g_strcmp0 (s, "yes") == 0)
-    result = TRUE;
-  g_variant_unref (variant);
-
- out:
-  return result;
-}
-
 static void
-add_suspend_and_power_off_section (CcPowerPanel *self)
+add_suspend_and_power_off_section (CcPowerPanel              *self,
+                                   const CcPowerCapabilities *caps)
 {
   CcPowerPanelPrivate *priv = self->priv;
   GtkWidget *vbox;
@@ -2153,8 +2078,8 @@ add_suspend_and_power_off_section (CcPowerPanel *self)
   GsdPowerButtonActionType button_value;
   gboolean can_suspend, can_hibernate;
 
-  can_suspend = can_suspend_or_hibernate (self, "CanSuspend");
-  can_hibernate = can_suspend_or_hibernate (self, "CanHibernate");
+  can_suspend = caps->can_suspend;
+  can_hibernate = caps->can_hibernate;
 
   /* If the machine can neither suspend nor hibernate, we have nothing to do */
   if (!can_suspend && !can_hibernate)
@@ -2282,8 +2207,8 @@ add_suspend_and_power_off_section (CcPowerPanel *self)
       update_automatic_suspend_label (self);
     }
 
-  if (g_strcmp0 (priv->chassis_type, "vm") == 0 ||
-      g_strcmp0 (priv->chassis_type, "tablet") == 0)
+  if (g_strcmp0 (caps->chassis_type, "vm") == 0 ||
+      g_strcmp0 (caps->chassis_type, "tablet") == 0)
     goto out;
 
   /* Power button row */
@@ -2321,6 +2246,35 @@ out:
   gtk_widget_show_all (widget);
 }
 
+static void
+got_capabilities_cb (GObject      *source_object,
+                     GAsyncResult *res,
+                     gpointer      user_data)
+{
+  CcPowerPanel *self;
+  CcPowerPanelPrivate *priv;
+  const CcPowerCapabilities *caps;
+  GError *error = NULL;
+
+  caps = cc_power_capabilities_get_finish (res, &error);
+  if (caps == NULL)
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_warning ("system bus not available: %s", error->message);
+      g_error_free (error);
+      return;
+    }
+
+  self = CC_POWER_PANEL (user_data);
+  priv = self->priv;
+
+  add_suspend_and_power_off_section (self, caps);
+
+  /* The section may have added a list box for keyboard navigation */
+  g_list_free (priv->boxes);
+  priv->boxes = g_list_reverse (g_list_copy (priv->boxes_reverse));
+}
+
 static gint
 battery_sort_func (gconstpointer a, gconstpointer b, gpointer data)
 {
@@ -2478,7 +2432,6 @@ cc_power_panel_init (CcPowerPanel *self)
   GError     *error;
   GtkWidget  *widget;
   GtkWidget  *box;
-  guint       i;
 
   priv = self->priv = POWER_PANEL_PRIVATE (self);
   g_resources_register (cc_power_get_resource ());
@@ -2520,8 +2473,6 @@ cc_power_panel_init (CcPowerPanel *self)
                             got_kbd_proxy_cb,
                             self);
 
-  priv->chassis_type = get_chassis_type (priv->cancellable);
-
   priv->up_client = up_client_new ();
 
   priv->gsd_settings = g_settings_new ("org.gnome.settings-daemon.plugins.power");
@@ -2535,22 +2486,22 @@ cc_power_panel_init (CcPowerPanel *self)
   add_battery_section (self);
   add_device_section (self);
   add_power_saving_section (self);
-  add_suspend_and_power_off_section (self);
+
+  /* The suspend section depends on what the machine can do, which is
+   * added at the end of the panel once known */
+  cc_power_capabilities_get (NULL, priv->cancellable, got_capabilities_cb, self);
 
   priv->boxes = g_list_copy (priv->boxes_reverse);
   priv->boxes = g_list_reverse (priv->boxes);
 
   /* populate batteries */
-  g_signal_connect (priv->up_client, "device-added", G_CALLBACK (up_client_device_added), self);
-  g_signal_connect (priv->up_client, "device-removed", G_CALLBACK (up_client_device_removed), self);
-
-  priv->devices = up_client_get_devices (priv->up_client);
-  for (i = 0; priv->devices != NULL && i < priv->devices->len; i++) {
-    UpDevice *device = g_ptr_array_index (priv->devices, i);
-    g_signal_connect (G_OBJECT (device), "notify",
-                      G_CALLBACK (up_client_changed), self);
-  }
-  up_client_changed (priv->up_client, NULL, self);
+  priv->power_devices = cc_power_devices_new (priv->up_client);
+  priv->device_rows = g_hash_table_new_full (NULL, NULL, g_object_unref, NULL);
+  g_signal_connect_swapped (priv->power_devices, "layout-changed",
+                            G_CALLBACK (update_device_rows), self);
+  g_signal_connect_swapped (priv->power_devices, "device-changed",
+                            G_CALLBACK (device_changed_cb), self);
+  update_device_rows (self);
 
   widget = WID (priv->builder, "vbox_power");
   box = gtk_scrolled_window_new (NULL, NULL);
@@ -0,0 +1,337 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*-
+ *
+ * Copyright (C) 2017 Red Hat, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <config.h>
+
+#include <gio/gio.h>
+
+#include "cc-power-capabilities.h"
+
+/* Mocks of hostnamed and logind on a private bus. The logind calls are
+ * only answered when the test flushes them, so that it can check which
+ * calls are in flight together. */
+
+static const gchar hostname_xml[] =
+  "<node>"
+  "  <interface name='org.freedesktop.hostname1'>"
+  "    <property name='Chassis' type='s' access='read'/>"
+  "  </interface>"
+  "</node>";
+
+static const gchar login_xml[] =
+  "<node>"
+  "  <interface name='org.freedesktop.login1.Manager'>"
+  "    <method name='CanSuspend'>"
+  "      <arg name='result' direction='out' type='s'/>"
+  "    </method>"
+  "    <method name='CanHibernate'>"
+  "      <arg name='result' direction='out' type='s'/>"
+  "    </method>"
+  "  </interface>"
+  "</node>";
+
+typedef struct
+{
+  GTestDBus *bus;
+  GDBusConnection *connection;
+  guint registration_ids[2];
+  guint owner_ids[2];
+  guint n_names;
+  GPtrArray *invocations;
+  guint n_calls;
+} Fixture;
+
+typedef struct
+{
+  gboolean done;
+  const CcPowerCapabilities *caps;
+  GError *error;
+} Result;
+
+static GVariant *
+hostname_get_property (GDBusConnection  *connection,
+                       const gchar      *sender,
+                       const gchar      *object_path,
+                       const gchar      *interface_name,
+                       const gchar      *property_name,
+                       GError          **error,
+                       gpointer          user_data)
+{
+  Fixture *fixture = user_data;
+
+  fixture->n_calls++;
+
+  return g_variant_new_string ("laptop");
+}
+
+static void
+login_method_call (GDBusConnection       *connection,
+                   const gchar           *sender,
+                   const gchar           *object_path,
+                   const gchar           *interface_name,
+                   const gchar           *method_name,
+                   GVariant              *parameters,
+                   GDBusMethodInvocation *invocation,
+                   gpointer               user_data)
+{
+  Fixture *fixture = user_data;
+
+  fixture->n_calls++;
+  g_ptr_array_add (fixture->invocations, invocation);
+}
+
+static const GDBusInterfaceVTable hostname_vtable = {
+  NULL,
+  hostname_get_property,
+  NULL
+};
+
+static const GDBusInterfaceVTable login_vtable = {
+  login_method_call,
+  NULL,
+  NULL
+};
+
+static void
+flush_invocations (Fixture *fixture)
+{
+  guint i;
+
+  for (i = 0; i < fixture->invocations->len; i++)
+    {
+      GDBusMethodInvocation *invocation = g_ptr_array_index (fixture->invocations, i);
+      const gchar *method_name = g_dbus_method_invocation_get_method_name (invocation);
+
+      g_dbus_method_invocation_return_value (invocation,
+                                             g_variant_new ("(s)",
+                                                            g_str_equal (method_name, "CanSuspend") ? "yes" : "na"));
+    }
+
+  g_ptr_array_set_size (fixture->invocations, 0);
+}
+
+static void
+name_acquired (GDBusConnection *connection,
+               const gchar     *name,
+               gpointer         user_data)
+{
+  Fixture *fixture = user_data;
+
+  fixture->n_names++;
+}
+
+static guint
+register_object (Fixture                    *fixture,
+                 const gchar                *xml,
+                 const gchar                *object_path,
+                 const GDBusInterfaceVTable *vtable)
+{
+  GDBusNodeInfo *info;
+  GError *error = NULL;
+  guint id;
+
+  info = g_dbus_node_info_new_for_xml (xml, &error);
+  g_assert_no_error (error);
+  id = g_dbus_connection_register_object (fixture->connection, object_path,
+                                          info->interfaces[0], vtable,
+                                          fixture, NULL, &error);
+  g_assert_no_error (error);
+  g_dbus_node_info_unref (info);
+
+  return id;
+}
+
+static void
+fixture_setup (Fixture       *fixture,
+               gconstpointer  user_data)
+{
+  GError *error = NULL;
+
+  fixture->bus = g_test_dbus_new (G_TEST_DBUS_NONE);
+  g_test_dbus_up (fixture->bus);
+
+  /* The same connection serves the mocks and asks them */
+  fixture->connection =
+    g_dbus_connection_new_for_address_sync (g_test_dbus_get_bus_address (fixture->bus),
+                                            G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+                                            G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,
+                                            NULL, NULL, &error);
+  g_assert_no_error (error);
+
+  fixture->invocations = g_ptr_array_new ();
+  fixture->n_calls = 0;
+  fixture->registration_ids[0] = register_object (fixture, hostname_xml,
+                                                  "/org/freedesktop/hostname1",
+                                                  &hostname_vtable);
+  fixture->registration_ids[1] = register_object (fixture, login_xml,
+                                                  "/org/freedesktop/login1",
+                                                  &login_vtable);
+
+  fixture->n_names = 0;
+  fixture->owner_ids[0] = g_bus_own_name_on_connection (fixture->connection,
+                                                        "org.freedesktop.hostname1",
+                                                        G_BUS_NAME_OWNER_FLAGS_NONE,
+                                                        name_acquired, NULL,
+                                                        fixture, NULL);
+  fixture->owner_ids[1] = g_bus_own_name_on_connection (fixture->connection,
+                                                        "org.freedesktop.login1",
+                                                        G_BUS_NAME_OWNER_FLAGS_NONE,
+                                                        name_acquired, NULL,
+                                                        fixture, NULL);
+  while (fixture->n_names < 2)
+    g_main_context_iteration (NULL, TRUE);
+}
+
+static void
+fixture_teardown (Fixture       *fixture,
+                  gconstpointer  user_data)
+{
+  guint i;
+
+  flush_invocations (fixture);
+  for (i = 0; i < 2; i++)
+    {
+      g_bus_unown_name (fixture->owner_ids[i]);
+      g_dbus_connection_unregister_object (fixture->connection, fixture->registration_ids[i]);
+    }
+  g_ptr_array_free (fixture->invocations, TRUE);
+  g_dbus_connection_close_sync (fixture->connection, NULL, NULL);
+  g_object_unref (fixture->connection);
+
+  g_test_dbus_down (fixture->bus);
+  g_object_unref (fixture->bus);
+}
+
+static void
+got_capabilities_cb (GObject      *source_object,
+                     GAsyncResult *res,
+                     gpointer      user_data)
+{
+  Result *result = user_data;
+
+  result->caps = cc_power_capabilities_get_finish (res, &result->error);
+  result->done = TRUE;
+}
+
+static void
+wait_for_calls (Fixture *fixture,
+                guint    n_calls)
+{
+  while (fixture->n_calls < n_calls)
+    g_main_context_iteration (NULL, TRUE);
+}
+
+static void
+wait_for_result (Result *result)
+{
+  while (!result->done)
+    g_main_context_iteration (NULL, TRUE);
+}
+
+static void
+test_concurrent (Fixture       *fixture,
+                 gconstpointer  user_data)
+{
+  Result results[2] = { { 0, }, };
+
+  cc_power_capabilities_get (fixture->connection, NULL, got_capabilities_cb, &results[0]);
+  cc_power_capabilities_get (fixture->connection, NULL, got_capabilities_cb, &results[1]);
+
+  /* All the calls are made before any of logind's answers */
+  wait_for_calls (fixture, 3);
+  g_assert_cmpuint (fixture->invocations->len, ==, 2);
+  g_assert_false (results[0].done);
+
+  flush_invocations (fixture);
+  wait_for_result (&results[0]);
+  wait_for_result (&results[1]);
+
+  g_assert_no_error (results[0].error);
+  g_assert_cmpstr (results[0].caps->chassis_type, ==, "laptop");
+  g_assert_true (results[0].caps->can_suspend);
+  g_assert_false (results[0].caps->can_hibernate);
+
+  /* Both requests shared the same calls */
+  g_assert_true (results[1].caps == results[0].caps);
+  g_assert_cmpuint (fixture->n_calls, ==, 3);
+}
+
+static void
+test_cached (Fixture       *fixture,
+             gconstpointer  user_data)
+{
+  Result result = { 0, };
+
+  cc_power_capabilities_get (fixture->connection, NULL, got_capabilities_cb, &result);
+  wait_for_calls (fixture, 3);
+  flush_invocations (fixture);
+  wait_for_result (&result);
+  g_assert_nonnull (result.caps);
+
+  result.done = FALSE;
+  cc_power_capabilities_get (fixture->connection, NULL, got_capabilities_cb, &result);
+  wait_for_result (&result);
+  g_assert_nonnull (result.caps);
+  g_assert_true (result.caps->can_suspend);
+
+  g_assert_cmpuint (fixture->n_calls, ==, 3);
+}
+
+static void
+test_cancelled (Fixture       *fixture,
+                gconstpointer  user_data)
+{
+  Result results[2] = { { 0, }, };
+  GCancellable *cancellable;
+
+  cancellable = g_cancellable_new ();
+  cc_power_capabilities_get (fixture->connection, cancellable, got_capabilities_cb, &results[0]);
+  cc_power_capabilities_get (fixture->connection, NULL, got_capabilities_cb, &results[1]);
+
+  wait_for_calls (fixture, 3);
+  g_cancellable_cancel (cancellable);
+  flush_invocations (fixture);
+
+  wait_for_result (&results[0]);
+  g_assert_error (results[0].error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+  g_assert_null (results[0].caps);
+
+  /* The other request is still answered */
+  wait_for_result (&results[1]);
+  g_assert_no_error (results[1].error);
+  g_assert_true (results[1].caps->can_suspend);
+
+  g_clear_error (&results[0].error);
+  g_object_unref (cancellable);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add ("/power/capabilities/concurrent", Fixture, NULL,
+              fixture_setup, test_concurrent, fixture_teardown);
+  g_test_add ("/power/capabilities/cached", Fixture, NULL,
+              fixture_setup, test_cached, fixture_teardown);
+  g_test_add ("/power/capabilities/cancelled", Fixture, NULL,
+              fixture_setup, test_cancelled, fixture_teardown);
+
+  return g_test_run ();
+}
@@ -0,0 +1,623 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*-
+ *
+ * Copyright (C) 2017 Red Hat, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <config.h>
+
+#include <gio/gio.h>
+
+#include "cc-power-devices.h"
+
+/* A mock of UPower on a private bus. libupower-glib talks to it
+ * synchronously, so it runs in its own thread, and the tests ask it to
+ * change its devices through mock_call(). */
+
+#define UPOWER_PATH "/org/freedesktop/UPower"
+#define DISPLAY_DEVICE_PATH UPOWER_PATH "/devices/DisplayDevice"
+#define N_UPDATES 200
+
+static const gchar upower_xml[] =
+  "<node>"
+  "  <interface name='org.freedesktop.UPower'>"
+  "    <method name='EnumerateDevices'>"
+  "      <arg name='devices' direction='out' type='ao'/>"
+  "    </method>"
+  "    <method name='GetDisplayDevice'>"
+  "      <arg name='device' direction='out' type='o'/>"
+  "    </method>"
+  "    <signal name='DeviceAdded'>"
+  "      <arg name='device' type='o'/>"
+  "    </signal>"
+  "    <signal name='DeviceRemoved'>"
+  "      <arg name='device' type='o'/>"
+  "    </signal>"
+  "    <property name='DaemonVersion' type='s' access='read'/>"
+  "    <property name='OnBattery' type='b' access='read'/>"
+  "    <property name='LidIsClosed' type='b' access='read'/>"
+  "    <property name='LidIsPresent' type='b' access='read'/>"
+  "  </interface>"
+  "</node>";
+
+static const gchar device_xml[] =
+  "<node>"
+  "  <interface name='org.freedesktop.UPower.Device'>"
+  "    <property name='Type' type='u' access='read'/>"
+  "    <property name='State' type='u' access='read'/>"
+  "    <property name='Percentage' type='d' access='read'/>"
+  "    <property name='Model' type='s' access='read'/>"
+  "    <property name='IsPresent' type='b' access='read'/>"
+  "    <property name='IconName' type='s' access='read'/>"
+  "  </interface>"
+  "</node>";
+
+typedef struct
+{
+  const gchar *object_path;
+  guint32 type;
+  gdouble percentage;
+  gboolean is_present;
+  const gchar *model;
+  guint registration_id;
+} MockDevice;
+
+enum {
+  DISPLAY_DEVICE,
+  BATTERY,
+  MOUSE,
+  KEYBOARD,
+  N_DEVICES
+};
+
+/* All but the keyboard are there from the start */
+static MockDevice mock_devices[N_DEVICES] = {
+  { DISPLAY_DEVICE_PATH, UP_DEVICE_KIND_BATTERY, 80.0, TRUE, "", 0 },
+  { UPOWER_PATH "/devices/battery_BAT0", UP_DEVICE_KIND_BATTERY, 80.0, TRUE, "Battery", 0 },
+  { UPOWER_PATH "/devices/mouse_0", UP_DEVICE_KIND_MOUSE, 50.0, TRUE, "Wireless Mouse", 0 },
+  { UPOWER_PATH "/devices/keyboard_0", UP_DEVICE_KIND_KEYBOARD, 60.0, TRUE, "Wireless Keyboard", 0 },
+};
+
+static struct
+{
+  GThread *thread;
+  GMainContext *context;
+  GMainLoop *loop;
+  GDBusConnection *connection;
+  GDBusInterfaceInfo *upower_info;
+  GDBusInterfaceInfo *device_info;
+  guint registration_id;
+  guint owner_id;
+
+  GMutex lock;
+  GCond cond;
+  gboolean ready;
+} mock;
+
+typedef void (*MockFunc) (gpointer data);
+
+typedef struct
+{
+  MockFunc func;
+  gpointer data;
+  gboolean done;
+} MockCall;
+
+typedef struct
+{
+  UpClient *client;
+  CcPowerDevices *devices;
+  guint n_layout_changed;
+  guint n_device_changed;
+  UpDevice *last_changed;
+} Fixture;
+
+static void
+upower_method_call (GDBusConnection       *connection,
+                    const gchar           *sender,
+                    const gchar           *object_path,
+                    const gchar           *interface_name,
+                    const gchar           *method_name,
+                    GVariant              *parameters,
+                    GDBusMethodInvocation *invocation,
+                    gpointer               user_data)
+{
+  GVariantBuilder builder;
+  guint i;
+
+  if (g_str_equal (method_name, "GetDisplayDevice"))
+    {
+      g_dbus_method_invocation_return_value (invocation,
+                                             g_variant_new ("(o)", DISPLAY_DEVICE_PATH));
+      return;
+    }
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("ao"));
+  for (i = 0; i < N_DEVICES; i++)
+    {
+      if (i != DISPLAY_DEVICE && mock_devices[i].registration_id != 0)
+        g_variant_builder_add (&builder, "o", mock_devices[i].object_path);
+    }
+  g_dbus_method_invocation_return_value (invocation,
+                                         g_variant_new ("(ao)", &builder));
+}
+
+static GVariant *
+upower_get_property (GDBusConnection  *connection,
+                     const gchar      *sender,
+                     const gchar      *object_path,
+                     const gchar      *interface_name,
+                     const gchar      *property_name,
+                     GError          **error,
+                     gpointer          user_data)
+{
+  if (g_str_equal (property_name, "DaemonVersion"))
+    return g_variant_new_string ("0.99.5");
+
+  return g_variant_new_boolean (FALSE);
+}
+
+static GVariant *
+device_get_property (GDBusConnection  *connection,
+                     const gchar      *sender,
+                     const gchar      *object_path,
+                     const gchar      *interface_name,
+                     const gchar      *property_name,
+                     GError          **error,
+                     gpointer          user_data)
+{
+  MockDevice *device = user_data;
+
+  if (g_str_equal (property_name, "Type"))
+    return g_variant_new_uint32 (device->type);
+  if (g_str_equal (property_name, "State"))
+    return g_variant_new_uint32 (UP_DEVICE_STATE_DISCHARGING);
+  if (g_str_equal (property_name, "Percentage"))
+    return g_variant_new_double (device->percentage);
+  if (g_str_equal (property_name, "Model"))
+    return g_variant_new_string (device->model);
+  if (g_str_equal (property_name, "IsPresent"))
+    return g_variant_new_boolean (device->is_present);
+
+  return g_variant_new_string ("battery-good-symbolic");
+}
+
+static const GDBusInterfaceVTable upower_vtable = {
+  upower_method_call,
+  upower_get_property,
+  NULL
+};
+
+static const GDBusInterfaceVTable device_vtable = {
+  NULL,
+  device_get_property,
+  NULL
+};
+
+static void
+mock_export_device (MockDevice *device)
+{
+  GError *error = NULL;
+
+  device->registration_id =
+    g_dbus_connection_register_object (mock.connection, device->object_path,
+                                       mock.device_info, &device_vtable,
+                                       device, NULL, &error);
+  g_assert_no_error (error);
+}
+
+static void
+mock_unexport_device (MockDevice *device)
+{
+  g_dbus_connection_unregister_object (mock.connection, device->registration_id);
+  device->registration_id = 0;
+}
+
+static void
+mock_emit_device_changed (MockDevice  *device,
+                          const gchar *property_name,
+                          GVariant    *value)
+{
+  GVariantBuilder builder;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
+  g_variant_builder_add (&builder, "{sv}", property_name, value);
+  g_dbus_connection_emit_signal (mock.connection, NULL,
+                                 device->object_path,
+                                 "org.freedesktop.DBus.Properties",
+                                 "PropertiesChanged",
+                                 g_variant_new ("(sa{sv}as)",
+                                                "org.freedesktop.UPower.Device",
+                                                &builder, NULL),
+                                 NULL);
+}
+
+static void
+mock_emit_daemon_signal (const gchar *signal_name,
+                         MockDevice  *device)
+{
+  g_dbus_connection_emit_signal (mock.connection, NULL,
+                                 UPOWER_PATH, "org.freedesktop.UPower",
+                                 signal_name,
+                                 g_variant_new ("(o)", device->object_path),
+                                 NULL);
+}
+
+/* Runs in the mock thread: the mouse reports its level over and over,
+ * the way wireless peripherals do */
+static void
+mock_percentage_burst (gpointer data)
+{
+  MockDevice *device = data;
+  guint i;
+
+  for (i = 1; i <= N_UPDATES; i++)
+    {
+      device->percentage = 100.0 * i / N_UPDATES;
+      mock_emit_device_changed (device, "Percentage",
+                                g_variant_new_double (device->percentage));
+    }
+}
+
+static void
+mock_toggle_present (gpointer data)
+{
+  MockDevice *device = data;
+
+  device->is_present = !device->is_present;
+  mock_emit_device_changed (device, "IsPresent",
+                            g_variant_new_boolean (device->is_present));
+}
+
+static void
+mock_add_device (gpointer data)
+{
+  MockDevice *device = data;
+
+  mock_export_device (device);
+  mock_emit_daemon_signal ("DeviceAdded", device);
+}
+
+static void
+mock_remove_device (gpointer data)
+{
+  MockDevice *device = data;
+
+  mock_unexport_device (device);
+  mock_emit_daemon_signal ("DeviceRemoved", device);
+}
+
+static void
+mock_quit (gpointer data)
+{
+  g_main_loop_quit (mock.loop);
+}
+
+static gboolean
+mock_call_cb (gpointer user_data)
+{
+  MockCall *call = user_data;
+
+  call->func (call->data);
+
+  g_mutex_lock (&mock.lock);
+  call->done = TRUE;
+  g_cond_broadcast (&mock.cond);
+  g_mutex_unlock (&mock.lock);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Runs @func in the mock thread, and waits for it to be done */
+static void
+mock_call (MockFunc func,
+           gpointer data)
+{
+  MockCall call = { func, data, FALSE };
+
+  g_main_context_invoke (mock.context, mock_call_cb, &call);
+
+  g_mutex_lock (&mock.lock);
+  while (!call.done)
+    g_cond_wait (&mock.cond, &mock.lock);
+  g_mutex_unlock (&mock.lock);
+}
+
+static void
+mock_name_acquired (GDBusConnection *connection,
+                    const gchar     *name,
+                    gpointer         user_data)
+{
+  g_mutex_lock (&mock.lock);
+  mock.ready = TRUE;
+  g_cond_broadcast (&mock.cond);
+  g_mutex_unlock (&mock.lock);
+}
+
+static GDBusInterfaceInfo *
+get_interface_info (const gchar *xml)
+{
+  GDBusNodeInfo *info;
+  GDBusInterfaceInfo *interface_info;
+  GError *error = NULL;
+
+  info = g_dbus_node_info_new_for_xml (xml, &error);
+  g_assert_no_error (error);
+  interface_info = g_dbus_interface_info_ref (info->interfaces[0]);
+  g_dbus_node_info_unref (info);
+
+  return interface_info;
+}
+
+static gpointer
+mock_thread (gpointer user_data)
+{
+  const gchar *address = user_data;
+  GError *error = NULL;
+  guint i;
+
+  g_main_context_push_thread_default (mock.context);
+
+  mock.connection =
+    g_dbus_connection_new_for_address_sync (address,
+                                            G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+                                            G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,
+                                            NULL, NULL, &error);
+  g_assert_no_error (error);
+
+  mock.upower_info = get_interface_info (upower_xml);
+  mock.device_info = get_interface_info (device_xml);
+
+  mock.registration_id =
+    g_dbus_connection_register_object (mock.connection, UPOWER_PATH,
+                                       mock.upower_info, &upower_vtable,
+                                       NULL, NULL, &error);
+  g_assert_no_error (error);
+
+  for (i = 0; i < N_DEVICES; i++)
+    {
+      if (i != KEYBOARD)
+        mock_export_device (&mock_devices[i]);
+    }
+
+  mock.owner_id = g_bus_own_name_on_connection (mock.connection,
+                                                "org.freedesktop.UPower",
+                                                G_BUS_NAME_OWNER_FLAGS_NONE,
+                                                mock_name_acquired, NULL,
+                                                NULL, NULL);
+
+  g_main_loop_run (mock.loop);
+
+  g_bus_unown_name (mock.owner_id);
+  for (i = 0; i < N_DEVICES; i++)
+    {
+      if (mock_devices[i].registration_id != 0)
+        mock_unexport_device (&mock_devices[i]);
+    }
+  g_dbus_connection_unregister_object (mock.connection, mock.registration_id);
+  g_dbus_interface_info_unref (mock.device_info);
+  g_dbus_interface_info_unref (mock.upower_info);
+  g_clear_object (&mock.connection);
+
+  g_main_context_pop_thread_default (mock.context);
+
+  return NULL;
+}
+
+static void
+mock_start (const gchar *address)
+{
+  mock.context = g_main_context_new ();
+  mock.loop = g_main_loop_new (mock.context, FALSE);
+  mock.thread = g_thread_new ("mock-upower", mock_thread, (gpointer) address);
+
+  g_mutex_lock (&mock.lock);
+  while (!mock.ready)
+    g_cond_wait (&mock.cond, &mock.lock);
+  g_mutex_unlock (&mock.lock);
+}
+
+static void
+mock_stop (void)
+{
+  mock_call (mock_quit, NULL);
+  g_thread_join (mock.thread);
+  g_main_loop_unref (mock.loop);
+  g_main_context_unref (mock.context);
+}
+
+static void
+layout_changed_cb (CcPowerDevices *devices,
+                   Fixture        *fixture)
+{
+  fixture->n_layout_changed++;
+}
+
+static void
+device_changed_cb (CcPowerDevices *devices,
+                   UpDevice       *device,
+                   Fixture        *fixture)
+{
+  fixture->n_device_changed++;
+  fixture->last_changed = device;
+}
+
+static UpDevice *
+find_device (Fixture    *fixture,
+             MockDevice *mock_device)
+{
+  GPtrArray *devices;
+  guint i;
+
+  devices = cc_power_devices_get_devices (fixture->devices);
+  for (i = 0; i < devices->len; i++)
+    {
+      UpDevice *device = g_ptr_array_index (devices, i);
+
+      if (g_strcmp0 (up_device_get_object_path (device), mock_device->object_path) == 0)
+        return device;
+    }
+
+  return NULL;
+}
+
+static void
+wait_for_layout_changed (Fixture *fixture)
+{
+  while (fixture->n_layout_changed == 0)
+    g_main_context_iteration (NULL, TRUE);
+}
+
+static void
+fixture_setup (Fixture       *fixture,
+               gconstpointer  user_data)
+{
+  fixture->client = up_client_new ();
+  fixture->devices = cc_power_devices_new (fixture->client);
+  fixture->n_layout_changed = 0;
+  fixture->n_device_changed = 0;
+  fixture->last_changed = NULL;
+
+  g_signal_connect (fixture->devices, "layout-changed",
+                    G_CALLBACK (layout_changed_cb), fixture);
+  g_signal_connect (fixture->devices, "device-changed",
+                    G_CALLBACK (device_changed_cb), fixture);
+}
+
+static void
+fixture_teardown (Fixture       *fixture,
+                  gconstpointer  user_data)
+{
+  g_clear_object (&fixture->devices);
+  g_clear_object (&fixture->client);
+}
+
+static void
+test_initial_devices (Fixture       *fixture,
+                      gconstpointer  user_data)
+{
+  UpDevice *display_device;
+
+  g_assert_cmpuint (cc_power_devices_get_devices (fixture->devices)->len, ==, 2);
+  g_assert_nonnull (find_device (fixture, &mock_devices[BATTERY]));
+  g_assert_nonnull (find_device (fixture, &mock_devices[MOUSE]));
+
+  display_device = cc_power_devices_get_display_device (fixture->devices);
+  g_assert_nonnull (display_device);
+  g_assert_cmpstr (up_device_get_object_path (display_device), ==, DISPLAY_DEVICE_PATH);
+}
+
+static void
+test_level_updates (Fixture       *fixture,
+                    gconstpointer  user_data)
+{
+  UpDevice *mouse;
+  gdouble percentage = 0.0;
+
+  mouse = find_device (fixture, &mock_devices[MOUSE]);
+  g_assert_nonnull (mouse);
+
+  mock_call (mock_percentage_burst, &mock_devices[MOUSE]);
+
+  /* Wait for the last update to be signalled */
+  while (fixture->n_device_changed == 0 || percentage < 100.0)
+    {
+      g_main_context_iteration (NULL, TRUE);
+      if (fixture->last_changed == mouse)
+        g_object_get (mouse, "percentage", &percentage, NULL);
+    }
+  while (g_main_context_iteration (NULL, FALSE));
+
+  /* The rows only need updating, at most once per update, and the
+   * mouse is the only device that changed */
+  g_assert_cmpuint (fixture->n_layout_changed, ==, 0);
+  g_assert_cmpuint (fixture->n_device_changed, >=, 1);
+  g_assert_cmpuint (fixture->n_device_changed, <=, N_UPDATES);
+  g_assert_true (fixture->last_changed == mouse);
+  g_assert_cmpuint (cc_power_devices_get_devices (fixture->devices)->len, ==, 2);
+}
+
+static void
+test_present_changed (Fixture       *fixture,
+                      gconstpointer  user_data)
+{
+  UpDevice *mouse;
+  gboolean is_present;
+
+  mouse = find_device (fixture, &mock_devices[MOUSE]);
+  g_assert_nonnull (mouse);
+
+  /* Peripherals that are not present get no row */
+  mock_call (mock_toggle_present, &mock_devices[MOUSE]);
+  wait_for_layout_changed (fixture);
+  g_object_get (mouse, "is-present", &is_present, NULL);
+  g_assert_false (is_present);
+
+  fixture->n_layout_changed = 0;
+  mock_call (mock_toggle_present, &mock_devices[MOUSE]);
+  wait_for_layout_changed (fixture);
+  g_object_get (mouse, "is-present", &is_present, NULL);
+  g_assert_true (is_present);
+}
+
+static void
+test_added_removed (Fixture       *fixture,
+                    gconstpointer  user_data)
+{
+  mock_call (mock_add_device, &mock_devices[KEYBOARD]);
+  wait_for_layout_changed (fixture);
+  g_assert_cmpuint (cc_power_devices_get_devices (fixture->devices)->len, ==, 3);
+  g_assert_nonnull (find_device (fixture, &mock_devices[KEYBOARD]));
+
+  fixture->n_layout_changed = 0;
+  mock_call (mock_remove_device, &mock_devices[KEYBOARD]);
+  wait_for_layout_changed (fixture);
+  g_assert_cmpuint (cc_power_devices_get_devices (fixture->devices)->len, ==, 2);
+  g_assert_null (find_device (fixture, &mock_devices[KEYBOARD]));
+}
+
+int
+main (int argc, char **argv)
+{
+  GTestDBus *bus;
+  int ret;
+
+  g_test_init (&argc, &argv, NULL);
+
+  /* libupower-glib only ever looks at the system bus */
+  bus = g_test_dbus_new (G_TEST_DBUS_NONE);
+  g_test_dbus_up (bus);
+  g_setenv ("DBUS_SYSTEM_BUS_ADDRESS", g_test_dbus_get_bus_address (bus), TRUE);
+
+  mock_start (g_test_dbus_get_bus_address (bus));
+
+  g_test_add ("/power/devices/initial-devices", Fixture, NULL,
+              fixture_setup, test_initial_devices, fixture_teardown);
+  g_test_add ("/power/devices/level-updates", Fixture, NULL,
+              fixture_setup, test_level_updates, fixture_teardown);
+  g_test_add ("/power/devices/present-changed", Fixture, NULL,
+              fixture_setup, test_present_changed, fixture_teardown);
+  g_test_add ("/power/devices/added-removed", Fixture, NULL,
+              fixture_setup, test_added_removed, fixture_teardown);
+
+  ret = g_test_run ();
+
+  mock_stop ();
+  g_test_dbus_down (bus);
+  g_object_unref (bus);
+
+  return ret;
+}
@@ -88,6 +88,11 @@ struct _CcPrintersPanelPrivate
   guint            cups_status_check_id;
   guint            dbus_subscription_id;
   guint            remove_printer_timeout_id;
+  guint            search_bar_handler_id;
+
+  /* the polling sources removed while the panel is suspended */
+  gboolean         subscription_renewal_suspended;
+  gboolean         cups_status_check_suspended;
 
   GtkWidget    *headerbar_buttons;
   GtkRevealer  *notification;
@@ -121,6 +126,8 @@ typedef struct
 static void actualize_printers_list (CcPrintersPanel *self);
 static void update_sensitivity (gpointer user_data);
 static void detach_from_cups_notifier (gpointer data);
+static gboolean renew_subscription (gpointer data);
+static gboolean cups_status_check (gpointer user_data);
 static void free_dests (CcPrintersPanel *self);
 
 static void
@@ -172,10 +179,12 @@ cc_printers_panel_constructed (GObject *object)
 
   widget = (GtkWidget*)
     gtk_builder_get_object (priv->builder, "search-bar");
-  g_signal_connect_swapped (shell,
-                            "key-press-event",
-                            G_CALLBACK (gtk_search_bar_handle_event),
-                            widget);
+  priv->search_bar_handler_id =
+    g_signal_connect_object (shell,
+                             "key-press-event",
+                             G_CALLBACK (gtk_search_bar_handle_event),
+                             widget,
+                             G_CONNECT_SWAPPED);
 }
 
 static void
@@ -292,6 +301,60 @@ cc_printers_panel_get_help_uri (CcPanel *panel)
   return "help:gnome-help/printing";
 }
 
+/* The shell outlives the panel while it is cached, and would keep
+ * feeding its key presses to the hidden search bar. There is no need
+ * to keep polling CUPS either until the panel is shown again. */
+static void
+cc_printers_panel_suspend (CcPanel *panel)
+{
+  CcPrintersPanel *self = CC_PRINTERS_PANEL (panel);
+  CcPrintersPanelPrivate *priv = self->priv;
+
+  g_signal_handler_block (cc_panel_get_shell (panel),
+                          priv->search_bar_handler_id);
+
+  if (priv->subscription_renewal_id != 0)
+    {
+      g_source_remove (priv->subscription_renewal_id);
+      priv->subscription_renewal_id = 0;
+      priv->subscription_renewal_suspended = TRUE;
+    }
+
+  if (priv->cups_status_check_id != 0)
+    {
+      g_source_remove (priv->cups_status_check_id);
+      priv->cups_status_check_id = 0;
+      priv->cups_status_check_suspended = TRUE;
+    }
+}
+
+static void
+cc_printers_panel_resume (CcPanel *panel)
+{
+  CcPrintersPanel *self = CC_PRINTERS_PANEL (panel);
+  CcPrintersPanelPrivate *priv = self->priv;
+
+  g_signal_handler_unblock (cc_panel_get_shell (panel),
+                            priv->search_bar_handler_id);
+
+  /* The subscription may have run out while we were away */
+  if (priv->subscription_renewal_suspended)
+    {
+      priv->subscription_renewal_suspended = FALSE;
+      priv->subscription_renewal_id =
+        g_timeout_add_seconds (RENEW_INTERVAL, renew_subscription, self);
+      renew_subscription (self);
+    }
+
+  if (priv->cups_status_check_suspended)
+    {
+      priv->cups_status_check_suspended = FALSE;
+      priv->cups_status_check_id =
+        g_timeout_add_seconds (CUPS_STATUS_CHECK_INTERVAL, cups_status_check, self);
+      cups_status_check (self);
+    }
+}
+
 static void
 cc_printers_panel_class_init (CcPrintersPanelClass *klass)
 {
@@ -307,6 +370,8 @@ cc_printers_panel_class_init (CcPrintersPanelClass *klass)
   object_class->finalize = cc_printers_panel_finalize;
 
   panel_class->get_help_uri = cc_printers_panel_get_help_uri;
+  panel_class->suspend = cc_printers_panel_suspend;
+  panel_class->resume = cc_printers_panel_resume;
 }
 
 static void
@@ -1035,8 +1100,10 @@ cups_status_check_cb (GObject      *source_object,
       actualize_printers_list (self);
       attach_to_cups_notifier (self);
 
-      g_source_remove (priv->cups_status_check_id);
+      if (priv->cups_status_check_id != 0)
+        g_source_remove (priv->cups_status_check_id);
       priv->cups_status_check_id = 0;
+      priv->cups_status_check_suspended = FALSE;
     }
 
   g_object_unref (cups);
@@ -42,6 +42,8 @@ CC_PANEL_REGISTER (CcPrivacyPanel, cc_privacy_panel)
 #define APP_PERMISSIONS_TABLE "gnome"
 #define APP_PERMISSIONS_ID "geolocation"
 
+#define LOCATION_APPS_BATCH_SIZE 32
+
 struct _CcPrivacyPanelPrivate
 {
   GtkBuilder *builder;
@@ -73,8 +75,13 @@ struct _CcPrivacyPanelPrivate
   GVariant *location_apps_perms;
   GVariant *location_apps_data;
   GHashTable *location_app_switches;
+  GHashTable *location_apps_resolving;
+  GHashTable *location_apps_missing;
+  GQueue     *location_apps_queue;
+  gboolean    location_apps_resolving_batch;
 
   GtkSizeGroup *location_icon_size_group;
+  GAppInfoMonitor *app_info_monitor;
 };
 
 static char *
@@ -504,6 +511,7 @@ on_perm_store_set_done (GObject *source_object,
                         GAsyncResult *res,
                         gpointer user_data)
 {
+  GtkWidget *w = user_data;
   LocationAppStateData *data;
   GVariant *results;
   GError *error = NULL;
@@ -516,14 +524,17 @@ on_perm_store_set_done (GObject *source_object,
       if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
         g_warning ("Failed to store permissions: %s", error->message);
       g_error_free (error);
+      g_object_unref (w);
 
       return;
     }
   g_variant_unref (results);
 
-  data = (LocationAppStateData *) user_data;
+  data = g_object_get_data (G_OBJECT (w), "location-app-state");
   data->changing_state = FALSE;
   gtk_switch_set_state (GTK_SWITCH (data->widget), data->pending_state);
+
+  g_object_unref (w);
 }
 
 static gboolean
@@ -574,6 +585,7 @@ on_location_app_state_set (GtkSwitch *widget,
                           &builder,
                           self->priv->location_apps_data);
 
+  /* The row can go away before the store answers */
   g_dbus_proxy_call (self->priv->perm_store,
                      "Set",
                      params,
@@ -581,39 +593,64 @@ on_location_app_state_set (GtkSwitch *widget,
                      -1,
                      self->priv->cancellable,
                      on_perm_store_set_done,
-                     data);
+                     g_object_ref (data->widget));
+
+  return TRUE;
+}
+
+static gboolean
+get_location_app_state (GVariant *value,
+                        gboolean *enabled,
+                        gint64   *last_used)
+{
+  const gchar **strv;
+  gsize length;
+
+  strv = g_variant_get_strv (value, &length);
+  if (length < 2)
+    {
+      g_free (strv);
+      return FALSE;
+    }
+
+  *enabled = (g_strcmp0 (strv[0], "NONE") != 0);
+  *last_used = g_ascii_strtoll (strv[1], NULL, 10);
+  g_free (strv);
 
   return TRUE;
 }
 
 static void
-add_location_app (CcPrivacyPanel *self,
-                  const gchar    *app_id,
-                  gboolean        enabled,
-                  gint64          last_used)
+update_location_app (GtkWidget *w,
+                     gboolean   enabled,
+                     gint64     last_used)
 {
-  CcPrivacyPanelPrivate *priv = self->priv;
-  GDesktopAppInfo *app_info;
-  char *desktop_id;
-  GtkWidget *box, *row, *w;
-  GIcon *icon;
+  GtkWidget *label;
   GDateTime *t;
   char *last_used_str;
-  LocationAppStateData *data;
 
-  w = g_hash_table_lookup (priv->location_app_switches, app_id);
-  if (w != NULL)
-    {
-      gtk_switch_set_active (GTK_SWITCH (w), enabled);
+  if (gtk_switch_get_active (GTK_SWITCH (w)) != enabled)
+    gtk_switch_set_active (GTK_SWITCH (w), enabled);
 
-      return;
-    }
+  t = g_date_time_new_from_unix_utc (last_used);
+  last_used_str = cc_util_get_smart_date (t);
+  label = g_object_get_data (G_OBJECT (w), "last-used-label");
+  gtk_label_set_label (GTK_LABEL (label), last_used_str);
+  g_free (last_used_str);
+  g_date_time_unref (t);
+}
 
-  desktop_id = g_strdup_printf ("%s.desktop", app_id);
-  app_info = g_desktop_app_info_new (desktop_id);
-  g_free (desktop_id);
-  if (app_info == NULL)
-      return;
+static void
+add_location_app (CcPrivacyPanel  *self,
+                  const gchar     *app_id,
+                  GDesktopAppInfo *app_info,
+                  gboolean         enabled,
+                  gint64           last_used)
+{
+  CcPrivacyPanelPrivate *priv = self->priv;
+  GtkWidget *box, *row, *w, *label;
+  GIcon *icon;
+  LocationAppStateData *data;
 
   row = gtk_list_box_row_new ();
   box = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
@@ -640,16 +677,13 @@ add_location_app (CcPrivacyPanel *self,
   gtk_label_set_xalign (GTK_LABEL (w), 0);
   gtk_box_pack_start (GTK_BOX (box), w, FALSE, FALSE, 0);
 
-  t = g_date_time_new_from_unix_utc (last_used);
-  last_used_str = cc_util_get_smart_date (t);
-  w = gtk_label_new (last_used_str);
-  g_free (last_used_str);
-  gtk_style_context_add_class (gtk_widget_get_style_context (w), "dim-label");
-  gtk_widget_set_margin_start (w, 12);
-  gtk_widget_set_margin_end (w, 12);
-  gtk_widget_set_halign (w, GTK_ALIGN_END);
-  gtk_widget_set_valign (w, GTK_ALIGN_CENTER);
-  gtk_box_pack_start (GTK_BOX (box), w, TRUE, TRUE, 0);
+  label = gtk_label_new (NULL);
+  gtk_style_context_add_class (gtk_widget_get_style_context (label), "dim-label");
+  gtk_widget_set_margin_start (label, 12);
+  gtk_widget_set_margin_end (label, 12);
+  gtk_widget_set_halign (label, GTK_ALIGN_END);
+  gtk_widget_set_valign (label, GTK_ALIGN_CENTER);
+  gtk_box_pack_start (GTK_BOX (box), label, TRUE, TRUE, 0);
 
   w = gtk_switch_new ();
   gtk_switch_set_active (GTK_SWITCH (w), enabled);
@@ -659,25 +693,258 @@ add_location_app (CcPrivacyPanel *self,
   g_settings_bind (priv->location_settings, LOCATION_ENABLED,
                    w, "sensitive",
                    G_SETTINGS_BIND_DEFAULT);
+  g_object_set_data (G_OBJECT (w), "last-used-label", label);
   g_hash_table_insert (priv->location_app_switches,
                        g_strdup (app_id),
                        g_object_ref (w));
 
+  update_location_app (w, enabled, last_used);
+
   data = g_slice_new (LocationAppStateData);
   data->self = self;
   data->app_id = g_strdup (app_id);
   data->widget = w;
   data->changing_state = FALSE;
-  g_signal_connect_data (G_OBJECT (w),
-                         "state-set",
-                         G_CALLBACK (on_location_app_state_set),
-                         data,
-                         (GClosureNotify) location_app_state_data_free,
-                         0);
+  g_object_set_data_full (G_OBJECT (w), "location-app-state", data,
+                          (GDestroyNotify) location_app_state_data_free);
+  g_signal_connect (G_OBJECT (w),
+                    "state-set",
+                    G_CALLBACK (on_location_app_state_set),
+                    data);
 
   gtk_widget_show_all (row);
 }
 
+static void
+remove_location_app (CcPrivacyPanel *self,
+                     const gchar    *app_id)
+{
+  CcPrivacyPanelPrivate *priv = self->priv;
+  GtkWidget *w;
+
+  g_hash_table_remove (priv->location_apps_resolving, app_id);
+  g_hash_table_remove (priv->location_apps_missing, app_id);
+
+  w = g_hash_table_lookup (priv->location_app_switches, app_id);
+  if (w == NULL)
+    return;
+
+  gtk_widget_destroy (gtk_widget_get_ancestor (w, GTK_TYPE_LIST_BOX_ROW));
+  g_hash_table_remove (priv->location_app_switches, app_id);
+}
+
+static void
+update_location_apps_visibility (CcPrivacyPanel *self)
+{
+  CcPrivacyPanelPrivate *priv = self->priv;
+  gboolean visible;
+
+  visible = g_hash_table_size (priv->location_app_switches) > 0;
+  gtk_widget_set_visible (priv->location_apps_label, visible);
+  gtk_widget_set_visible (priv->location_apps_frame, visible);
+}
+
+static void resolve_location_apps (CcPrivacyPanel *self);
+
+static void
+resolve_location_apps_thread (GTask        *task,
+                              gpointer      source_object,
+                              gpointer      task_data,
+                              GCancellable *cancellable)
+{
+  gchar **app_ids = task_data;
+  GHashTable *app_infos;
+  guint i;
+
+  app_infos = g_hash_table_new_full (g_str_hash,
+                                     g_str_equal,
+                                     g_free,
+                                     g_object_unref);
+
+  for (i = 0; app_ids[i] != NULL; i++)
+    {
+      GDesktopAppInfo *app_info;
+      char *desktop_id;
+
+      if (g_cancellable_is_cancelled (cancellable))
+        break;
+
+      desktop_id = g_strdup_printf ("%s.desktop", app_ids[i]);
+      app_info = g_desktop_app_info_new (desktop_id);
+      g_free (desktop_id);
+
+      /* Apps that are not installed are not listed */
+      if (app_info != NULL)
+        g_hash_table_insert (app_infos, g_strdup (app_ids[i]), app_info);
+    }
+
+  g_task_return_pointer (task, app_infos, (GDestroyNotify) g_hash_table_unref);
+}
+
+static void
+on_location_apps_resolved (GObject      *source_object,
+                           GAsyncResult *res,
+                           gpointer      user_data)
+{
+  CcPrivacyPanel *self;
+  CcPrivacyPanelPrivate *priv;
+  GHashTable *app_infos;
+  gchar **app_ids;
+  GError *error = NULL;
+  guint i;
+
+  app_infos = g_task_propagate_pointer (G_TASK (res), &error);
+  if (app_infos == NULL)
+    {
+      /* The panel is gone */
+      g_error_free (error);
+
+      return;
+    }
+
+  self = user_data;
+  priv = self->priv;
+  priv->location_apps_resolving_batch = FALSE;
+
+  app_ids = g_task_get_task_data (G_TASK (res));
+  for (i = 0; app_ids[i] != NULL; i++)
+    {
+      GDesktopAppInfo *app_info;
+      GVariant *value;
+      gboolean enabled;
+      gint64 last_used;
+
+      /* Apps that were removed from the store in the meantime */
+      if (!g_hash_table_remove (priv->location_apps_resolving, app_ids[i]))
+        continue;
+
+      /* Apps that are not installed yet are looked up again later */
+      app_info = g_hash_table_lookup (app_infos, app_ids[i]);
+      if (app_info == NULL)
+        {
+          g_hash_table_add (priv->location_apps_missing, g_strdup (app_ids[i]));
+          continue;
+        }
+
+      /* The permissions might have changed since the app was queued */
+      value = g_variant_lookup_value (priv->location_apps_perms,
+                                      app_ids[i],
+                                      G_VARIANT_TYPE_STRING_ARRAY);
+      if (value == NULL)
+        continue;
+
+      if (get_location_app_state (value, &enabled, &last_used))
+        add_location_app (self, app_ids[i], app_info, enabled, last_used);
+      g_variant_unref (value);
+    }
+
+  g_hash_table_unref (app_infos);
+
+  update_location_apps_visibility (self);
+  resolve_location_apps (self);
+}
+
+/* Looking up the desktop files hits the disk, so it is done in a thread,
+ * for a batch of the queued apps at a time */
+static void
+resolve_location_apps (CcPrivacyPanel *self)
+{
+  CcPrivacyPanelPrivate *priv = self->priv;
+  GPtrArray *app_ids;
+  GTask *task;
+
+  if (priv->location_apps_resolving_batch)
+    return;
+
+  app_ids = g_ptr_array_new ();
+  while (!g_queue_is_empty (priv->location_apps_queue) &&
+         app_ids->len < LOCATION_APPS_BATCH_SIZE)
+    {
+      gchar *app_id = g_queue_pop_head (priv->location_apps_queue);
+
+      if (g_hash_table_contains (priv->location_apps_resolving, app_id))
+        g_ptr_array_add (app_ids, app_id);
+      else
+        g_free (app_id);
+    }
+
+  if (app_ids->len == 0)
+    {
+      g_ptr_array_free (app_ids, TRUE);
+      return;
+    }
+  g_ptr_array_add (app_ids, NULL);
+
+  priv->location_apps_resolving_batch = TRUE;
+
+  task = g_task_new (NULL, priv->cancellable, on_location_apps_resolved, self);
+  g_task_set_task_data (task,
+                        g_ptr_array_free (app_ids, FALSE),
+                        (GDestroyNotify) g_strfreev);
+  g_task_run_in_thread (task, resolve_location_apps_thread);
+  g_object_unref (task);
+}
+
+static void
+queue_location_app (CcPrivacyPanel *self,
+                    const gchar    *app_id)
+{
+  CcPrivacyPanelPrivate *priv = self->priv;
+
+  g_hash_table_add (priv->location_apps_resolving, g_strdup (app_id));
+  g_queue_push_tail (priv->location_apps_queue, g_strdup (app_id));
+}
+
+static void
+requeue_missing_location_apps (CcPrivacyPanel *self)
+{
+  CcPrivacyPanelPrivate *priv = self->priv;
+  GHashTableIter iter;
+  gchar *app_id;
+
+  g_hash_table_iter_init (&iter, priv->location_apps_missing);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &app_id, NULL))
+    {
+      if (!g_hash_table_contains (priv->location_apps_resolving, app_id))
+        queue_location_app (self, app_id);
+      g_hash_table_iter_remove (&iter);
+    }
+}
+
+static void
+on_app_info_monitor_changed (GAppInfoMonitor *monitor,
+                             gpointer         user_data)
+{
+  CcPrivacyPanel *self = user_data;
+
+  requeue_missing_location_apps (self);
+  resolve_location_apps (self);
+}
+
+static void
+set_location_app_state (CcPrivacyPanel *self,
+                        const gchar    *app_id,
+                        gboolean        enabled,
+                        gint64          last_used)
+{
+  CcPrivacyPanelPrivate *priv = self->priv;
+  GtkWidget *w;
+
+  w = g_hash_table_lookup (priv->location_app_switches, app_id);
+  if (w != NULL)
+    {
+      update_location_app (w, enabled, last_used);
+      return;
+    }
+
+  /* Apps being looked up get their state once they are found */
+  if (g_hash_table_contains (priv->location_apps_resolving, app_id))
+    return;
+
+  g_hash_table_remove (priv->location_apps_missing, app_id);
+  queue_location_app (self, app_id);
+}
+
 /* Steals permissions and permissions_data references */
 static void
 update_perm_store (CcPrivacyPanel *self,
@@ -685,43 +952,66 @@ update_perm_store (CcPrivacyPanel *self,
                    GVariant *permissions_data)
 {
   CcPrivacyPanelPrivate *priv;
+  GHashTable *old_permissions;
+  GHashTableIter old_iter;
   GVariantIter iter;
   gchar *key;
-  gchar **value;
-  GList *children;
+  GVariant *value;
 
   priv = self->priv;
 
+  /* Only the entries that changed since the last time need to be
+   * looked at, and whatever is left over was removed from the store */
+  old_permissions = g_hash_table_new_full (g_str_hash,
+                                           g_str_equal,
+                                           g_free,
+                                           (GDestroyNotify) g_variant_unref);
+  if (priv->location_apps_perms != NULL)
+    {
+      g_variant_iter_init (&iter, priv->location_apps_perms);
+      while (g_variant_iter_next (&iter, "{s@as}", &key, &value))
+        g_hash_table_insert (old_permissions, key, value);
+    }
+
   g_clear_pointer (&priv->location_apps_perms, g_variant_unref);
   priv->location_apps_perms = permissions;
   g_clear_pointer (&priv->location_apps_data, g_variant_unref);
   priv->location_apps_data = permissions_data;
 
   g_variant_iter_init (&iter, permissions);
-  while (g_variant_iter_loop (&iter, "{s^as}", &key, &value))
+  while (g_variant_iter_next (&iter, "{s@as}", &key, &value))
     {
+      GVariant *old_value;
       gboolean enabled;
       gint64 last_used;
 
-      if (g_strv_length (value) < 2)
+      if (!get_location_app_state (value, &enabled, &last_used))
         {
           g_debug ("Permissions for %s in incorrect format, ignoring..", key);
-          continue;
         }
+      else
+        {
+          old_value = g_hash_table_lookup (old_permissions, key);
+          if (old_value == NULL || !g_variant_equal (old_value, value))
+            set_location_app_state (self, key, enabled, last_used);
 
-      enabled = (g_strcmp0 (value[0], "NONE") != 0);
-      last_used = g_ascii_strtoll (value[1], NULL, 10);
+          g_hash_table_remove (old_permissions, key);
+        }
 
-      add_location_app (self, key, enabled, last_used);
+      g_free (key);
+      g_variant_unref (value);
     }
 
-  children = gtk_container_get_children (GTK_CONTAINER (priv->location_apps_list_box));
-  if (g_list_length (children) > 0)
-    {
-      gtk_widget_set_visible (priv->location_apps_label, TRUE);
-      gtk_widget_set_visible (priv->location_apps_frame, TRUE);
-    }
-  g_list_free (children);
+  g_hash_table_iter_init (&old_iter, old_permissions);
+  while (g_hash_table_iter_next (&old_iter, (gpointer *) &key, NULL))
+    remove_location_app (self, key);
+  g_hash_table_unref (old_permissions);
+
+  /* Apps that were missing might have been installed since */
+  requeue_missing_location_apps (self);
+
+  update_location_apps_visibility (self);
+  resolve_location_apps (self);
 }
 
 static void
@@ -837,6 +1127,22 @@ add_location (CcPrivacyPanel *self)
                                                        g_str_equal,
                                                        g_free,
                                                        g_object_unref);
+  priv->location_apps_resolving = g_hash_table_new_full (g_str_hash,
+                                                         g_str_equal,
+                                                         g_free,
+                                                         NULL);
+  priv->location_apps_missing = g_hash_table_new_full (g_str_hash,
+                                                       g_str_equal,
+                                                       g_free,
+                                                       NULL);
+  priv->location_apps_queue = g_queue_new ();
+
+  priv->app_info_monitor = g_app_info_monitor_get ();
+  g_signal_connect_object (priv->app_info_monitor,
+                           "changed",
+                           G_CALLBACK (on_app_info_monitor_changed),
+                           self,
+                           0);
 
   g_dbus_proxy_new_for_bus (G_BUS_TYPE_SYSTEM,
                             G_DBUS_PROXY_FLAGS_NONE,
@@ -1269,6 +1575,14 @@ cc_privacy_panel_finalize (GObject *object)
   g_clear_pointer (&priv->location_apps_perms, g_variant_unref);
   g_clear_pointer (&priv->location_apps_data, g_variant_unref);
   g_clear_pointer (&priv->location_app_switches, g_hash_table_unref);
+  g_clear_pointer (&priv->location_apps_resolving, g_hash_table_unref);
+  g_clear_pointer (&priv->location_apps_missing, g_hash_table_unref);
+  g_clear_object (&priv->app_info_monitor);
+  if (priv->location_apps_queue != NULL)
+    {
+      g_queue_free_full (priv->location_apps_queue, g_free);
+      priv->location_apps_queue = NULL;
+    }
 
   G_OBJECT_CLASS (cc_privacy_panel_parent_class)->finalize (object);
 }
@@ -40,6 +40,7 @@ struct _CcSharingNetworksPrivate {
 
   char *service_name;
   GsdSharing *proxy;
+  GCancellable *cancellable;
   CcSharingStatus status;
 
   GList *networks; /* list of CcSharingNetwork */
@@ -58,9 +59,13 @@ enum {
 
 static void     cc_sharing_networks_class_init     (CcSharingNetworksClass *klass);
 static void     cc_sharing_networks_init           (CcSharingNetworks      *self);
+static void     cc_sharing_networks_dispose        (GObject                *object);
 static void     cc_sharing_networks_finalize       (GObject                *object);
 
 static void     cc_sharing_update_networks_box     (CcSharingNetworks *self);
+static gboolean cc_sharing_networks_enable_network (GtkSwitch         *widget,
+						    gboolean           state,
+						    gpointer           user_data);
 
 typedef struct {
   char *uuid;
@@ -98,26 +103,45 @@ cc_sharing_networks_update_status (CcSharingNetworks *self)
   }
 }
 
+/* The last list of networks seen for each service, shared by all the
+ * instances so that the dialogs can be filled in without waiting for
+ * gsd-sharing; service name → GVariant "a(sss)" */
+static GHashTable *networks_cache = NULL;
+
+static GVariant *
+cc_sharing_networks_cache_lookup (const char *service_name)
+{
+  if (networks_cache == NULL)
+    return NULL;
+  return g_hash_table_lookup (networks_cache, service_name);
+}
+
 static void
-cc_sharing_update_networks (CcSharingNetworks *self)
+cc_sharing_networks_cache_store (const char *service_name,
+				 GVariant   *networks)
+{
+  if (networks_cache == NULL)
+    networks_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+					    g_free, (GDestroyNotify) g_variant_unref);
+
+  if (networks != NULL)
+    g_hash_table_insert (networks_cache, g_strdup (service_name), g_variant_ref (networks));
+  else
+    g_hash_table_remove (networks_cache, service_name);
+}
+
+static void
+cc_sharing_networks_set_networks (CcSharingNetworks *self,
+				  GVariant          *networks)
 {
-  GVariant *networks;
   char *uuid, *network_name, *carrier_type;
   GVariantIter iter;
-  GError *error = NULL;
 
   g_list_free_full (self->priv->networks, cc_sharing_network_free);
   self->priv->networks = NULL;
 
-  if (!gsd_sharing_call_list_networks_sync (self->priv->proxy, self->priv->service_name, &networks, NULL, &error)) {
-    g_warning ("couldn't list networks: %s", error->message);
-    g_dbus_proxy_set_cached_property (G_DBUS_PROXY (self->priv->proxy),
-				      "SharingStatus",
-				      g_variant_new_uint32 (GSD_SHARING_STATUS_OFFLINE));
-    g_error_free (error);
-    cc_list_box_adjust_scrolling (GTK_LIST_BOX (self->priv->listbox));
+  if (networks == NULL)
     return;
-  }
 
   g_variant_iter_init (&iter, networks);
   while (g_variant_iter_next (&iter, "(sss)", &uuid, &network_name, &carrier_type)) {
@@ -130,36 +154,178 @@ cc_sharing_update_networks (CcSharingNetworks *self)
     self->priv->networks = g_list_prepend (self->priv->networks, net);
   }
   self->priv->networks = g_list_reverse (self->priv->networks);
-  cc_list_box_adjust_scrolling (GTK_LIST_BOX (self->priv->listbox));
+}
+
+static void
+cc_sharing_networks_list_cb (GObject      *source_object,
+			     GAsyncResult *res,
+			     gpointer      user_data)
+{
+  CcSharingNetworks *self;
+  GVariant *networks;
+  GError *error = NULL;
+
+  if (!gsd_sharing_call_list_networks_finish (GSD_SHARING (source_object), &networks, res, &error)) {
+    if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+      g_error_free (error);
+      return;
+    }
+
+    self = user_data;
+    g_warning ("couldn't list networks: %s", error->message);
+    g_dbus_proxy_set_cached_property (G_DBUS_PROXY (self->priv->proxy),
+				      "SharingStatus",
+				      g_variant_new_uint32 (GSD_SHARING_STATUS_OFFLINE));
+    g_error_free (error);
+
+    cc_sharing_networks_cache_store (self->priv->service_name, NULL);
+    cc_sharing_networks_set_networks (self, NULL);
+    cc_sharing_update_networks_box (self);
+    return;
+  }
+
+  self = user_data;
+  cc_sharing_networks_cache_store (self->priv->service_name, networks);
+  cc_sharing_networks_set_networks (self, networks);
+  cc_sharing_update_networks_box (self);
 
   g_variant_unref (networks);
 }
 
+/* Fetches the list of networks again, the box is updated once it's there */
 static void
-cc_sharing_networks_remove_network (GtkWidget         *button,
-				    CcSharingNetworks *self)
+cc_sharing_update_networks (CcSharingNetworks *self)
 {
-  GtkWidget *row;
+  gsd_sharing_call_list_networks (self->priv->proxy,
+				  self->priv->service_name,
+				  self->priv->cancellable,
+				  cc_sharing_networks_list_cb,
+				  self);
+}
+
+static void
+cc_sharing_networks_remove_network_cb (GObject      *source_object,
+				       GAsyncResult *res,
+				       gpointer      user_data)
+{
+  CcSharingNetworks *self;
   GError *error = NULL;
   gboolean ret;
-  const char *uuid;
 
-  row = g_object_get_data (G_OBJECT (button), "row");
-  uuid = g_object_get_data (G_OBJECT (row), "uuid");
+  ret = gsd_sharing_call_disable_service_finish (GSD_SHARING (source_object), res, &error);
+  if (!ret && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+    g_error_free (error);
+    return;
+  }
 
-  ret = gsd_sharing_call_disable_service_sync (self->priv->proxy,
-					       self->priv->service_name,
-					       uuid,
-					       NULL,
-					       &error);
+  self = user_data;
   if (!ret) {
     g_warning ("Failed to remove service %s: %s",
 	       self->priv->service_name, error->message);
     g_error_free (error);
   }
 
+  /* Brings the row back if the network could not be removed */
   cc_sharing_update_networks (self);
+}
+
+static void
+cc_sharing_networks_remove_network (GtkWidget         *button,
+				    CcSharingNetworks *self)
+{
+  GtkWidget *row;
+  GList *l;
+  char *uuid;
+
+  row = g_object_get_data (G_OBJECT (button), "row");
+  uuid = g_strdup (g_object_get_data (G_OBJECT (row), "uuid"));
+
+  gsd_sharing_call_disable_service (self->priv->proxy,
+				    self->priv->service_name,
+				    uuid,
+				    self->priv->cancellable,
+				    cc_sharing_networks_remove_network_cb,
+				    self);
+
+  /* Don't wait for gsd-sharing to remove the row */
+  for (l = self->priv->networks; l != NULL; l = l->next) {
+    CcSharingNetwork *net = l->data;
+
+    if (g_strcmp0 (net->uuid, uuid) == 0) {
+      self->priv->networks = g_list_delete_link (self->priv->networks, l);
+      cc_sharing_network_free (net);
+      break;
+    }
+  }
   cc_sharing_update_networks_box (self);
+
+  g_free (uuid);
+}
+
+static void
+cc_sharing_networks_set_switch_state (CcSharingNetworks *self,
+				      gboolean           state)
+{
+  GtkSwitch *widget = GTK_SWITCH (self->priv->current_switch);
+
+  g_signal_handlers_block_by_func (widget,
+				   cc_sharing_networks_enable_network, self);
+  gtk_switch_set_active (widget, state);
+  gtk_switch_set_state (widget, state);
+  g_signal_handlers_unblock_by_func (widget,
+				     cc_sharing_networks_enable_network, self);
+}
+
+static void
+cc_sharing_networks_enable_network_finish (CcSharingNetworks *self,
+					   gboolean           state,
+					   gboolean           ret,
+					   GError            *error)
+{
+  if (!ret) {
+    g_warning ("Failed to %s service %s: %s", state ? "enable" : "disable",
+	       self->priv->service_name, error->message);
+    cc_sharing_networks_set_switch_state (self, !state);
+  }
+
+  cc_sharing_update_networks (self);
+  cc_sharing_networks_update_status (self);
+}
+
+static void
+cc_sharing_networks_enable_service_cb (GObject      *source_object,
+				       GAsyncResult *res,
+				       gpointer      user_data)
+{
+  GError *error = NULL;
+  gboolean ret;
+
+  ret = gsd_sharing_call_enable_service_finish (GSD_SHARING (source_object), res, &error);
+  if (!ret && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+    g_error_free (error);
+    return;
+  }
+
+  cc_sharing_networks_enable_network_finish (user_data, TRUE, ret, error);
+  g_clear_error (&error);
+}
+
+static void
+cc_sharing_networks_disable_service_cb (GObject      *source_object,
+					GAsyncResult *res,
+					gpointer      user_data)
+{
+  GError *error = NULL;
+  gboolean ret;
+
+  ret = gsd_sharing_call_disable_service_finish (GSD_SHARING (source_object), res, &error);
+  if (!ret && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+    g_error_free (error);
+    return;
+  }
+
+  cc_sharing_networks_enable_network_finish (user_data, FALSE, ret, error);
+  g_clear_error (&error);
 }
 
 static gboolean
@@ -168,36 +334,24 @@ cc_sharing_networks_enable_network (GtkSwitch *widget,
 				    gpointer   user_data)
 {
   CcSharingNetworks *self = user_data;
-  GError *error = NULL;
-  gboolean ret;
 
   if (state) {
-    ret = gsd_sharing_call_enable_service_sync (self->priv->proxy,
-						self->priv->service_name,
-						NULL,
-						&error);
+    gsd_sharing_call_enable_service (self->priv->proxy,
+				     self->priv->service_name,
+				     self->priv->cancellable,
+				     cc_sharing_networks_enable_service_cb,
+				     self);
   } else {
-    ret = gsd_sharing_call_disable_service_sync (self->priv->proxy,
-						 self->priv->service_name,
-						 gsd_sharing_get_current_network (self->priv->proxy),
-						 NULL,
-						 &error);
+    gsd_sharing_call_disable_service (self->priv->proxy,
+				      self->priv->service_name,
+				      gsd_sharing_get_current_network (self->priv->proxy),
+				      self->priv->cancellable,
+				      cc_sharing_networks_disable_service_cb,
+				      self);
   }
 
-  if (ret) {
-    gtk_switch_set_state (widget, state);
-  } else {
-    g_warning ("Failed to %s service %s: %s", state ? "enable" : "disable",
-	       self->priv->service_name, error->message);
-    g_error_free (error);
-    g_signal_handlers_block_by_func (widget,
-                                     cc_sharing_networks_enable_network, self);
-    gtk_switch_set_active (widget, !state);
-    g_signal_handlers_unblock_by_func (widget,
-                                       cc_sharing_networks_enable_network, self);
-  }
-
-  cc_sharing_update_networks (self);
+  /* Show the new state right away, it's rolled back if the call fails */
+  gtk_switch_set_state (widget, state);
   cc_sharing_networks_update_status (self);
 
   return TRUE;
@@ -402,7 +556,6 @@ current_network_changed (GObject           *object,
 			 CcSharingNetworks *self)
 {
   cc_sharing_update_networks (self);
-  cc_sharing_update_networks_box (self);
 }
 
 static void
@@ -427,11 +580,13 @@ cc_sharing_networks_constructed (GObject *object)
   self->priv->no_network_row = cc_sharing_networks_new_no_network_row (self);
   gtk_list_box_insert (GTK_LIST_BOX (self->priv->listbox), self->priv->no_network_row, -1);
 
-  cc_sharing_update_networks (self);
+  /* Start from the networks found last time, if any */
+  cc_sharing_networks_set_networks (self, cc_sharing_networks_cache_lookup (self->priv->service_name));
   cc_sharing_update_networks_box (self);
+  cc_sharing_update_networks (self);
 
-  g_signal_connect (self->priv->proxy, "notify::current-network",
-		    G_CALLBACK (current_network_changed), self);
+  g_signal_connect_object (self->priv->proxy, "notify::current-network",
+			   G_CALLBACK (current_network_changed), self, 0);
 }
 
 static void
@@ -439,6 +594,7 @@ cc_sharing_networks_init (CcSharingNetworks *self)
 {
   gtk_widget_init_template (GTK_WIDGET (self));
   self->priv = cc_sharing_networks_get_instance_private (self);
+  self->priv->cancellable = g_cancellable_new ();
 }
 
 GtkWidget *
@@ -497,6 +653,19 @@ cc_sharing_networks_get_property (GObject      *object,
   }
 }
 
+static void
+cc_sharing_networks_dispose (GObject *object)
+{
+  CcSharingNetworks *self = CC_SHARING_NETWORKS (object);
+
+  if (self->priv->cancellable) {
+    g_cancellable_cancel (self->priv->cancellable);
+    g_clear_object (&self->priv->cancellable);
+  }
+
+  G_OBJECT_CLASS (cc_sharing_networks_parent_class)->dispose (object);
+}
+
 static void
 cc_sharing_networks_finalize (GObject *object)
 {
@@ -529,6 +698,7 @@ cc_sharing_networks_class_init (CcSharingNetworksClass *klass)
 
   object_class->set_property = cc_sharing_networks_set_property;
   object_class->get_property = cc_sharing_networks_get_property;
+  object_class->dispose = cc_sharing_networks_dispose;
   object_class->finalize = cc_sharing_networks_finalize;
   object_class->constructed = cc_sharing_networks_constructed;
 
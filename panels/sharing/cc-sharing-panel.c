@@ -74,6 +74,7 @@ struct _CcSharingPanelPrivate
   GtkWidget *hostname_entry;
 
   GDBusProxy *sharing_proxy;
+  GCancellable *sharing_cancellable;
 
   GtkWidget *media_sharing_switch;
   GtkWidget *personal_file_sharing_switch;
@@ -89,7 +90,7 @@ struct _CcSharingPanelPrivate
   GDBusProxy *rfkill;
 };
 
-#define OFF_IF_VISIBLE(x) { if (gtk_widget_is_visible(x) && gtk_widget_is_sensitive(x)) gtk_switch_set_active (GTK_SWITCH(x), FALSE); }
+#define OFF_IF_VISIBLE(x) { if ((x) != NULL && gtk_widget_is_visible(x) && gtk_widget_is_sensitive(x)) gtk_switch_set_active (GTK_SWITCH(x), FALSE); }
 
 static void
 cc_sharing_panel_master_switch_notify (GtkSwitch      *gtkswitch,
@@ -146,6 +147,12 @@ cc_sharing_panel_dispose (GObject *object)
       priv->personal_file_sharing_dialog = NULL;
     }
 
+  if (priv->sharing_cancellable)
+    {
+      g_cancellable_cancel (priv->sharing_cancellable);
+      g_clear_object (&priv->sharing_cancellable);
+    }
+
   if (priv->remote_login_cancellable)
     {
       g_cancellable_cancel (priv->remote_login_cancellable);
@@ -589,7 +596,7 @@ cc_sharing_panel_setup_media_sharing_dialog (CcSharingPanel *self)
 {
   CcSharingPanelPrivate *priv = self->priv;
   gchar **folders, **list;
-  GtkWidget *box, *networks, *grid, *w;
+  GtkWidget *box;
   char *path;
 
   path = g_find_program_in_path ("rygel");
@@ -632,6 +639,13 @@ cc_sharing_panel_setup_media_sharing_dialog (CcSharingPanel *self)
 
 
   g_strfreev (folders);
+}
+
+static void
+cc_sharing_panel_setup_media_sharing_networks (CcSharingPanel *self)
+{
+  CcSharingPanelPrivate *priv = self->priv;
+  GtkWidget *networks, *grid, *w;
 
   networks = cc_sharing_networks_new (self->priv->sharing_proxy, "rygel");
   grid = WID ("grid4");
@@ -857,7 +871,6 @@ cc_sharing_panel_setup_personal_file_sharing_dialog (CcSharingPanel *self)
 {
   CcSharingPanelPrivate *priv = self->priv;
   GSettings *settings;
-  GtkWidget *networks, *grid, *w;
 
   cc_sharing_panel_bind_switch_to_widgets (WID ("personal-file-sharing-require-password-switch"),
                                            WID ("personal-file-sharing-password-entry"),
@@ -882,6 +895,13 @@ cc_sharing_panel_setup_personal_file_sharing_dialog (CcSharingPanel *self)
   g_signal_connect (WID ("personal-file-sharing-password-entry"),
                     "notify::text", G_CALLBACK (file_sharing_password_changed),
                     NULL);
+}
+
+static void
+cc_sharing_panel_setup_personal_file_sharing_networks (CcSharingPanel *self)
+{
+  CcSharingPanelPrivate *priv = self->priv;
+  GtkWidget *networks, *grid, *w;
 
   networks = cc_sharing_networks_new (self->priv->sharing_proxy, "gnome-user-share-webdav");
   grid = WID ("grid2");
@@ -1005,7 +1025,6 @@ cc_sharing_panel_setup_screen_sharing_dialog (CcSharingPanel *self)
 {
   CcSharingPanelPrivate *priv = self->priv;
   GSettings *settings;
-  GtkWidget *networks, *box, *w;
 
   cc_sharing_panel_bind_switch_to_widgets (WID ("require-password-radiobutton"),
                                            WID ("password-grid"),
@@ -1048,6 +1067,13 @@ cc_sharing_panel_setup_screen_sharing_dialog (CcSharingPanel *self)
   /* accept at most 8 bytes in password entry */
   g_signal_connect (WID ("remote-control-password-entry"), "insert-text",
                     G_CALLBACK (screen_sharing_password_insert_text_cb), self);
+}
+
+static void
+cc_sharing_panel_setup_screen_sharing_networks (CcSharingPanel *self)
+{
+  CcSharingPanelPrivate *priv = self->priv;
+  GtkWidget *networks, *box, *w;
 
   networks = cc_sharing_networks_new (self->priv->sharing_proxy, "vino-server");
   box = WID ("remote-control-box");
@@ -1062,6 +1088,41 @@ cc_sharing_panel_setup_screen_sharing_dialog (CcSharingPanel *self)
                                            WID ("screen-sharing-status-label"));
 }
 
+static void
+sharing_proxy_ready (GObject      *source,
+                     GAsyncResult *res,
+                     gpointer      user_data)
+{
+  CcSharingPanel *self;
+  CcSharingPanelPrivate *priv;
+  GDBusProxy *proxy;
+  GError *error = NULL;
+
+  proxy = G_DBUS_PROXY (gsd_sharing_proxy_new_for_bus_finish (res, &error));
+  if (!proxy)
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_warning ("Failed to get sharing proxy: %s", error->message);
+      g_error_free (error);
+      return;
+    }
+
+  self = CC_SHARING_PANEL (user_data);
+  priv = self->priv;
+  priv->sharing_proxy = proxy;
+
+  /* the rows of the services that are not available were hidden
+   * when setting up their dialogs */
+  if (gtk_widget_get_visible (WID ("media-sharing-button")))
+    cc_sharing_panel_setup_media_sharing_networks (self);
+
+  if (gtk_widget_get_visible (WID ("personal-file-sharing-button")))
+    cc_sharing_panel_setup_personal_file_sharing_networks (self);
+
+  if (gtk_widget_get_visible (WID ("screen-sharing-button")))
+    cc_sharing_panel_setup_screen_sharing_networks (self);
+}
+
 static void
 cc_sharing_panel_init (CcSharingPanel *self)
 {
@@ -1075,7 +1136,6 @@ cc_sharing_panel_init (CcSharingPanel *self)
       "remote-login-dialog",
       "screen-sharing-dialog",
       NULL };
-  GError *error = NULL;
 
   g_resources_register (cc_sharing_get_resource ());
 
@@ -1133,17 +1193,6 @@ cc_sharing_panel_init (CcSharingPanel *self)
   g_signal_connect (priv->master_switch, "notify::active",
                     G_CALLBACK (cc_sharing_panel_master_switch_notify), self);
 
-  self->priv->sharing_proxy = G_DBUS_PROXY (gsd_sharing_proxy_new_for_bus_sync (G_BUS_TYPE_SESSION,
-										G_DBUS_PROXY_FLAGS_NONE,
-										"org.gnome.SettingsDaemon.Sharing",
-										"/org/gnome/SettingsDaemon/Sharing",
-										NULL,
-										&error));
-  if (!self->priv->sharing_proxy) {
-    g_warning ("Failed to get sharing proxy: %s", error->message);
-    g_error_free (error);
-  }
-
   /* media sharing */
   cc_sharing_panel_setup_media_sharing_dialog (self);
 
@@ -1167,6 +1216,17 @@ cc_sharing_panel_init (CcSharingPanel *self)
   else
     gtk_widget_hide (WID ("screen-sharing-button"));
 
+  /* the switches of the services that depend on the networks gsd-sharing
+   * knows about are added once it answers */
+  priv->sharing_cancellable = g_cancellable_new ();
+  gsd_sharing_proxy_new_for_bus (G_BUS_TYPE_SESSION,
+                                 G_DBUS_PROXY_FLAGS_NONE,
+                                 "org.gnome.SettingsDaemon.Sharing",
+                                 "/org/gnome/SettingsDaemon/Sharing",
+                                 priv->sharing_cancellable,
+                                 sharing_proxy_ready,
+                                 self);
+
   /* make sure the hostname entry isn't focused by default */
   g_signal_connect_swapped (self, "map", G_CALLBACK (gtk_widget_grab_focus),
                             WID ("main-list-box"));
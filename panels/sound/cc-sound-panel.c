@@ -73,6 +73,18 @@ cc_sound_panel_get_help_uri (CcPanel *panel)
   return "help:gnome-help/media#sound";
 }
 
+static void
+cc_sound_panel_suspend (CcPanel *panel)
+{
+        gvc_mixer_dialog_set_monitors_paused (CC_SOUND_PANEL (panel)->dialog, TRUE);
+}
+
+static void
+cc_sound_panel_resume (CcPanel *panel)
+{
+        gvc_mixer_dialog_set_monitors_paused (CC_SOUND_PANEL (panel)->dialog, FALSE);
+}
+
 static void
 cc_sound_panel_class_init (CcSoundPanelClass *klass)
 {
@@ -80,6 +92,8 @@ cc_sound_panel_class_init (CcSoundPanelClass *klass)
 	CcPanelClass *panel_class = CC_PANEL_CLASS (klass);
 
 	panel_class->get_help_uri = cc_sound_panel_get_help_uri;
+	panel_class->suspend = cc_sound_panel_suspend;
+	panel_class->resume = cc_sound_panel_resume;
 
         object_class->finalize = cc_sound_panel_finalize;
         object_class->set_property = cc_sound_panel_set_property;
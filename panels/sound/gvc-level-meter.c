@@ -0,0 +1,150 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2017 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <math.h>
+
+#include "gvc-level-meter.h"
+
+struct GvcLevelMeter
+{
+        /* Ballistics, in seconds */
+        gdouble attack;
+        gdouble release;
+
+        gdouble peak;
+        gdouble average;
+};
+
+GvcLevelMeter *
+gvc_level_meter_new (gdouble attack,
+                     gdouble release)
+{
+        GvcLevelMeter *meter;
+
+        meter = g_slice_new0 (GvcLevelMeter);
+        meter->attack = attack;
+        meter->release = release;
+
+        return meter;
+}
+
+void
+gvc_level_meter_free (GvcLevelMeter *meter)
+{
+        g_slice_free (GvcLevelMeter, meter);
+}
+
+void
+gvc_level_meter_reset (GvcLevelMeter *meter)
+{
+        meter->peak = 0.0;
+        meter->average = 0.0;
+}
+
+/* Computes the absolute peak and the average absolute level of a buffer
+ * of float samples. The samples come from peak-detecting streams, so they
+ * are already peaks over short periods, and the average is the level
+ * those peaks sit at rather than an RMS of the signal.
+ * The main loop works on 4 independent lanes so that it gets vectorized
+ * by the compiler, the remaining samples are handled one at a time. */
+void
+gvc_level_meter_measure (const float *samples,
+                         gsize        n_samples,
+                         float       *peak,
+                         float       *average)
+{
+        float max[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        float m, s;
+        gsize i, j;
+
+        for (i = 0; i + 4 <= n_samples; i += 4) {
+                for (j = 0; j < 4; j++) {
+                        float v = fabsf (samples[i + j]);
+
+                        max[j] = v > max[j] ? v : max[j];
+                        sum[j] += v;
+                }
+        }
+
+        m = MAX (MAX (max[0], max[1]), MAX (max[2], max[3]));
+        s = (sum[0] + sum[1]) + (sum[2] + sum[3]);
+
+        for (; i < n_samples; i++) {
+                float v = fabsf (samples[i]);
+
+                m = MAX (m, v);
+                s += v;
+        }
+
+        if (peak != NULL)
+                *peak = m;
+        if (average != NULL)
+                *average = n_samples > 0 ? s / n_samples : 0.0f;
+}
+
+static gdouble
+follow (gdouble current,
+        gdouble target,
+        gdouble attack,
+        gdouble release,
+        gdouble duration)
+{
+        gdouble time_constant;
+
+        time_constant = target > current ? attack : release;
+        if (time_constant <= 0.0)
+                return target;
+
+        return current + (target - current) * (1.0 - exp (-duration / time_constant));
+}
+
+/* Feeds @n_samples samples, covering @duration seconds, to the meter */
+void
+gvc_level_meter_process (GvcLevelMeter *meter,
+                         const float   *samples,
+                         gsize          n_samples,
+                         gdouble        duration)
+{
+        float peak, average;
+
+        if (n_samples == 0)
+                return;
+
+        gvc_level_meter_measure (samples, n_samples, &peak, &average);
+        peak = CLAMP (peak, 0.0f, 1.0f);
+        average = CLAMP (average, 0.0f, 1.0f);
+
+        meter->peak = follow (meter->peak, peak, meter->attack, meter->release, duration);
+        meter->average = follow (meter->average, average, meter->attack, meter->release, duration);
+}
+
+gdouble
+gvc_level_meter_get_peak (GvcLevelMeter *meter)
+{
+        return meter->peak;
+}
+
+gdouble
+gvc_level_meter_get_average (GvcLevelMeter *meter)
+{
+        return meter->average;
+}
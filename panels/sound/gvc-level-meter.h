@@ -0,0 +1,49 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2017 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __GVC_LEVEL_METER_H
+#define __GVC_LEVEL_METER_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct GvcLevelMeter GvcLevelMeter;
+
+GvcLevelMeter *     gvc_level_meter_new               (gdouble        attack,
+                                                       gdouble        release);
+void                gvc_level_meter_free              (GvcLevelMeter *meter);
+
+void                gvc_level_meter_reset             (GvcLevelMeter *meter);
+void                gvc_level_meter_process           (GvcLevelMeter *meter,
+                                                       const float   *samples,
+                                                       gsize          n_samples,
+                                                       gdouble        duration);
+
+gdouble             gvc_level_meter_get_peak          (GvcLevelMeter *meter);
+gdouble             gvc_level_meter_get_average       (GvcLevelMeter *meter);
+
+void                gvc_level_meter_measure           (const float   *samples,
+                                                       gsize          n_samples,
+                                                       float         *peak,
+                                                       float         *average);
+
+G_END_DECLS
+
+#endif /* __GVC_LEVEL_METER_H */
@@ -41,6 +41,7 @@
 #include "gvc-mixer-dialog.h"
 #include "gvc-sound-theme-chooser.h"
 #include "gvc-level-bar.h"
+#include "gvc-level-meter.h"
 #include "gvc-speaker-test.h"
 #include "gvc-mixer-control-private.h"
 
@@ -78,7 +79,9 @@ struct GvcMixerDialogPrivate
         GtkWidget       *test_dialog;
         GtkSizeGroup    *size_group;
 
-        gdouble          last_input_peak;
+        GHashTable      *monitors; /* level bar → LevelMonitor */
+        guint            monitor_tick_id;
+        gboolean         monitors_paused;
         guint            num_apps;
 };
 
@@ -118,6 +121,9 @@ static void     on_control_active_input_update (GvcMixerControl *control,
 static void     on_test_speakers_clicked (GvcComboBox *widget,
                                           gpointer     user_data);
 
+static void     stop_level_monitor       (GvcMixerDialog *dialog,
+                                          GtkWidget      *bar);
+
 
 G_DEFINE_TYPE (GvcMixerDialog, gvc_mixer_dialog, GTK_TYPE_BOX)
 
@@ -158,6 +164,7 @@ update_output_settings (GvcMixerDialog      *dialog,
         GtkAdjustment       *adj;
 
         g_debug ("Updating output settings");
+
         if (dialog->priv->output_balance_bar != NULL) {
                 gtk_container_remove (GTK_CONTAINER (dialog->priv->output_settings_box),
                                       dialog->priv->output_balance_bar);
@@ -284,53 +291,88 @@ update_output_settings (GvcMixerDialog      *dialog,
         gtk_widget_set_sensitive (dialog->priv->output_balance_bar, gvc_channel_map_can_balance (map));
 }
 
-#define DECAY_STEP .15
+/* The monitoring streams are recorded with PA_STREAM_PEAK_DETECT, so each
+ * sample is the peak of the source over 1/METER_RATE seconds, and read
+ * METER_FRAGMENT samples at a time */
+#define METER_RATE 200
+#define METER_FRAGMENT (METER_RATE / 25)
+
+/* Ballistics of the level bars, in seconds. The bars hold their
+ * maximum peak themselves. */
+#define METER_ATTACK 0.01
+#define METER_RELEASE 0.3
+
+/* All the level bars are refreshed together from a single timeout */
+#define METER_UPDATE_INTERVAL 40 /* ms */
+
+typedef struct {
+        GvcMixerDialog *dialog;
+        GvcMixerStream *stream;
+        GtkWidget      *bar;
+        pa_stream      *pa_stream;
+        GvcLevelMeter  *meter;
+        gboolean        changed;
+} LevelMonitor;
 
 static void
-update_input_peak (GvcMixerDialog *dialog,
-                   gdouble         v)
+level_monitor_free (LevelMonitor *monitor)
 {
-        GtkAdjustment *adj;
+        g_debug ("Stopping monitor for %u", pa_stream_get_index (monitor->pa_stream));
 
-        if (dialog->priv->last_input_peak >= DECAY_STEP) {
-                if (v < dialog->priv->last_input_peak - DECAY_STEP) {
-                        v = dialog->priv->last_input_peak - DECAY_STEP;
-                }
-        }
-
-        dialog->priv->last_input_peak = v;
+        pa_stream_set_read_callback (monitor->pa_stream, NULL, NULL);
+        pa_stream_set_suspended_callback (monitor->pa_stream, NULL, NULL);
+        pa_stream_disconnect (monitor->pa_stream);
+        pa_stream_unref (monitor->pa_stream);
 
-        adj = gvc_level_bar_get_peak_adjustment (GVC_LEVEL_BAR (dialog->priv->input_level_bar));
-        if (v >= 0) {
-                gtk_adjustment_set_value (adj, v);
-        } else {
-                gtk_adjustment_set_value (adj, 0.0);
-        }
+        gvc_level_meter_free (monitor->meter);
+        g_object_unref (monitor->stream);
+        g_slice_free (LevelMonitor, monitor);
 }
 
 static void
-update_input_meter (GvcMixerDialog *dialog,
-                    uint32_t        source_index,
-                    uint32_t        sink_input_idx,
-                    double          v)
+update_level_bar (GtkWidget *bar,
+                  gdouble    peak,
+                  gdouble    average)
+{
+        GtkAdjustment *adj;
+
+        adj = gvc_level_bar_get_peak_adjustment (GVC_LEVEL_BAR (bar));
+        gtk_adjustment_set_value (adj, peak);
+        adj = gvc_level_bar_get_rms_adjustment (GVC_LEVEL_BAR (bar));
+        gtk_adjustment_set_value (adj, average);
+}
+
+static gboolean
+on_monitor_tick (gpointer user_data)
 {
-        update_input_peak (dialog, v);
+        GvcMixerDialog *dialog = user_data;
+        GHashTableIter  iter;
+        LevelMonitor   *monitor;
+
+        g_hash_table_iter_init (&iter, dialog->priv->monitors);
+        while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &monitor)) {
+                if (!monitor->changed)
+                        continue;
+
+                update_level_bar (monitor->bar,
+                                  gvc_level_meter_get_peak (monitor->meter),
+                                  gvc_level_meter_get_average (monitor->meter));
+                monitor->changed = FALSE;
+        }
+
+        return G_SOURCE_CONTINUE;
 }
 
 static void
 on_monitor_suspended_callback (pa_stream *s,
                                void      *userdata)
 {
-        GvcMixerDialog *dialog;
-
-        dialog = userdata;
+        LevelMonitor *monitor = userdata;
 
         if (pa_stream_is_suspended (s)) {
                 g_debug ("Stream suspended");
-                update_input_meter (dialog,
-                                    pa_stream_get_device_index (s),
-                                    PA_INVALID_INDEX,
-                                    -1);
+                gvc_level_meter_reset (monitor->meter);
+                monitor->changed = TRUE;
         }
 }
 
@@ -339,11 +381,9 @@ on_monitor_read_callback (pa_stream *s,
                           size_t     length,
                           void      *userdata)
 {
-        GvcMixerDialog *dialog;
-        const void     *data;
-        double          v;
-
-        dialog = userdata;
+        LevelMonitor *monitor = userdata;
+        const void   *data;
+        gsize         n_samples;
 
         if (pa_stream_peek (s, &data, &length) < 0) {
                 g_warning ("Failed to read data from stream");
@@ -358,43 +398,53 @@ on_monitor_read_callback (pa_stream *s,
         assert (length > 0);
         assert (length % sizeof (float) == 0);
 
-        v = ((const float *) data)[length / sizeof (float) -1];
+        /* Every sample of the fragment is taken into account, not only
+         * the last one */
+        n_samples = length / sizeof (float);
+        gvc_level_meter_process (monitor->meter,
+                                 (const float *) data,
+                                 n_samples,
+                                 (gdouble) n_samples / METER_RATE);
+        monitor->changed = TRUE;
 
         pa_stream_drop (s);
+}
 
-        if (v < 0) {
-                v = 0;
-        }
-        if (v > 1) {
-                v = 1;
-        }
+static void
+stop_level_monitor (GvcMixerDialog *dialog,
+                    GtkWidget      *bar)
+{
+        if (!g_hash_table_remove (dialog->priv->monitors, bar))
+                return;
+
+        update_level_bar (bar, 0.0, 0.0);
 
-        update_input_meter (dialog,
-                            pa_stream_get_device_index (s),
-                            pa_stream_get_monitor_stream (s),
-                            v);
+        if (g_hash_table_size (dialog->priv->monitors) == 0 &&
+            dialog->priv->monitor_tick_id != 0) {
+                g_source_remove (dialog->priv->monitor_tick_id);
+                dialog->priv->monitor_tick_id = 0;
+        }
 }
 
 static void
-create_monitor_stream_for_source (GvcMixerDialog *dialog,
-                                  GvcMixerStream *stream)
+start_level_monitor (GvcMixerDialog *dialog,
+                     GtkWidget      *bar,
+                     GvcMixerStream *stream,
+                     const char     *device)
 {
+        LevelMonitor  *monitor;
         pa_stream     *s;
-        char           t[16];
         pa_buffer_attr attr;
         pa_sample_spec ss;
         pa_context    *context;
         int            res;
         pa_proplist   *proplist;
-        gboolean       has_monitor;
 
-        if (stream == NULL) {
+        monitor = g_hash_table_lookup (dialog->priv->monitors, bar);
+        if (monitor != NULL && monitor->stream == stream)
                 return;
-        }
-        has_monitor = GPOINTER_TO_INT (g_object_get_data (G_OBJECT (stream), "has-monitor"));
-        if (has_monitor != FALSE) {
-                return;
-        }
+
+        stop_level_monitor (dialog, bar);
 
         g_debug ("Create monitor for %u",
                  gvc_mixer_stream_get_index (stream));
@@ -407,14 +457,12 @@ create_monitor_stream_for_source (GvcMixerDialog *dialog,
 
         ss.channels = 1;
         ss.format = PA_SAMPLE_FLOAT32;
-        ss.rate = 25;
+        ss.rate = METER_RATE;
 
         memset (&attr, 0, sizeof (attr));
-        attr.fragsize = sizeof (float);
+        attr.fragsize = METER_FRAGMENT * sizeof (float);
         attr.maxlength = (uint32_t) -1;
 
-        snprintf (t, sizeof (t), "%u", gvc_mixer_stream_get_index (stream));
-
         proplist = pa_proplist_new ();
         pa_proplist_sets (proplist, PA_PROP_APPLICATION_ID, "org.gnome.VolumeControl");
         s = pa_stream_new_with_proplist (context, _("Peak detect"), &ss, NULL, proplist);
@@ -424,52 +472,90 @@ create_monitor_stream_for_source (GvcMixerDialog *dialog,
                 return;
         }
 
-        pa_stream_set_read_callback (s, on_monitor_read_callback, dialog);
-        pa_stream_set_suspended_callback (s, on_monitor_suspended_callback, dialog);
+        monitor = g_slice_new0 (LevelMonitor);
+        monitor->dialog = dialog;
+        monitor->stream = g_object_ref (stream);
+        monitor->bar = bar;
+        monitor->pa_stream = s;
+        monitor->meter = gvc_level_meter_new (METER_ATTACK, METER_RELEASE);
+
+        pa_stream_set_read_callback (s, on_monitor_read_callback, monitor);
+        pa_stream_set_suspended_callback (s, on_monitor_suspended_callback, monitor);
 
         res = pa_stream_connect_record (s,
-                                        t,
+                                        device,
                                         &attr,
                                         (pa_stream_flags_t) (PA_STREAM_DONT_MOVE
                                                              |PA_STREAM_PEAK_DETECT
-                                                             |PA_STREAM_ADJUST_LATENCY));
+                                                             |PA_STREAM_ADJUST_LATENCY
+                                                             |(dialog->priv->monitors_paused ? PA_STREAM_START_CORKED : 0)));
         if (res < 0) {
                 g_warning ("Failed to connect monitoring stream");
-                pa_stream_unref (s);
-        } else {
-                g_object_set_data (G_OBJECT (stream), "has-monitor", GINT_TO_POINTER (TRUE));
-                g_object_set_data (G_OBJECT (dialog->priv->input_level_bar), "pa_stream", s);
-                g_object_set_data (G_OBJECT (dialog->priv->input_level_bar), "stream", stream);
+                level_monitor_free (monitor);
+                return;
         }
+
+        g_hash_table_insert (dialog->priv->monitors, bar, monitor);
+
+        if (dialog->priv->monitor_tick_id == 0 && !dialog->priv->monitors_paused)
+                dialog->priv->monitor_tick_id = g_timeout_add (METER_UPDATE_INTERVAL,
+                                                               on_monitor_tick,
+                                                               dialog);
 }
 
-static void
-stop_monitor_stream_for_source (GvcMixerDialog *dialog)
+/* Corks the monitoring streams and stops refreshing the level bars,
+ * for when the dialog is not shown */
+void
+gvc_mixer_dialog_set_monitors_paused (GvcMixerDialog *dialog,
+                                      gboolean        paused)
 {
-        pa_stream      *s;
-        pa_context     *context;
-        int             res;
-        GvcMixerStream *stream;
+        GHashTableIter  iter;
+        LevelMonitor   *monitor;
 
-        s = g_object_get_data (G_OBJECT (dialog->priv->input_level_bar), "pa_stream");
-        if (s == NULL)
+        g_return_if_fail (GVC_IS_MIXER_DIALOG (dialog));
+
+        if (dialog->priv->monitors_paused == paused)
                 return;
-        stream = g_object_get_data (G_OBJECT (dialog->priv->input_level_bar), "stream");
-        g_assert (stream != NULL);
+        dialog->priv->monitors_paused = paused;
 
-        g_debug ("Stopping monitor for %u", pa_stream_get_index (s));
+        g_debug ("%s level monitors", paused ? "Pausing" : "Resuming");
 
-        context = gvc_mixer_control_get_pa_context (dialog->priv->mixer_control);
+        g_hash_table_iter_init (&iter, dialog->priv->monitors);
+        while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &monitor)) {
+                pa_operation *o;
 
-        if (pa_context_get_server_protocol_version (context) < 13) {
-                return;
+                if (pa_stream_get_state (monitor->pa_stream) == PA_STREAM_READY) {
+                        o = pa_stream_cork (monitor->pa_stream, paused, NULL, NULL);
+                        if (o != NULL)
+                                pa_operation_unref (o);
+                }
+
+                if (paused) {
+                        gvc_level_meter_reset (monitor->meter);
+                        update_level_bar (monitor->bar, 0.0, 0.0);
+                        monitor->changed = FALSE;
+                }
+        }
+
+        if (paused && dialog->priv->monitor_tick_id != 0) {
+                g_source_remove (dialog->priv->monitor_tick_id);
+                dialog->priv->monitor_tick_id = 0;
+        } else if (!paused && dialog->priv->monitor_tick_id == 0 &&
+                   g_hash_table_size (dialog->priv->monitors) > 0) {
+                dialog->priv->monitor_tick_id = g_timeout_add (METER_UPDATE_INTERVAL,
+                                                               on_monitor_tick,
+                                                               dialog);
         }
+}
 
-        res = pa_stream_disconnect (s);
-        if (res == 0)
-                g_object_set_data (G_OBJECT (stream), "has-monitor", GINT_TO_POINTER (FALSE));
-        g_object_set_data (G_OBJECT (dialog->priv->input_level_bar), "pa_stream", NULL);
-        g_object_set_data (G_OBJECT (dialog->priv->input_level_bar), "stream", NULL);
+static void
+create_monitor_stream_for_source (GvcMixerDialog *dialog,
+                                  GvcMixerStream *stream)
+{
+        char t[16];
+
+        snprintf (t, sizeof (t), "%u", gvc_mixer_stream_get_index (stream));
+        start_level_monitor (dialog, dialog->priv->input_level_bar, stream, t);
 }
 
 static void
@@ -482,7 +568,7 @@ update_input_settings (GvcMixerDialog   *dialog,
 
         g_debug ("Updating input settings");
 
-        stop_monitor_stream_for_source (dialog);
+        stop_level_monitor (dialog, dialog->priv->input_level_bar);
 
         if (dialog->priv->input_profile_combo != NULL) {
                 gtk_container_remove (GTK_CONTAINER (dialog->priv->input_settings_box),
@@ -1861,6 +1947,12 @@ gvc_mixer_dialog_dispose (GObject *object)
                 dialog->priv->mixer_control = NULL;
         }
 
+        if (dialog->priv->monitor_tick_id != 0) {
+                g_source_remove (dialog->priv->monitor_tick_id);
+                dialog->priv->monitor_tick_id = 0;
+        }
+        g_clear_pointer (&dialog->priv->monitors, g_hash_table_destroy);
+
         if (dialog->priv->bars != NULL) {
                 g_hash_table_destroy (dialog->priv->bars);
                 dialog->priv->bars = NULL;
@@ -1904,6 +1996,8 @@ gvc_mixer_dialog_init (GvcMixerDialog *dialog)
                                         GTK_ORIENTATION_VERTICAL);
         dialog->priv = GVC_MIXER_DIALOG_GET_PRIVATE (dialog);
         dialog->priv->bars = g_hash_table_new (NULL, NULL);
+        dialog->priv->monitors = g_hash_table_new_full (NULL, NULL, NULL,
+                                                        (GDestroyNotify) level_monitor_free);
         dialog->priv->size_group = gtk_size_group_new (GTK_SIZE_GROUP_HORIZONTAL);
 }
 
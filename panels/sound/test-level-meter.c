@@ -0,0 +1,118 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2017 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <glib.h>
+
+#include "gvc-level-meter.h"
+
+#define RATE 200
+#define FRAGMENT 8
+
+static void
+test_measure (void)
+{
+        float samples[103];
+        float peak, average;
+        guint i;
+
+        /* Odd length, so that the tail loop is exercised, and the peak
+         * is in the tail and negative */
+        for (i = 0; i < G_N_ELEMENTS (samples); i++)
+                samples[i] = (i % 2) ? 0.5f : -0.5f;
+        samples[G_N_ELEMENTS (samples) - 1] = -0.9f;
+
+        gvc_level_meter_measure (samples, G_N_ELEMENTS (samples), &peak, &average);
+        g_assert_cmpfloat (fabsf (peak - 0.9f), <, 1e-6);
+        g_assert_cmpfloat (average, >, 0.5f);
+        g_assert_cmpfloat (average, <, 0.51f);
+
+        /* Full-scale sine wave */
+        for (i = 0; i < 100; i++)
+                samples[i] = sinf (2 * G_PI * i / 100.0);
+        gvc_level_meter_measure (samples, 100, &peak, &average);
+        g_assert_cmpfloat (fabsf (peak - 1.0f), <, 1e-3);
+        g_assert_cmpfloat (fabsf (average - (float) (2 / G_PI)), <, 1e-3);
+
+        gvc_level_meter_measure (samples, 0, &peak, &average);
+        g_assert_cmpfloat (peak, ==, 0.0f);
+        g_assert_cmpfloat (average, ==, 0.0f);
+}
+
+static void
+feed (GvcLevelMeter *meter,
+      float          value,
+      guint          n_fragments)
+{
+        float samples[FRAGMENT];
+        guint i;
+
+        for (i = 0; i < FRAGMENT; i++)
+                samples[i] = value;
+        for (i = 0; i < n_fragments; i++)
+                gvc_level_meter_process (meter, samples, FRAGMENT, (gdouble) FRAGMENT / RATE);
+}
+
+static void
+test_ballistics (void)
+{
+        GvcLevelMeter *meter;
+
+        meter = gvc_level_meter_new (0.01, 0.3);
+
+        /* Fast attack */
+        feed (meter, 0.8f, 1);
+        g_assert_cmpfloat (gvc_level_meter_get_peak (meter), >, 0.75);
+        g_assert_cmpfloat (gvc_level_meter_get_average (meter), >, 0.75);
+
+        /* Slow release: after 0.2 seconds of silence, the level is
+         * still well above zero */
+        feed (meter, 0.0f, 5);
+        g_assert_cmpfloat (gvc_level_meter_get_peak (meter), >, 0.3);
+        g_assert_cmpfloat (gvc_level_meter_get_peak (meter), <, 0.8);
+
+        /* And it eventually falls back to silence */
+        feed (meter, 0.0f, 75);
+        g_assert_cmpfloat (gvc_level_meter_get_peak (meter), <, 0.01);
+        g_assert_cmpfloat (gvc_level_meter_get_average (meter), <, 0.01);
+
+        /* Values are clamped to full-scale */
+        feed (meter, 4.0f, 10);
+        g_assert_cmpfloat (gvc_level_meter_get_peak (meter), <=, 1.0);
+        g_assert_cmpfloat (gvc_level_meter_get_average (meter), <=, 1.0);
+
+        gvc_level_meter_reset (meter);
+        g_assert_cmpfloat (gvc_level_meter_get_peak (meter), ==, 0.0);
+        g_assert_cmpfloat (gvc_level_meter_get_average (meter), ==, 0.0);
+
+        gvc_level_meter_free (meter);
+}
+
+int
+main (int argc, char **argv)
+{
+        g_test_init (&argc, &argv, NULL);
+
+        g_test_add_func ("/sound/level-meter/measure", test_measure);
+        g_test_add_func ("/sound/level-meter/ballistics", test_ballistics);
+
+        return g_test_run ();
+}
@@ -27,11 +27,15 @@
 #include <gtk/gtk.h>
 
 #include "cc-crop-area.h"
+#include "cc-crop-shade.h"
+
+/* How much the image outside the crop rectangle is darkened */
+#define SHADE_AMOUNT 32
 
 struct _CcCropAreaPrivate {
         GdkPixbuf *browse_pixbuf;
-        GdkPixbuf *pixbuf;
-        GdkPixbuf *color_shifted;
+        cairo_surface_t *surface;
+        cairo_surface_t *shaded_surface;
         gdouble scale;
         GdkRectangle image;
         GdkCursorType current_cursor;
@@ -46,46 +50,6 @@ struct _CcCropAreaPrivate {
 
 G_DEFINE_TYPE (CcCropArea, cc_crop_area, GTK_TYPE_DRAWING_AREA);
 
-static inline guchar
-shift_color_byte (guchar b,
-                  int    shift)
-{
-        return CLAMP(b + shift, 0, 255);
-}
-
-static void
-shift_colors (GdkPixbuf *pixbuf,
-              gint       red,
-              gint       green,
-              gint       blue,
-              gint       alpha)
-{
-        gint x, y, offset, y_offset, rowstride, width, height;
-        guchar *pixels;
-        gint channels;
-
-        width = gdk_pixbuf_get_width (pixbuf);
-        height = gdk_pixbuf_get_height (pixbuf);
-        rowstride = gdk_pixbuf_get_rowstride (pixbuf);
-        pixels = gdk_pixbuf_get_pixels (pixbuf);
-        channels = gdk_pixbuf_get_n_channels (pixbuf);
-
-        for (y = 0; y < height; y++) {
-                y_offset = y * rowstride;
-                for (x = 0; x < width; x++) {
-                        offset = y_offset + x * channels;
-                        if (red != 0)
-                                pixels[offset] = shift_color_byte (pixels[offset], red);
-                        if (green != 0)
-                                pixels[offset + 1] = shift_color_byte (pixels[offset + 1], green);
-                        if (blue != 0)
-                                pixels[offset + 2] = shift_color_byte (pixels[offset + 2], blue);
-                        if (alpha != 0 && channels >= 4)
-                                pixels[offset + 3] = shift_color_byte (pixels[offset + 3], blue);
-                }
-        }
-}
-
 static void
 update_pixbufs (CcCropArea *area)
 {
@@ -109,36 +73,47 @@ update_pixbufs (CcCropArea *area)
         dest_width = width * scale;
         dest_height = height * scale;
 
-        if (area->priv->pixbuf == NULL ||
-            gdk_pixbuf_get_width (area->priv->pixbuf) != allocation.width ||
-            gdk_pixbuf_get_height (area->priv->pixbuf) != allocation.height) {
-                if (area->priv->pixbuf != NULL)
-                        g_object_unref (area->priv->pixbuf);
-                area->priv->pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB,
-                                                     gdk_pixbuf_get_has_alpha (area->priv->browse_pixbuf),
-                                                     8,
-                                                     dest_width, dest_height);
-                gdk_pixbuf_fill (area->priv->pixbuf, 0x0);
+        /* The scaled image and its shaded copy only depend on the picture
+         * and the size it is shown at, so they are kept across draws and
+         * dragging the crop rectangle only composites the damaged area. */
+        if (area->priv->surface == NULL ||
+            cairo_image_surface_get_width (area->priv->surface) != dest_width ||
+            cairo_image_surface_get_height (area->priv->surface) != dest_height) {
+                GdkPixbuf *pixbuf;
+
+                pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB,
+                                         gdk_pixbuf_get_has_alpha (area->priv->browse_pixbuf),
+                                         8,
+                                         dest_width, dest_height);
+                gdk_pixbuf_fill (pixbuf, 0x0);
 
                 gdk_pixbuf_scale (area->priv->browse_pixbuf,
-                                  area->priv->pixbuf,
+                                  pixbuf,
                                   0, 0,
                                   dest_width, dest_height,
                                   0, 0,
                                   scale, scale,
                                   GDK_INTERP_BILINEAR);
 
-                if (area->priv->color_shifted)
-                        g_object_unref (area->priv->color_shifted);
-                area->priv->color_shifted = gdk_pixbuf_copy (area->priv->pixbuf);
-                shift_colors (area->priv->color_shifted, -32, -32, -32, 0);
+                g_clear_pointer (&area->priv->surface, cairo_surface_destroy);
+                area->priv->surface = gdk_cairo_surface_create_from_pixbuf (pixbuf, 1, NULL);
+
+                cc_crop_shade_pixels (gdk_pixbuf_get_pixels (pixbuf),
+                                      dest_width, dest_height,
+                                      gdk_pixbuf_get_rowstride (pixbuf),
+                                      gdk_pixbuf_get_n_channels (pixbuf),
+                                      SHADE_AMOUNT);
+
+                g_clear_pointer (&area->priv->shaded_surface, cairo_surface_destroy);
+                area->priv->shaded_surface = gdk_cairo_surface_create_from_pixbuf (pixbuf, 1, NULL);
+                g_object_unref (pixbuf);
 
                 if (area->priv->scale == 0.0) {
                         gdouble scale_to_80, scale_to_image, crop_scale;
 
                         /* Scale the crop rectangle to 80% of the area, or less to fit the image */
-                        scale_to_80 = MIN ((gdouble)gdk_pixbuf_get_width (area->priv->pixbuf) * 0.8 / area->priv->base_width,
-                                           (gdouble)gdk_pixbuf_get_height (area->priv->pixbuf) * 0.8 / area->priv->base_height);
+                        scale_to_80 = MIN ((gdouble)dest_width * 0.8 / area->priv->base_width,
+                                           (gdouble)dest_height * 0.8 / area->priv->base_height);
                         scale_to_image = MIN ((gdouble)dest_width / area->priv->base_width,
                                               (gdouble)dest_height / area->priv->base_height);
                         crop_scale = MIN (scale_to_80, scale_to_image);
@@ -148,13 +123,13 @@ update_pixbufs (CcCropArea *area)
                         area->priv->crop.x = (gdk_pixbuf_get_width (area->priv->browse_pixbuf) - area->priv->crop.width) / 2;
                         area->priv->crop.y = (gdk_pixbuf_get_height (area->priv->browse_pixbuf) - area->priv->crop.height) / 2;
                 }
-
-                area->priv->scale = scale;
-                area->priv->image.x = (allocation.width - dest_width) / 2;
-                area->priv->image.y = (allocation.height - dest_height) / 2;
-                area->priv->image.width = dest_width;
-                area->priv->image.height = dest_height;
         }
+
+        area->priv->scale = scale;
+        area->priv->image.x = (allocation.width - dest_width) / 2;
+        area->priv->image.y = (allocation.height - dest_height) / 2;
+        area->priv->image.width = dest_width;
+        area->priv->image.height = dest_height;
 }
 
 static void
@@ -193,21 +168,21 @@ cc_crop_area_draw (GtkWidget *widget,
 
         update_pixbufs (uarea);
 
-        width = gdk_pixbuf_get_width (uarea->priv->pixbuf);
-        height = gdk_pixbuf_get_height (uarea->priv->pixbuf);
+        width = uarea->priv->image.width;
+        height = uarea->priv->image.height;
         crop_to_widget (uarea, &crop);
 
         ix = uarea->priv->image.x;
         iy = uarea->priv->image.y;
 
-        gdk_cairo_set_source_pixbuf (cr, uarea->priv->color_shifted, ix, iy);
+        cairo_set_source_surface (cr, uarea->priv->shaded_surface, ix, iy);
         cairo_rectangle (cr, ix, iy, width, crop.y - iy);
         cairo_rectangle (cr, ix, crop.y, crop.x - ix, crop.height);
         cairo_rectangle (cr, crop.x + crop.width, crop.y, width - crop.width - (crop.x - ix), crop.height);
         cairo_rectangle (cr, ix, crop.y + crop.height, width, height - crop.height - (crop.y - iy));
         cairo_fill (cr);
 
-        gdk_cairo_set_source_pixbuf (cr, uarea->priv->pixbuf, ix, iy);
+        cairo_set_source_surface (cr, uarea->priv->surface, ix, iy);
         cairo_rectangle (cr, crop.x, crop.y, crop.width, crop.height);
         cairo_fill (cr);
 
@@ -698,14 +673,8 @@ cc_crop_area_finalize (GObject *object)
                 g_object_unref (area->priv->browse_pixbuf);
                 area->priv->browse_pixbuf = NULL;
         }
-        if (area->priv->pixbuf) {
-                g_object_unref (area->priv->pixbuf);
-                area->priv->pixbuf = NULL;
-        }
-        if (area->priv->color_shifted) {
-                g_object_unref (area->priv->color_shifted);
-                area->priv->color_shifted = NULL;
-        }
+        g_clear_pointer (&area->priv->surface, cairo_surface_destroy);
+        g_clear_pointer (&area->priv->shaded_surface, cairo_surface_destroy);
 }
 
 static void
@@ -788,6 +757,9 @@ cc_crop_area_set_picture (CcCropArea *area,
                 height = 0;
         }
 
+        g_clear_pointer (&area->priv->surface, cairo_surface_destroy);
+        g_clear_pointer (&area->priv->shaded_surface, cairo_surface_destroy);
+
         area->priv->crop.width = 2 * area->priv->base_width;
         area->priv->crop.height = 2 * area->priv->base_height;
         area->priv->crop.x = (width - area->priv->crop.width) / 2;
@@ -0,0 +1,95 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*-
+ *
+ * Copyright 2017  Red Hat, Inc,
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "cc-crop-shade.h"
+
+/* Subtracts @amount from @b, saturating at 0 */
+static inline guchar
+shade_byte (guchar b,
+            guchar amount)
+{
+        return b > amount ? b - amount : 0;
+}
+
+/* Darkens the colour channels of a row of 3 or 4 channel pixels by
+ * @amount, saturating at 0. The alpha channel is left alone. */
+static void
+shade_row (guchar *row,
+           gint    width,
+           gint    n_channels,
+           guchar  amount)
+{
+        gsize n_bytes, i;
+
+        n_bytes = (gsize) width * n_channels;
+        i = 0;
+
+#ifdef __SSE2__
+        {
+                __m128i sub;
+
+                /* Rows start on a pixel boundary, so 16 bytes always hold
+                 * whole pixels with 4 channels; with 3 channels every byte
+                 * is a colour. */
+                if (n_channels == 4)
+                        sub = _mm_set1_epi32 (amount | amount << 8 | amount << 16);
+                else
+                        sub = _mm_set1_epi8 (amount);
+
+                for (; i + 16 <= n_bytes; i += 16) {
+                        __m128i v = _mm_loadu_si128 ((const __m128i *) (row + i));
+                        _mm_storeu_si128 ((__m128i *) (row + i), _mm_subs_epu8 (v, sub));
+                }
+        }
+#endif
+
+        /* Written so that the compiler can vectorize it where SSE2 is
+         * not available */
+        if (n_channels == 4) {
+                for (; i < n_bytes; i += 4) {
+                        row[i] = shade_byte (row[i], amount);
+                        row[i + 1] = shade_byte (row[i + 1], amount);
+                        row[i + 2] = shade_byte (row[i + 2], amount);
+                }
+        } else {
+                for (; i < n_bytes; i++)
+                        row[i] = shade_byte (row[i], amount);
+        }
+}
+
+void
+cc_crop_shade_pixels (guchar *pixels,
+                      gint    width,
+                      gint    height,
+                      gint    rowstride,
+                      gint    n_channels,
+                      guchar  amount)
+{
+        gint y;
+
+        g_return_if_fail (n_channels == 3 || n_channels == 4);
+
+        for (y = 0; y < height; y++)
+                shade_row (pixels + (gsize) y * rowstride, width, n_channels, amount);
+}
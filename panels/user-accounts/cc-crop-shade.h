@@ -0,0 +1,35 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*-
+ *
+ * Copyright 2017  Red Hat, Inc,
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __CC_CROP_SHADE_H__
+#define __CC_CROP_SHADE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+void cc_crop_shade_pixels (guchar *pixels,
+                           gint    width,
+                           gint    height,
+                           gint    rowstride,
+                           gint    n_channels,
+                           guchar  amount);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,134 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*-
+ *
+ * Copyright 2017  Red Hat, Inc,
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "cc-crop-shade.h"
+
+/* A 24 megapixel camera photo */
+#define BENCH_WIDTH 6000
+#define BENCH_HEIGHT 4000
+
+#define AMOUNT 32
+
+/* The per-pixel loop the crop area used before */
+static void
+shade_pixels_reference (guchar *pixels,
+                        gint    width,
+                        gint    height,
+                        gint    rowstride,
+                        gint    n_channels,
+                        guchar  amount)
+{
+        gint x, y, c;
+
+        for (y = 0; y < height; y++) {
+                for (x = 0; x < width; x++) {
+                        guchar *p = pixels + y * rowstride + x * n_channels;
+
+                        for (c = 0; c < 3; c++)
+                                p[c] = CLAMP (p[c] - amount, 0, 255);
+                }
+        }
+}
+
+static guchar *
+create_pixels (gint width,
+               gint height,
+               gint rowstride)
+{
+        guchar *pixels;
+        gsize i, size;
+
+        size = (gsize) rowstride * height;
+        pixels = g_malloc (size);
+        for (i = 0; i < size; i++)
+                pixels[i] = (i * 7 + i / 13) & 0xff;
+
+        return pixels;
+}
+
+static void
+test_matches_reference (void)
+{
+        const gint widths[] = { 1, 5, 16, 17, 333 };
+        gint n_channels;
+        guint i;
+
+        for (n_channels = 3; n_channels <= 4; n_channels++) {
+                for (i = 0; i < G_N_ELEMENTS (widths); i++) {
+                        gint width = widths[i];
+                        gint height = 7;
+                        /* Padding at the end of the rows must not be touched */
+                        gint rowstride = width * n_channels + 5;
+                        gsize size = (gsize) rowstride * height;
+                        guchar *pixels, *expected;
+
+                        pixels = create_pixels (width, height, rowstride);
+                        expected = g_memdup (pixels, size);
+
+                        cc_crop_shade_pixels (pixels, width, height, rowstride, n_channels, AMOUNT);
+                        shade_pixels_reference (expected, width, height, rowstride, n_channels, AMOUNT);
+                        g_assert_cmpint (memcmp (pixels, expected, size), ==, 0);
+
+                        g_free (pixels);
+                        g_free (expected);
+                }
+        }
+}
+
+static void
+test_benchmark (void)
+{
+        gint rowstride = BENCH_WIDTH * 4;
+        guchar *pixels;
+        GTimer *timer;
+        gdouble reference, elapsed;
+
+        pixels = create_pixels (BENCH_WIDTH, BENCH_HEIGHT, rowstride);
+        timer = g_timer_new ();
+
+        shade_pixels_reference (pixels, BENCH_WIDTH, BENCH_HEIGHT, rowstride, 4, AMOUNT);
+        reference = g_timer_elapsed (timer, NULL);
+
+        g_timer_start (timer);
+        cc_crop_shade_pixels (pixels, BENCH_WIDTH, BENCH_HEIGHT, rowstride, 4, AMOUNT);
+        elapsed = g_timer_elapsed (timer, NULL);
+
+        g_test_message ("Per-pixel loop: %.1f ms", reference * 1000);
+        g_test_minimized_result (elapsed * 1000, "Shaded %d×%d pixels in %.1f ms",
+                                 BENCH_WIDTH, BENCH_HEIGHT, elapsed * 1000);
+
+        g_timer_destroy (timer);
+        g_free (pixels);
+}
+
+int
+main (int argc, char **argv)
+{
+        g_test_init (&argc, &argv, NULL);
+
+        g_test_add_func ("/user-accounts/crop-shade/matches-reference", test_matches_reference);
+        g_test_add_func ("/user-accounts/crop-shade/benchmark", test_benchmark);
+
+        return g_test_run ();
+}
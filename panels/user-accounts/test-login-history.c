@@ -0,0 +1,230 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*-
+ *
+ * Copyright 2017  Red Hat, Inc,
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include "um-login-history.h"
+
+#define WEEK (G_TIME_SPAN_DAY * 7 / G_USEC_PER_SEC)
+#define HOUR (G_TIME_SPAN_HOUR / G_USEC_PER_SEC)
+#define N_RECORDS 100000
+
+/* Arbitrary Monday, to start the synthetic history from */
+#define EPOCH 1388966400
+
+static const gchar *types[] = { ":0", "tty2", "pts/1", ":1" };
+
+/* About 100k sessions, four hours apart, over more than 45 years. Some
+ * sessions are still open, and some are remote ones that are not shown. */
+static GVariant *
+build_history (guint n_records)
+{
+        GVariantBuilder builder;
+        guint i;
+
+        g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(xxa{sv})"));
+        for (i = 0; i < n_records; i++) {
+                GVariantBuilder props;
+                gint64 login, logout;
+
+                login = EPOCH + (gint64) i * 4 * HOUR;
+                logout = (i % 97 == 0) ? 0 : login + (i % 5 + 1) * HOUR;
+
+                g_variant_builder_init (&props, G_VARIANT_TYPE ("a{sv}"));
+                g_variant_builder_add (&props, "{sv}", "type",
+                                       g_variant_new_string (types[i % G_N_ELEMENTS (types)]));
+                g_variant_builder_add (&builder, "(xx@a{sv})", login, logout,
+                                       g_variant_builder_end (&props));
+        }
+
+        return g_variant_builder_end (&builder);
+}
+
+/* What the history dialog used to compute, walking the whole variant */
+static GArray *
+get_events_reference (GVariant *variant,
+                      gint64    from,
+                      gint64    to)
+{
+        GArray *events;
+        gint i, n;
+
+        events = g_array_new (FALSE, FALSE, sizeof (UmLoginEvent));
+        n = g_variant_n_children (variant);
+
+        for (i = n - 1; i >= 0; i--) {
+                gint64 login;
+
+                g_variant_get_child (variant, i, "(xx@a{sv})", &login, NULL, NULL);
+                if (login < to)
+                        break;
+        }
+
+        for (; i >= 0; i--) {
+                const gchar *type = NULL;
+                gint64 login, logout;
+                GVariant *props;
+                UmLoginEvent event;
+
+                g_variant_get_child (variant, i, "(xx@a{sv})", &login, &logout, &props);
+                g_variant_lookup (props, "type", "&s", &type);
+
+                if (!g_str_has_prefix (type, ":") && !g_str_has_prefix (type, "tty")) {
+                        g_variant_unref (props);
+                        continue;
+                }
+                g_variant_unref (props);
+
+                if (logout > 0 && logout < from)
+                        break;
+
+                if (logout > 0 && logout < to) {
+                        event.type = UM_LOGIN_EVENT_SESSION_ENDED;
+                        event.time = logout;
+                        g_array_append_val (events, event);
+                }
+
+                if (login >= from) {
+                        event.type = UM_LOGIN_EVENT_SESSION_STARTED;
+                        event.time = login;
+                        g_array_append_val (events, event);
+                }
+        }
+
+        return events;
+}
+
+static void
+assert_events_equal (GArray *events,
+                     GArray *expected)
+{
+        guint i;
+
+        g_assert_cmpuint (events->len, ==, expected->len);
+        for (i = 0; i < events->len; i++) {
+                UmLoginEvent *a = &g_array_index (events, UmLoginEvent, i);
+                UmLoginEvent *b = &g_array_index (expected, UmLoginEvent, i);
+
+                g_assert_cmpint (a->type, ==, b->type);
+                g_assert_cmpint (a->time, ==, b->time);
+        }
+}
+
+static void
+test_week_events (void)
+{
+        GVariant *variant;
+        UmLoginHistory *history;
+        gint64 first_login;
+        gint64 week;
+
+        variant = g_variant_ref_sink (build_history (N_RECORDS / 10));
+        history = um_login_history_new (variant);
+
+        g_assert_true (um_login_history_get_first_login (history, &first_login));
+        g_assert_cmpint (first_login, ==, EPOCH);
+
+        /* Before, across and after the recorded period */
+        for (week = EPOCH - 2 * WEEK; week < EPOCH + 240 * WEEK; week += WEEK) {
+                GArray *events, *expected;
+
+                events = um_login_history_get_events (history, week, week + WEEK);
+                expected = get_events_reference (variant, week, week + WEEK);
+                assert_events_equal (events, expected);
+
+                g_array_free (events, TRUE);
+                g_array_free (expected, TRUE);
+        }
+
+        um_login_history_free (history);
+        g_variant_unref (variant);
+}
+
+static void
+test_unsorted (void)
+{
+        GVariant *variant;
+        UmLoginHistory *history;
+        GArray *events;
+        gint64 first_login;
+
+        variant = g_variant_new_parsed ("[(@x 2000, @x 2100, {'type': <':0'>}),"
+                                        " (1000, 1100, {'type': <'tty2'>})]");
+        history = um_login_history_new (variant);
+
+        g_assert_true (um_login_history_get_first_login (history, &first_login));
+        g_assert_cmpint (first_login, ==, 1000);
+
+        events = um_login_history_get_events (history, 0, 3000);
+        g_assert_cmpuint (events->len, ==, 4);
+        g_assert_cmpint (g_array_index (events, UmLoginEvent, 0).time, ==, 2100);
+        g_assert_cmpint (g_array_index (events, UmLoginEvent, 3).time, ==, 1000);
+        g_array_free (events, TRUE);
+
+        um_login_history_free (history);
+}
+
+static void
+test_navigation_perf (void)
+{
+        GVariant *variant;
+        UmLoginHistory *history;
+        GTimer *timer;
+        gint64 week, last;
+        guint n_weeks = 0;
+        gdouble elapsed;
+
+        variant = build_history (N_RECORDS);
+
+        timer = g_timer_new ();
+        history = um_login_history_new (variant);
+        g_test_message ("Parsed %d records in %.1f ms",
+                        N_RECORDS, g_timer_elapsed (timer, NULL) * 1000);
+
+        /* Click through every week, from the most recent one back */
+        last = EPOCH + (gint64) N_RECORDS * 4 * HOUR;
+        g_timer_start (timer);
+        for (week = last; week > EPOCH; week -= WEEK) {
+                GArray *events;
+
+                events = um_login_history_get_events (history, week, week + WEEK);
+                g_array_free (events, TRUE);
+                n_weeks++;
+        }
+        elapsed = g_timer_elapsed (timer, NULL);
+
+        g_test_minimized_result (elapsed * G_USEC_PER_SEC / n_weeks,
+                                 "%.1f µs per week", elapsed * G_USEC_PER_SEC / n_weeks);
+
+        g_timer_destroy (timer);
+        um_login_history_free (history);
+}
+
+int
+main (int argc, char **argv)
+{
+        g_test_init (&argc, &argv, NULL);
+
+        g_test_add_func ("/user-accounts/login-history/week-events", test_week_events);
+        g_test_add_func ("/user-accounts/login-history/unsorted", test_unsorted);
+        g_test_add_func ("/user-accounts/login-history/navigation-perf", test_navigation_perf);
+
+        return g_test_run ();
+}
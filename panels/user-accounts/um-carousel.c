@@ -58,7 +58,6 @@ struct _UmCarousel {
         GList *children;
         gint visible_page;
         UmCarouselItem *selected_item;
-        GtkWidget *last_box;
         GtkWidget *arrow;
         gint arrow_start_x;
 
@@ -270,38 +269,187 @@ um_carousel_goto_next_page (GtkWidget *button,
 }
 
 static void
-um_carousel_add (GtkContainer *container,
-                 GtkWidget    *widget)
+um_carousel_setup_item (UmCarousel *self,
+                        GtkWidget  *widget)
 {
-        UmCarousel *self = UM_CAROUSEL (container);
-        gboolean last_box_is_full;
-
-        if (!UM_IS_CAROUSEL_ITEM (widget)) {
-                GTK_CONTAINER_CLASS (um_carousel_parent_class)->add (container, widget);
-                return;
-        }
+        GtkRadioButton *group_source = NULL;
 
         gtk_style_context_add_class (gtk_widget_get_style_context (widget), "menu");
         gtk_button_set_relief (GTK_BUTTON (widget), GTK_RELIEF_NONE);
 
-        self->children = g_list_append (self->children, widget);
-        UM_CAROUSEL_ITEM (widget)->page = get_last_page_number (self);
         if (self->selected_item != NULL)
-                gtk_radio_button_join_group (GTK_RADIO_BUTTON (widget), GTK_RADIO_BUTTON (self->selected_item));
+                group_source = GTK_RADIO_BUTTON (self->selected_item);
+        else if (self->children != NULL)
+                group_source = GTK_RADIO_BUTTON (self->children->data);
+
+        if (group_source != NULL)
+                gtk_radio_button_join_group (GTK_RADIO_BUTTON (widget), group_source);
         g_signal_connect (widget, "button-press-event", G_CALLBACK (on_item_toggled), self);
+}
+
+static GtkWidget *
+get_page_box (UmCarousel *self,
+              gint        page)
+{
+        GtkWidget *box;
+        gchar *page_name;
+
+        page_name = g_strdup_printf ("%d", page);
+        box = gtk_stack_get_child_by_name (self->stack, page_name);
+        if (box == NULL) {
+                box = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
+                gtk_widget_set_valign (box, GTK_ALIGN_CENTER);
+                gtk_stack_add_named (self->stack, box, page_name);
+                gtk_widget_show (box);
+        }
+        g_free (page_name);
+
+        return box;
+}
+
+/* Puts @widget in the box of @page, at @position within that page */
+static void
+um_carousel_pack_item (UmCarousel *self,
+                       GtkWidget  *widget,
+                       gint        page,
+                       gint        position)
+{
+        GtkWidget *box;
+        GtkWidget *parent;
+
+        box = get_page_box (self, page);
+        parent = gtk_widget_get_parent (widget);
+
+        g_object_ref (widget);
+        if (parent != NULL)
+                gtk_container_remove (GTK_CONTAINER (parent), widget);
+        gtk_box_pack_start (GTK_BOX (box), widget, TRUE, FALSE, 10);
+        gtk_box_reorder_child (GTK_BOX (box), widget, position);
+        gtk_widget_show_all (widget);
+        g_object_unref (widget);
+
+        UM_CAROUSEL_ITEM (widget)->page = page;
+}
+
+static void
+um_carousel_update_visible_page (UmCarousel *self)
+{
+        if (self->selected_item != NULL)
+                self->visible_page = self->selected_item->page;
+        self->visible_page = CLAMP (self->visible_page, 0, get_last_page_number (self));
+
+        if (self->children != NULL) {
+                gchar *page_name;
+
+                page_name = g_strdup_printf ("%d", self->visible_page);
+                gtk_stack_set_visible_child_name (self->stack, page_name);
+                g_free (page_name);
+        }
+
+        update_buttons_visibility (self);
+}
+
+/* Inserts @item in the list of children and packs it at its page. Only
+ * the first item of each following page has to move, from the end of
+ * the previous page. */
+static void
+um_carousel_link_item (UmCarousel     *self,
+                       UmCarouselItem *item,
+                       gint            position)
+{
+        gint n_children;
+        gint page;
+
+        n_children = g_list_length (self->children);
+        if (position < 0 || position > n_children)
+                position = n_children;
+
+        self->children = g_list_insert (self->children, item, position);
+        n_children++;
+
+        um_carousel_pack_item (self, GTK_WIDGET (item),
+                               position / ITEMS_PER_PAGE,
+                               position % ITEMS_PER_PAGE);
+
+        for (page = position / ITEMS_PER_PAGE + 1;
+             page * ITEMS_PER_PAGE < n_children;
+             page++) {
+                um_carousel_pack_item (self,
+                                       g_list_nth_data (self->children, page * ITEMS_PER_PAGE),
+                                       page, 0);
+        }
+}
+
+/* Takes @item out of the list of children and out of its page, without
+ * destroying it. The first item of each following page moves to the end
+ * of the previous page, and the last page goes away once it is empty. */
+static void
+um_carousel_unlink_item (UmCarousel     *self,
+                         UmCarouselItem *item)
+{
+        GtkWidget *parent;
+        gint position;
+        gint n_children;
+        gint page;
+
+        position = g_list_index (self->children, item);
+        self->children = g_list_remove (self->children, item);
+        n_children = g_list_length (self->children);
 
-        last_box_is_full = ((g_list_length (self->children) - 1) % ITEMS_PER_PAGE == 0);
-        if (last_box_is_full) {
-                gchar *page;
+        parent = gtk_widget_get_parent (GTK_WIDGET (item));
+        if (parent != NULL)
+                gtk_container_remove (GTK_CONTAINER (parent), GTK_WIDGET (item));
 
-                page = g_strdup_printf ("%d", UM_CAROUSEL_ITEM (widget)->page);
-                self->last_box = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
-                gtk_widget_set_valign (self->last_box, GTK_ALIGN_CENTER);
-                gtk_stack_add_named (self->stack, self->last_box, page);
+        for (page = position / ITEMS_PER_PAGE;
+             (page + 1) * ITEMS_PER_PAGE <= n_children;
+             page++) {
+                um_carousel_pack_item (self,
+                                       g_list_nth_data (self->children, (page + 1) * ITEMS_PER_PAGE - 1),
+                                       page, ITEMS_PER_PAGE - 1);
         }
 
-        gtk_box_pack_start (GTK_BOX (self->last_box), widget, TRUE, FALSE, 10);
-        gtk_widget_show_all (self->last_box);
+        if (n_children % ITEMS_PER_PAGE == 0) {
+                gchar *page_name;
+                GtkWidget *box;
+
+                page_name = g_strdup_printf ("%d", n_children / ITEMS_PER_PAGE);
+                box = gtk_stack_get_child_by_name (self->stack, page_name);
+                if (box != NULL)
+                        gtk_widget_destroy (box);
+                g_free (page_name);
+        }
+}
+
+static void
+um_carousel_add (GtkContainer *container,
+                 GtkWidget    *widget)
+{
+        UmCarousel *self = UM_CAROUSEL (container);
+
+        if (!UM_IS_CAROUSEL_ITEM (widget)) {
+                GTK_CONTAINER_CLASS (um_carousel_parent_class)->add (container, widget);
+                return;
+        }
+
+        um_carousel_insert_item (self, UM_CAROUSEL_ITEM (widget), -1);
+}
+
+/**
+ * um_carousel_insert_item:
+ * @carousel: an UmCarousel instance
+ * @item: the UmCarouselItem to insert
+ * @position: the position to insert @item at, or -1 to append it
+ *
+ * Inserts @item at @position, moving the following items to the next
+ * page as needed.
+ */
+void
+um_carousel_insert_item (UmCarousel     *self,
+                         UmCarouselItem *item,
+                         gint            position)
+{
+        um_carousel_setup_item (self, GTK_WIDGET (item));
+        um_carousel_link_item (self, item, position);
 
         update_buttons_visibility (self);
 
@@ -310,6 +458,57 @@ um_carousel_add (GtkContainer *container,
                 um_carousel_select_item_at_index (self, 0);
 }
 
+/**
+ * um_carousel_move_item:
+ * @carousel: an UmCarousel instance
+ * @item: the UmCarouselItem to move
+ * @position: the new position of @item
+ *
+ * Moves @item to @position, keeping it and its selection state.
+ */
+void
+um_carousel_move_item (UmCarousel     *self,
+                       UmCarouselItem *item,
+                       gint            position)
+{
+        g_return_if_fail (g_list_find (self->children, item) != NULL);
+
+        if (g_list_index (self->children, item) == position)
+                return;
+
+        g_object_ref (item);
+        um_carousel_unlink_item (self, item);
+        um_carousel_link_item (self, item, position);
+        g_object_unref (item);
+
+        um_carousel_update_visible_page (self);
+}
+
+/**
+ * um_carousel_remove_item:
+ * @carousel: an UmCarousel instance
+ * @item: the UmCarouselItem to remove
+ *
+ * Destroys @item, and moves the following items to the previous page as
+ * needed.
+ */
+void
+um_carousel_remove_item (UmCarousel     *self,
+                         UmCarouselItem *item)
+{
+        g_return_if_fail (g_list_find (self->children, item) != NULL);
+
+        if (self->selected_item == item)
+                self->selected_item = NULL;
+
+        g_object_ref (item);
+        um_carousel_unlink_item (self, item);
+        gtk_widget_destroy (GTK_WIDGET (item));
+        g_object_unref (item);
+
+        um_carousel_update_visible_page (self);
+}
+
 void
 um_carousel_purge_items (UmCarousel *self)
 {
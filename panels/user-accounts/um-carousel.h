@@ -39,6 +39,17 @@ UmCarousel      *um_carousel_new         (void);
 
 void             um_carousel_purge_items (UmCarousel     *self);
 
+void             um_carousel_insert_item (UmCarousel     *self,
+                                          UmCarouselItem *item,
+                                          gint            position);
+
+void             um_carousel_move_item   (UmCarousel     *self,
+                                          UmCarouselItem *item,
+                                          gint            position);
+
+void             um_carousel_remove_item (UmCarousel     *self,
+                                          UmCarouselItem *item);
+
 UmCarouselItem  *um_carousel_find_item   (UmCarousel     *self,
                                           gconstpointer   data,
                                           GCompareFunc    func);
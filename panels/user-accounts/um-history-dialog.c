@@ -33,6 +33,7 @@
 #include "cc-util.h"
 
 #include "um-history-dialog.h"
+#include "um-login-history.h"
 #include "um-utils.h"
 
 struct _UmHistoryDialog {
@@ -43,14 +44,9 @@ struct _UmHistoryDialog {
         GDateTime *current_week;
 
         ActUser *user;
+        UmLoginHistory *login_history;
 };
 
-typedef struct {
-	gint64 login_time;
-	gint64 logout_time;
-	const gchar *type;
-} UmLoginHistory;
-
 static GtkWidget *
 get_widget (UmHistoryDialog *um,
             const char *name)
@@ -116,48 +112,37 @@ clear_history (UmHistoryDialog *um)
         g_list_free (list);
 }
 
-static GArray *
-get_login_history (ActUser *user)
+static UmLoginHistory *
+get_login_history (UmHistoryDialog *um)
 {
-	GArray *login_history;
-	GVariantIter *iter, *iter2;
-	GVariant *variant;
-	const GVariant *value;
-	const gchar *key;
-	UmLoginHistory history;
-
-	login_history = NULL;
-	value = act_user_get_login_history (user);
-	g_variant_get ((GVariant *) value, "a(xxa{sv})", &iter);
-	while (g_variant_iter_loop (iter, "(xxa{sv})", &history.login_time, &history.logout_time, &iter2)) {
-		while (g_variant_iter_loop (iter2, "{sv}", &key, &variant)) {
-			if (g_strcmp0 (key, "type") == 0) {
-				history.type = g_variant_get_string (variant, NULL);
-			}
-		}
-
-		if (login_history == NULL) {
-			login_history = g_array_new (FALSE, TRUE, sizeof (UmLoginHistory));
-		}
-
-		g_array_append_val (login_history, history);
-	}
-
-	return login_history;
+        GVariant *variant;
+
+        variant = (GVariant *) act_user_get_login_history (um->user);
+        if (variant == NULL)
+                return NULL;
+
+        /* Only parse the history again when accountsservice updated it */
+        if (um->login_history != NULL &&
+            um_login_history_get_variant (um->login_history) != variant)
+                g_clear_pointer (&um->login_history, um_login_history_free);
+
+        if (um->login_history == NULL)
+                um->login_history = um_login_history_new (variant);
+
+        return um->login_history;
 }
 
 static void
 set_sensitivity (UmHistoryDialog *um)
 {
-        GArray *login_history;
-        UmLoginHistory history;
+        UmLoginHistory *login_history;
+        gint64 first_login;
         gboolean sensitive = FALSE;
 
-        login_history = get_login_history (um->user);
-        if (login_history != NULL) {
-                history = g_array_index (login_history, UmLoginHistory, 0);
-                sensitive = g_date_time_to_unix (um->week) > history.login_time;
-                g_array_free (login_history, TRUE);
+        login_history = get_login_history (um);
+        if (login_history != NULL &&
+            um_login_history_get_first_login (login_history, &first_login)) {
+                sensitive = g_date_time_to_unix (um->week) > first_login;
         }
         gtk_widget_set_sensitive (get_widget (um, "previous-button"), sensitive);
 
@@ -201,66 +186,43 @@ add_record (GtkWidget *box, GDateTime *datetime, gchar *record_string, gint line
 static void
 show_week (UmHistoryDialog *um)
 {
-        GArray *login_history;
+        UmLoginHistory *login_history;
+        GArray *events;
         GDateTime *datetime, *temp;
         gint64 from, to;
-        gint i, line;
+        guint i;
         GtkWidget *box;
-        UmLoginHistory history;
 
         show_week_label (um);
         clear_history (um);
         set_sensitivity (um);
 
-        login_history = get_login_history (um->user);
+        login_history = get_login_history (um);
         if (login_history == NULL) {
                 return;
         }
 
-        /* Find first record for week */
         from = g_date_time_to_unix (um->week);
         temp = g_date_time_add_weeks (um->week, 1);
         to = g_date_time_to_unix (temp);
         g_date_time_unref (temp);
-        for (i = login_history->len - 1; i >= 0; i--) {
-                history = g_array_index (login_history, UmLoginHistory, i);
-                if (history.login_time < to) {
-                        break;
-                }
-        }
 
         /* Add new session records */
         box = get_widget (um, "history-box");
-        line = 0;
-        for (;i >= 0; i--) {
-                history = g_array_index (login_history, UmLoginHistory, i);
-
-                /* Display only x-session and tty records */
-                if (!g_str_has_prefix (history.type, ":") &&
-                    !g_str_has_prefix (history.type, "tty")) {
-                        continue;
-                }
-
-                if (history.logout_time > 0 && history.logout_time < from) {
-                        break;
-                }
-
-                if (history.logout_time > 0 && history.logout_time < to) {
-                        datetime = g_date_time_new_from_unix_local (history.logout_time);
-                        add_record (box, datetime, _("Session Ended"), line);
-                        line++;
-                }
-
-                if (history.login_time >= from) {
-                        datetime = g_date_time_new_from_unix_local (history.login_time);
-                        add_record (box, datetime, _("Session Started"), line);
-                        line++;
-                }
+        events = um_login_history_get_events (login_history, from, to);
+        for (i = 0; i < events->len; i++) {
+                UmLoginEvent *event = &g_array_index (events, UmLoginEvent, i);
+
+                datetime = g_date_time_new_from_unix_local (event->time);
+                if (event->type == UM_LOGIN_EVENT_SESSION_ENDED)
+                        add_record (box, datetime, _("Session Ended"), i);
+                else
+                        add_record (box, datetime, _("Session Started"), i);
         }
 
         gtk_widget_show_all (box);
 
-        g_array_free (login_history, TRUE);
+        g_array_free (events, TRUE);
 }
 
 static void
@@ -311,6 +273,7 @@ um_history_dialog_set_user (UmHistoryDialog *um,
         if (um->user) {
                 g_clear_object (&um->user);
         }
+        g_clear_pointer (&um->login_history, um_login_history_free);
 
         if (user) {
                 um->user = g_object_ref (user);
@@ -397,6 +360,7 @@ um_history_dialog_free (UmHistoryDialog *um)
 
         g_clear_object (&um->user);
         g_clear_object (&um->builder);
+        g_clear_pointer (&um->login_history, um_login_history_free);
 
         if (um->week) {
                 g_date_time_unref (um->week);
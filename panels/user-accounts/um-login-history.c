@@ -0,0 +1,193 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*-
+ *
+ * Copyright 2012  Red Hat, Inc,
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "um-login-history.h"
+
+typedef struct {
+        gint64 login_time;
+        gint64 logout_time;
+        const gchar *type;
+} UmLoginRecord;
+
+/* The LoginHistory property of an accountsservice user, parsed once into
+ * an array sorted by login time. The type strings point into @variant. */
+struct _UmLoginHistory {
+        GVariant *variant;
+        GArray *records;
+};
+
+static gint
+compare_records (gconstpointer a,
+                 gconstpointer b)
+{
+        const UmLoginRecord *ra = a;
+        const UmLoginRecord *rb = b;
+
+        if (ra->login_time < rb->login_time)
+                return -1;
+        if (ra->login_time > rb->login_time)
+                return 1;
+        return 0;
+}
+
+UmLoginHistory *
+um_login_history_new (GVariant *variant)
+{
+        UmLoginHistory *history;
+        GVariantIter iter, *props;
+        GVariant *value;
+        const gchar *key;
+        UmLoginRecord record;
+        gboolean sorted = TRUE;
+
+        g_return_val_if_fail (g_variant_is_of_type (variant, G_VARIANT_TYPE ("a(xxa{sv})")), NULL);
+
+        history = g_new0 (UmLoginHistory, 1);
+        history->variant = g_variant_ref_sink (variant);
+        history->records = g_array_sized_new (FALSE, TRUE, sizeof (UmLoginRecord),
+                                              g_variant_n_children (variant));
+
+        g_variant_iter_init (&iter, variant);
+        while (g_variant_iter_next (&iter, "(xxa{sv})", &record.login_time, &record.logout_time, &props)) {
+                record.type = "";
+                while (g_variant_iter_next (props, "{&sv}", &key, &value)) {
+                        if (g_strcmp0 (key, "type") == 0 &&
+                            g_variant_is_of_type (value, G_VARIANT_TYPE_STRING)) {
+                                /* The string lives as long as the history variant */
+                                record.type = g_variant_get_string (value, NULL);
+                        }
+                        g_variant_unref (value);
+                }
+                g_variant_iter_free (props);
+
+                if (history->records->len > 0 &&
+                    g_array_index (history->records, UmLoginRecord,
+                                   history->records->len - 1).login_time > record.login_time)
+                        sorted = FALSE;
+
+                g_array_append_val (history->records, record);
+        }
+
+        /* accountsservice sends the records in order, but don't rely on it */
+        if (!sorted)
+                g_array_sort (history->records, compare_records);
+
+        return history;
+}
+
+void
+um_login_history_free (UmLoginHistory *history)
+{
+        g_array_free (history->records, TRUE);
+        g_variant_unref (history->variant);
+        g_free (history);
+}
+
+GVariant *
+um_login_history_get_variant (UmLoginHistory *history)
+{
+        return history->variant;
+}
+
+gboolean
+um_login_history_get_first_login (UmLoginHistory *history,
+                                  gint64         *time)
+{
+        if (history->records->len == 0)
+                return FALSE;
+
+        *time = g_array_index (history->records, UmLoginRecord, 0).login_time;
+
+        return TRUE;
+}
+
+/* Returns the number of records that started before @time */
+static guint
+count_logins_before (UmLoginHistory *history,
+                     gint64          time)
+{
+        guint low = 0, high = history->records->len;
+
+        while (low < high) {
+                guint mid = low + (high - low) / 2;
+
+                if (g_array_index (history->records, UmLoginRecord, mid).login_time < time)
+                        low = mid + 1;
+                else
+                        high = mid;
+        }
+
+        return low;
+}
+
+static gboolean
+is_session_record (const UmLoginRecord *record)
+{
+        /* Display only x-session and tty records */
+        return g_str_has_prefix (record->type, ":") ||
+               g_str_has_prefix (record->type, "tty");
+}
+
+static void
+append_event (GArray           *events,
+              UmLoginEventType  type,
+              gint64            time)
+{
+        UmLoginEvent event = { type, time };
+
+        g_array_append_val (events, event);
+}
+
+/*
+ * Returns the session events between @from and @to, most recent first,
+ * as an array of UmLoginEvent.
+ */
+GArray *
+um_login_history_get_events (UmLoginHistory *history,
+                             gint64          from,
+                             gint64          to)
+{
+        GArray *events;
+        guint i;
+
+        events = g_array_new (FALSE, FALSE, sizeof (UmLoginEvent));
+
+        /* Walk back from the latest session started before the end of the
+         * range, until one ended before its beginning. */
+        for (i = count_logins_before (history, to); i > 0; i--) {
+                const UmLoginRecord *record;
+
+                record = &g_array_index (history->records, UmLoginRecord, i - 1);
+
+                if (!is_session_record (record))
+                        continue;
+
+                if (record->logout_time > 0 && record->logout_time < from)
+                        break;
+
+                if (record->logout_time > 0 && record->logout_time < to)
+                        append_event (events, UM_LOGIN_EVENT_SESSION_ENDED, record->logout_time);
+
+                if (record->login_time >= from)
+                        append_event (events, UM_LOGIN_EVENT_SESSION_STARTED, record->login_time);
+        }
+
+        return events;
+}
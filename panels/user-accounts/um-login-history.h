@@ -0,0 +1,49 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*-
+ *
+ * Copyright 2012  Red Hat, Inc,
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __UM_LOGIN_HISTORY_H__
+#define __UM_LOGIN_HISTORY_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _UmLoginHistory UmLoginHistory;
+
+typedef enum {
+        UM_LOGIN_EVENT_SESSION_STARTED,
+        UM_LOGIN_EVENT_SESSION_ENDED
+} UmLoginEventType;
+
+typedef struct {
+        UmLoginEventType type;
+        gint64 time;
+} UmLoginEvent;
+
+UmLoginHistory *um_login_history_new             (GVariant       *history);
+void            um_login_history_free            (UmLoginHistory *history);
+GVariant       *um_login_history_get_variant     (UmLoginHistory *history);
+gboolean        um_login_history_get_first_login (UmLoginHistory *history,
+                                                  gint64         *time);
+GArray         *um_login_history_get_events      (UmLoginHistory *history,
+                                                  gint64          from,
+                                                  gint64          to);
+
+G_END_DECLS
+
+#endif
@@ -208,7 +208,7 @@ create_carousel_entry (CcUserPanelPrivate *d, ActUser *user)
 }
 
 static void
-user_added (ActUserManager *um, ActUser *user, CcUserPanelPrivate *d)
+add_user_item (CcUserPanelPrivate *d, ActUser *user, gint position)
 {
         GtkWidget *item, *widget;
         gboolean show_carousel;
@@ -224,7 +224,10 @@ user_added (ActUserManager *um, ActUser *user, CcUserPanelPrivate *d)
         gtk_container_add (GTK_CONTAINER (item), widget);
 
         g_object_set_data (G_OBJECT (item), "uid", GINT_TO_POINTER (act_user_get_uid (user)));
-        gtk_container_add (GTK_CONTAINER (d->carousel), item);
+        if (position < 0)
+                gtk_container_add (GTK_CONTAINER (d->carousel), item);
+        else
+                um_carousel_insert_item (d->carousel, UM_CAROUSEL_ITEM (item), position);
 
         if (act_user_get_uid (user) != getuid ()) {
                 d->other_accounts++;
@@ -265,6 +268,33 @@ sort_users (gconstpointer a, gconstpointer b)
         return result;
 }
 
+/* Returns the position of @user in the sorted carousel */
+static gint
+get_user_position (CcUserPanelPrivate *d, ActUser *user)
+{
+        GSList *list, *l;
+        gint position = 0;
+
+        list = act_user_manager_list_users (d->um);
+        for (l = list; l; l = l->next) {
+                ActUser *other = l->data;
+
+                if (other == user || act_user_is_system_account (other))
+                        continue;
+                if (sort_users (other, user) < 0)
+                        position++;
+        }
+        g_slist_free (list);
+
+        return position;
+}
+
+static void
+user_added (ActUserManager *um, ActUser *user, CcUserPanelPrivate *d)
+{
+        add_user_item (d, user, get_user_position (d, user));
+}
+
 static void
 reload_users (CcUserPanelPrivate *d, ActUser *selected_user)
 {
@@ -290,7 +320,7 @@ reload_users (CcUserPanelPrivate *d, ActUser *selected_user)
         for (l = list; l; l = l->next) {
                 user = l->data;
                 g_debug ("adding user %s\n", get_real_or_user_name (user));
-                user_added (d->um, user, d);
+                add_user_item (d, user, -1);
         }
         g_slist_free (list);
 
@@ -305,18 +335,29 @@ reload_users (CcUserPanelPrivate *d, ActUser *selected_user)
 static void
 user_removed (ActUserManager *um, ActUser *user, CcUserPanelPrivate *d)
 {
+        UmCarouselItem *item;
         gboolean show_carousel;
 
-        d->other_accounts--;
+        item = um_carousel_find_item (d->carousel, user, user_compare);
+        if (item == NULL)
+                return;
+
+        um_carousel_remove_item (d->carousel, item);
+
+        if (act_user_get_uid (user) != getuid ()) {
+                d->other_accounts--;
+        }
         show_carousel = (d->other_accounts > 0);
         gtk_revealer_set_reveal_child (GTK_REVEALER (d->carousel),
                                        show_carousel);
 
-        reload_users (d, NULL);
-
         /* Show the current user */
         user = act_user_manager_get_user_by_id (d->um, getuid ());
-        show_user (user, d);
+        item = um_carousel_find_item (d->carousel, user, user_compare);
+        if (item != NULL)
+                um_carousel_select_item (d->carousel, item);
+        else
+                show_user (user, d);
 }
 
 static gint
@@ -342,10 +383,26 @@ user_compare (gconstpointer i,
 static void
 user_changed (ActUserManager *um, ActUser *user, CcUserPanelPrivate *d)
 {
-        if (act_user_get_uid (user) != act_user_get_uid (d->selected_user))
+        UmCarouselItem *item;
+        GtkWidget *entry;
+
+        item = um_carousel_find_item (d->carousel, user, user_compare);
+        if (item == NULL)
                 return;
 
-        reload_users (d, user);
+        /* Only the entry of the changed user is updated, and the item
+         * moved if its name now sorts elsewhere */
+        entry = gtk_bin_get_child (GTK_BIN (item));
+        if (entry != NULL)
+                gtk_widget_destroy (entry);
+        gtk_container_add (GTK_CONTAINER (item), create_carousel_entry (d, user));
+        gtk_widget_show_all (GTK_WIDGET (item));
+
+        um_carousel_move_item (d->carousel, item, get_user_position (d, user));
+
+        if (d->selected_user != NULL &&
+            act_user_get_uid (user) == act_user_get_uid (d->selected_user))
+                show_user (user, d);
 }
 
 static void
@@ -355,6 +412,7 @@ select_created_user (GObject *object,
 {
         CcUserPanelPrivate *d = user_data;
         UmAccountDialog *dialog;
+        UmCarouselItem *item;
         ActUser *user;
 
         dialog = UM_ACCOUNT_DIALOG (object);
@@ -365,7 +423,11 @@ select_created_user (GObject *object,
         if (user == NULL)
                 return;
 
-        reload_users (d, user);
+        item = um_carousel_find_item (d->carousel, user, user_compare);
+        if (item != NULL)
+                um_carousel_select_item (d->carousel, item);
+        else
+                reload_users (d, user);
 }
 
 static void
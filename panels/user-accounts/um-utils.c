@@ -861,6 +861,50 @@ logged_in_pixbuf (GdkPixbuf *pixbuf, gint scale)
 
 #define MAX_FILE_SIZE     65536
 
+/* Rendered avatars, keyed on the icon file, its modification time and
+ * size, and the rendering parameters */
+#define ICON_CACHE_MAX_ENTRIES 256
+
+static GHashTable *icon_cache = NULL;
+
+static void
+on_icon_theme_changed (GtkIconTheme *theme,
+                       gpointer      user_data)
+{
+        g_hash_table_remove_all (icon_cache);
+}
+
+static GHashTable *
+get_icon_cache (void)
+{
+        if (icon_cache == NULL) {
+                icon_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                    g_free, (GDestroyNotify) cairo_surface_destroy);
+                g_signal_connect (gtk_icon_theme_get_default (), "changed",
+                                  G_CALLBACK (on_icon_theme_changed), NULL);
+        }
+
+        return icon_cache;
+}
+
+static gchar *
+get_icon_cache_key (const gchar *icon_file,
+                    UmIconStyle  style,
+                    gint         icon_size,
+                    gint         scale)
+{
+        GStatBuf fileinfo;
+
+        if (icon_file == NULL || g_stat (icon_file, &fileinfo) < 0)
+                return g_strdup_printf (":%d:%d:%d", style, icon_size, scale);
+
+        return g_strdup_printf ("%s:%" G_GINT64_FORMAT ":%" G_GINT64_FORMAT ":%d:%d:%d",
+                                icon_file,
+                                (gint64) fileinfo.st_mtime,
+                                (gint64) fileinfo.st_size,
+                                style, icon_size, scale);
+}
+
 cairo_surface_t *
 render_user_icon (ActUser     *user,
                   UmIconStyle  style,
@@ -872,12 +916,27 @@ render_user_icon (ActUser     *user,
         gboolean      res;
         GError       *error;
         const gchar  *icon_file;
+        GHashTable   *cache;
+        gchar        *key;
         cairo_surface_t *surface = NULL;
 
         g_return_val_if_fail (ACT_IS_USER (user), NULL);
         g_return_val_if_fail (icon_size > 12, NULL);
 
+        /* The status emblem only depends on whether the user is logged in */
+        if (!act_user_is_logged_in (user))
+                style &= ~UM_ICON_STYLE_STATUS;
+
         icon_file = act_user_get_icon_file (user);
+
+        cache = get_icon_cache ();
+        key = get_icon_cache_key (icon_file, style, icon_size, scale);
+        surface = g_hash_table_lookup (cache, key);
+        if (surface != NULL) {
+                g_free (key);
+                return cairo_surface_reference (surface);
+        }
+
         pixbuf = NULL;
         if (icon_file) {
                 res = check_user_file (icon_file, MAX_FILE_SIZE);
@@ -918,7 +977,7 @@ render_user_icon (ActUser     *user,
                 }
         }
 
-        if (pixbuf != NULL && (style & UM_ICON_STYLE_STATUS) && act_user_is_logged_in (user)) {
+        if (pixbuf != NULL && (style & UM_ICON_STYLE_STATUS)) {
                 framed = logged_in_pixbuf (pixbuf, scale);
                 if (framed != NULL) {
                         g_object_unref (pixbuf);
@@ -931,6 +990,14 @@ render_user_icon (ActUser     *user,
                 g_object_unref (pixbuf);
         }
 
+        if (surface != NULL) {
+                if (g_hash_table_size (cache) >= ICON_CACHE_MAX_ENTRIES)
+                        g_hash_table_remove_all (cache);
+                g_hash_table_insert (cache, key, cairo_surface_reference (surface));
+        } else {
+                g_free (key);
+        }
+
         return surface;
 }
 
@@ -59,6 +59,7 @@ struct _CcWacomPanelPrivate
 	GsdDeviceManager *manager;
 	guint             device_added_id;
 	guint             device_removed_id;
+	guint             shell_event_id;
 
 	CcTabletToolMap  *tablet_tool_map;
 
@@ -420,8 +421,9 @@ cc_wacom_panel_constructed (GObject *object)
 				priv->test_popover, "visible",
 				G_BINDING_BIDIRECTIONAL);
 
-	g_signal_connect_object (shell, "event",
-				 G_CALLBACK (on_shell_event_cb), self, 0);
+	priv->shell_event_id =
+		g_signal_connect_object (shell, "event",
+					 G_CALLBACK (on_shell_event_cb), self, 0);
 }
 
 static const char *
@@ -438,6 +440,23 @@ cc_wacom_panel_get_title_widget (CcPanel *panel)
 	return priv->switcher;
 }
 
+/* No need to follow the tools in use while the panel is cached */
+static void
+cc_wacom_panel_suspend (CcPanel *panel)
+{
+	CcWacomPanelPrivate *priv = CC_WACOM_PANEL (panel)->priv;
+
+	g_signal_handler_block (cc_panel_get_shell (panel), priv->shell_event_id);
+}
+
+static void
+cc_wacom_panel_resume (CcPanel *panel)
+{
+	CcWacomPanelPrivate *priv = CC_WACOM_PANEL (panel)->priv;
+
+	g_signal_handler_unblock (cc_panel_get_shell (panel), priv->shell_event_id);
+}
+
 static void
 cc_wacom_panel_class_init (CcWacomPanelClass *klass)
 {
@@ -453,6 +472,8 @@ cc_wacom_panel_class_init (CcWacomPanelClass *klass)
 
 	panel_class->get_help_uri = cc_wacom_panel_get_help_uri;
 	panel_class->get_title_widget = cc_wacom_panel_get_title_widget;
+	panel_class->suspend = cc_wacom_panel_suspend;
+	panel_class->resume = cc_wacom_panel_resume;
 
 	g_object_class_override_property (object_class, PROP_PARAMETERS, "parameters");
 }
@@ -50,6 +50,7 @@ struct CcPanelPrivate
   gchar    *current_location;
 
   gboolean  is_active;
+  gboolean  is_suspended;
   CcShell  *shell;
 };
 
@@ -291,3 +292,45 @@ cc_panel_get_title_widget (CcPanel *panel)
 
   return NULL;
 }
+
+/**
+ * cc_panel_suspend:
+ * @panel: A #CcPanel
+ *
+ * Called by the shell when the panel is hidden but kept around to be shown
+ * again later. Panels should stop any polling or monitoring until
+ * cc_panel_resume() is called.
+ */
+void
+cc_panel_suspend (CcPanel *panel)
+{
+  CcPanelClass *class = CC_PANEL_GET_CLASS (panel);
+
+  if (panel->priv->is_suspended)
+    return;
+
+  panel->priv->is_suspended = TRUE;
+
+  if (class->suspend)
+    class->suspend (panel);
+}
+
+/**
+ * cc_panel_resume:
+ * @panel: A #CcPanel
+ *
+ * Called by the shell when a suspended panel is shown again.
+ */
+void
+cc_panel_resume (CcPanel *panel)
+{
+  CcPanelClass *class = CC_PANEL_GET_CLASS (panel);
+
+  if (!panel->priv->is_suspended)
+    return;
+
+  panel->priv->is_suspended = FALSE;
+
+  if (class->resume)
+    class->resume (panel);
+}
@@ -80,6 +80,9 @@ struct _CcPanelClass
   const char  * (* get_help_uri)   (CcPanel *panel);
 
   GtkWidget *   (* get_title_widget) (CcPanel *panel);
+
+  void          (* suspend)          (CcPanel *panel);
+  void          (* resume)           (CcPanel *panel);
 };
 
 GType        cc_panel_get_type         (void);
@@ -92,6 +95,10 @@ const char  *cc_panel_get_help_uri     (CcPanel     *panel);
 
 GtkWidget   *cc_panel_get_title_widget (CcPanel     *panel);
 
+void         cc_panel_suspend          (CcPanel     *panel);
+
+void         cc_panel_resume           (CcPanel     *panel);
+
 G_END_DECLS
 
 #endif /* __CC_PANEL_H */
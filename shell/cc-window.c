@@ -53,6 +53,10 @@
 #define DEFAULT_WINDOW_TITLE N_("All Settings")
 #define DEFAULT_WINDOW_ICON_NAME "preferences-system"
 
+/* Number of panels kept around after being hidden, so that going back to
+ * them doesn't need them to be constructed and loaded again */
+#define PANEL_CACHE_SIZE 3
+
 #define SEARCH_PAGE "_search"
 #define OVERVIEW_PAGE "_overview"
 
@@ -81,6 +85,11 @@ struct _CcWindow
   GtkWidget  *current_panel;
   char       *current_panel_id;
   GQueue     *previous_panels;
+  GQueue     *panel_cache; /* CachedPanel, most recently used first */
+
+  gint64      panel_activation_time;
+  gboolean    panel_from_cache;
+  gulong      first_frame_id;
 
   GtkSizeGroup *header_sizegroup;
 
@@ -117,6 +126,18 @@ static gboolean cc_window_set_active_panel_from_id (CcShell      *shell,
 
 static gint get_monitor_height (CcWindow *self);
 
+static void _shell_embed_widget_in_header (CcShell   *shell,
+                                           GtkWidget *widget);
+
+typedef struct
+{
+  gchar     *id;
+  GtkWidget *box;
+  CcPanel   *panel;
+  GPtrArray *custom_widgets;
+  GtkWidget *title_widget;
+} CachedPanel;
+
 static const gchar *
 get_icon_name_from_g_icon (GIcon *gicon)
 {
@@ -139,6 +160,103 @@ get_icon_name_from_g_icon (GIcon *gicon)
   return NULL;
 }
 
+static void
+cached_panel_free (CachedPanel *cached)
+{
+  g_debug ("Dropping panel '%s' from the cache", cached->id);
+
+  /* The panel may still refer to its header widgets while destroyed */
+  gtk_widget_destroy (cached->box);
+  g_object_unref (cached->box);
+  g_ptr_array_unref (cached->custom_widgets);
+  g_clear_object (&cached->title_widget);
+  g_free (cached->id);
+  g_slice_free (CachedPanel, cached);
+}
+
+static CachedPanel *
+take_cached_panel (CcWindow    *self,
+                   const gchar *id)
+{
+  GList *l;
+
+  for (l = self->panel_cache->head; l != NULL; l = l->next)
+    {
+      CachedPanel *cached = l->data;
+
+      if (g_strcmp0 (cached->id, id) == 0)
+        {
+          g_queue_delete_link (self->panel_cache, l);
+          return cached;
+        }
+    }
+
+  return NULL;
+}
+
+/* Takes over the panel box, which is removed from the stack, and the
+ * header widgets of the panel. The header bar only holds the title
+ * widget while it shows it, so it is kept alive with the panel. */
+static void
+cache_panel (CcWindow    *self,
+             const gchar *id,
+             GtkWidget   *box,
+             GtkWidget   *panel,
+             GPtrArray   *custom_widgets,
+             GtkWidget   *title_widget)
+{
+  CachedPanel *cached;
+
+  cached = g_slice_new0 (CachedPanel);
+  cached->id = g_strdup (id);
+  cached->box = g_object_ref (box);
+  cached->panel = CC_PANEL (panel);
+  cached->custom_widgets = custom_widgets;
+  cached->title_widget = title_widget;
+
+  gtk_container_remove (GTK_CONTAINER (self->stack), box);
+  cc_panel_suspend (cached->panel);
+
+  g_queue_push_head (self->panel_cache, cached);
+  while (g_queue_get_length (self->panel_cache) > PANEL_CACHE_SIZE)
+    cached_panel_free (g_queue_pop_tail (self->panel_cache));
+}
+
+static gboolean
+panel_first_frame_cb (GtkWidget *panel,
+                      cairo_t   *cr,
+                      CcWindow  *self)
+{
+  gdouble elapsed;
+
+  elapsed = (g_get_monotonic_time () - self->panel_activation_time) / 1000.0;
+
+  /* The fields can be collected from the journal, to compare panels
+   * that were constructed with the ones that came from the cache */
+  g_log_structured (G_LOG_DOMAIN, G_LOG_LEVEL_DEBUG,
+                    "CC_PANEL_ID", "%s", self->current_panel_id,
+                    "CC_PANEL_FROM_CACHE", "%d", self->panel_from_cache,
+                    "CC_PANEL_FIRST_FRAME_MS", "%.1f", elapsed,
+                    "MESSAGE", "Panel '%s' drew its first frame %.1f ms after being %s",
+                    self->current_panel_id, elapsed,
+                    self->panel_from_cache ? "taken from the cache" : "constructed");
+
+  g_signal_handler_disconnect (panel, self->first_frame_id);
+  self->first_frame_id = 0;
+
+  return FALSE;
+}
+
+static void
+stop_first_frame_timing (CcWindow *self)
+{
+  if (self->first_frame_id == 0)
+    return;
+
+  g_signal_handler_disconnect (self->current_panel, self->first_frame_id);
+  self->first_frame_id = 0;
+}
+
 static gboolean
 activate_panel (CcWindow           *self,
                 const gchar        *id,
@@ -147,25 +265,74 @@ activate_panel (CcWindow           *self,
                 GIcon              *gicon)
 {
   GtkWidget *box, *title_widget;
+  GtkWidget *cached_title_widget = NULL;
   const gchar *icon_name;
+  CachedPanel *cached;
+  gdouble elapsed;
 
   if (!id)
     return FALSE;
 
-  self->current_panel = GTK_WIDGET (cc_panel_loader_load_by_name (CC_SHELL (self), id, parameters));
-  cc_shell_set_active_panel (CC_SHELL (self), CC_PANEL (self->current_panel));
-  gtk_widget_show (self->current_panel);
+  stop_first_frame_timing (self);
+  self->panel_activation_time = g_get_monotonic_time ();
 
-  gtk_lock_button_set_permission (GTK_LOCK_BUTTON (self->lock_button),
-                                  cc_panel_get_permission (CC_PANEL (self->current_panel)));
+  cached = take_cached_panel (self, id);
+  self->panel_from_cache = (cached != NULL);
 
-  box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
+  if (cached)
+    {
+      guint i;
 
-  gtk_box_pack_start (GTK_BOX (box), self->current_panel,
-                      TRUE, TRUE, 0);
+      self->current_panel = GTK_WIDGET (cached->panel);
+      cc_shell_set_active_panel (CC_SHELL (self), cached->panel);
+
+      for (i = 0; i < cached->custom_widgets->len; i++)
+        _shell_embed_widget_in_header (CC_SHELL (self),
+                                       g_ptr_array_index (cached->custom_widgets, i));
+
+      g_object_set (G_OBJECT (self->current_panel), "parameters", parameters, NULL);
+      cc_panel_resume (cached->panel);
+
+      box = cached->box;
+    }
+  else
+    {
+      self->current_panel = GTK_WIDGET (cc_panel_loader_load_by_name (CC_SHELL (self), id, parameters));
+      cc_shell_set_active_panel (CC_SHELL (self), CC_PANEL (self->current_panel));
+      gtk_widget_show (self->current_panel);
+
+      elapsed = (g_get_monotonic_time () - self->panel_activation_time) / 1000.0;
+      g_log_structured (G_LOG_DOMAIN, G_LOG_LEVEL_DEBUG,
+                        "CC_PANEL_ID", "%s", id,
+                        "CC_PANEL_FROM_CACHE", "%d", FALSE,
+                        "CC_PANEL_CONSTRUCT_MS", "%.1f", elapsed,
+                        "MESSAGE", "Constructed panel '%s' in %.1f ms, not found in the cache",
+                        id, elapsed);
+
+      box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
+
+      gtk_box_pack_start (GTK_BOX (box), self->current_panel,
+                          TRUE, TRUE, 0);
+    }
+
+  self->first_frame_id = g_signal_connect_after (self->current_panel, "draw",
+                                                 G_CALLBACK (panel_first_frame_cb), self);
+
+  gtk_lock_button_set_permission (GTK_LOCK_BUTTON (self->lock_button),
+                                  cc_panel_get_permission (CC_PANEL (self->current_panel)));
 
   gtk_stack_add_named (GTK_STACK (self->stack), box, id);
 
+  if (cached)
+    {
+      /* the stack holds the box now, and the header the title widget */
+      g_object_unref (cached->box);
+      g_ptr_array_unref (cached->custom_widgets);
+      cached_title_widget = cached->title_widget;
+      g_free (cached->id);
+      g_slice_free (CachedPanel, cached);
+    }
+
   /* switch to the new panel */
   gtk_widget_show (box);
   gtk_stack_set_visible_child_name (GTK_STACK (self->stack), id);
@@ -180,6 +347,7 @@ activate_panel (CcWindow           *self,
 
   title_widget = cc_panel_get_title_widget (CC_PANEL (self->current_panel));
   gtk_header_bar_set_custom_title (GTK_HEADER_BAR (self->header), title_widget);
+  g_clear_object (&cached_title_widget);
 
   self->current_panel_box = box;
 
@@ -201,6 +369,38 @@ _shell_remove_all_custom_widgets (CcWindow *self)
   g_ptr_array_set_size (self->custom_widgets, 0);
 }
 
+/* Removes the custom widgets from the header, and returns them */
+static GPtrArray *
+steal_custom_widgets (CcWindow *self)
+{
+  GPtrArray *widgets;
+  guint i;
+
+  widgets = self->custom_widgets;
+  self->custom_widgets = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+
+  for (i = 0; i < widgets->len; i++)
+    gtk_container_remove (GTK_CONTAINER (self->top_right_box),
+                          g_ptr_array_index (widgets, i));
+
+  return widgets;
+}
+
+/* Removes the title widget of the panel from the header, and returns a
+ * reference to it */
+static GtkWidget *
+steal_title_widget (CcWindow *self)
+{
+  GtkWidget *widget;
+
+  widget = gtk_header_bar_get_custom_title (GTK_HEADER_BAR (self->header));
+  if (widget != NULL)
+    g_object_ref (widget);
+  gtk_header_bar_set_custom_title (GTK_HEADER_BAR (self->header), NULL);
+
+  return widget;
+}
+
 static void
 add_current_panel_to_history (CcShell    *shell,
                               const char *start_id)
@@ -225,7 +425,13 @@ shell_show_overview_page (CcWindow *self)
   gtk_stack_set_visible_child_name (GTK_STACK (self->stack), OVERVIEW_PAGE);
 
   if (self->current_panel_box)
-    gtk_container_remove (GTK_CONTAINER (self->stack), self->current_panel_box);
+    {
+      stop_first_frame_timing (self);
+      cache_panel (self, self->current_panel_id,
+                   self->current_panel_box, self->current_panel,
+                   steal_custom_widgets (self),
+                   steal_title_widget (self));
+    }
   self->current_panel = NULL;
   self->current_panel_box = NULL;
   g_clear_pointer (&self->current_panel_id, g_free);
@@ -974,7 +1180,9 @@ cc_window_set_active_panel_from_id (CcShell      *shell,
   gchar *name = NULL;
   GIcon *gicon = NULL;
   CcWindow *self = CC_WINDOW (shell);
-  GtkWidget *old_panel;
+  GtkWidget *old_panel, *old_panel_widget;
+  GPtrArray *old_custom_widgets = NULL;
+  GtkWidget *old_title_widget = NULL;
 
   /* When loading the same panel again, just set its parameters */
   if (g_strcmp0 (self->current_panel_id, start_id) == 0)
@@ -983,9 +1191,6 @@ cc_window_set_active_panel_from_id (CcShell      *shell,
       return TRUE;
     }
 
-  /* clear any custom widgets */
-  _shell_remove_all_custom_widgets (self);
-
   iter_valid = gtk_tree_model_get_iter_first (GTK_TREE_MODEL (self->store),
                                               &iter);
 
@@ -1022,6 +1227,14 @@ cc_window_set_active_panel_from_id (CcShell      *shell,
     }
 
   old_panel = self->current_panel_box;
+  old_panel_widget = self->current_panel;
+
+  /* take the custom widgets of the old panel out of the header */
+  if (name)
+    {
+      old_custom_widgets = steal_custom_widgets (self);
+      old_title_widget = steal_title_widget (self);
+    }
 
   if (!name)
     {
@@ -1032,17 +1245,22 @@ cc_window_set_active_panel_from_id (CcShell      *shell,
     {
       /* Failed to activate the panel for some reason,
        * let's keep the old panel around instead */
+      gtk_header_bar_set_custom_title (GTK_HEADER_BAR (self->header), old_title_widget);
     }
   else
     {
-      /* Successful activation */
+      /* Successful activation, keep the old panel for later */
+      if (old_panel)
+        cache_panel (self, self->current_panel_id, old_panel, old_panel_widget,
+                     g_steal_pointer (&old_custom_widgets),
+                     g_steal_pointer (&old_title_widget));
+
       g_free (self->current_panel_id);
       self->current_panel_id = g_strdup (start_id);
-
-      if (old_panel)
-        gtk_container_remove (GTK_CONTAINER (self->stack), old_panel);
     }
 
+  g_clear_pointer (&old_custom_widgets, g_ptr_array_unref);
+  g_clear_object (&old_title_widget);
   g_free (name);
   if (gicon)
     g_object_unref (gicon);
@@ -1161,6 +1379,12 @@ cc_window_dispose (GObject *object)
       self->previous_panels = NULL;
     }
 
+  if (self->panel_cache)
+    {
+      g_queue_free_full (self->panel_cache, (GDestroyNotify) cached_panel_free);
+      self->panel_cache = NULL;
+    }
+
   G_OBJECT_CLASS (cc_window_parent_class)->dispose (object);
 }
 
@@ -1572,6 +1796,7 @@ cc_window_init (CcWindow *self)
   create_window (self);
 
   self->previous_panels = g_queue_new ();
+  self->panel_cache = g_queue_new ();
 
   /* keep a list of custom widgets to unload on panel change */
   self->custom_widgets = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);